@@ -30,6 +30,9 @@
 #include "tycho-ipl/runtime/output_interface.h"
 #include "tycho-ipl/runtime/simple_runner.h"
 #include "tycho-ipl/runtime/experiment_runner.h"
+#include "tycho-ipl/runtime/codec_benchmark.h"
+#include "tycho-ipl/runtime/overhead_benchmark.h"
+#include "tycho-ipl/runtime/program_test.h"
 
 #if defined(_DEBUG) && defined(_WIN32)
 #define _CRTDBG_MAP_ALLOC
@@ -89,6 +92,39 @@ int main(int argc, char* argv[])
 		{
 			options.output_sphinx_function_docs(options.SphinxOutputDir);
 		}
+		else if (options.RunAction == session_options::action::BenchmarkOverhead)
+		{
+			overhead_benchmark(&output).run();
+			result = EXIT_SUCCESS;
+		}
+		else if (options.RunAction == session_options::action::BenchmarkCodecs)
+		{
+			try
+			{
+				result = codec_benchmark(options, &output).run() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+			catch (const std::exception& ex)
+			{
+				fprintf(stderr, "Error : %s\n", ex.what());
+				result = EXIT_FAILURE;
+			}
+		}
+		else if (options.RunAction == session_options::action::StressTest ||
+			options.RunAction == session_options::action::StripTest)
+		{
+			try
+			{
+				program_test test(options, &output);
+				const int failed = options.RunAction == session_options::action::StressTest ?
+					test.run_thread_stress() : test.run_strip_check();
+				result = failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+			catch (const std::exception& ex)
+			{
+				fprintf(stderr, "Error : %s\n", ex.what());
+				result = EXIT_FAILURE;
+			}
+		}
 		else
 		{
 			try
@@ -0,0 +1,17 @@
+# each pass blurs the result of the one before it, the block alternates 
+# between the same two buffers however many passes are run
+input int passes = 4;
+temp image blurred, smoothed;
+
+call copy(src = __src__, dst = blurred);
+repeat passes {
+    call gaussian_blur(src = blurred, dst = smoothed, kernel_size = 5);
+    call bilateral(src = smoothed, dst = blurred);
+}
+call edge_sobel(src = blurred, dst = __dst__, kernel_size = 3);
+
+# an empty count skips the block
+repeat 0 {
+    call gaussian_blur(src = blurred, dst = blurred, kernel_size = 3);
+}
+call experiment_add_image(src = blurred, name = "repeated");
@@ -0,0 +1,12 @@
+# every call reads nearby pixels, so each chain is run a strip of rows at a
+# time unless --strip_height=0
+temp image blurred, smoothed, clean, filtered, edges;
+
+call gaussian_blur(src = __src__, dst = blurred, kernel_size = 5);
+call kuwahara(src = blurred, dst = smoothed, kernel_size = 5);
+call denoise(src = smoothed, dst = clean, strength = 4);
+call edge_sobel(src = clean, dst = __dst__, kernel_size = 3);
+
+call bilateral(src = __src__, dst = filtered);
+call edge_laplacian(src = filtered, dst = edges, kernel_size = 3);
+call experiment_add_image(src = edges, name = "bilateral laplacian");
@@ -42,16 +42,35 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	image_ptr contact_sheet::make_thumbnail(const image& src)
+	{
+		image_ptr thumbnail(new image());
+		thumbnail->set_mat(cv::Mat(), src.get_format());
+		src.clamp_size(thumbnail.get(), ThumbnailSize, false, image::Interpolation::Cubic);
+
+		// the sheet is 3 channel, as if the image had been read back from disk
+		cv::Mat* mat = thumbnail->get_opencv();
+		if (mat->channels() == 1)
+		{
+			cv::Mat bgr;
+			cv::cvtColor(*mat, bgr, cv::COLOR_GRAY2BGR);
+			thumbnail->set_mat(bgr, image::Format::RGB);
+		}
+		return thumbnail;
+	}
+
+	//----------------------------------------------------------------------------
+
 	void contact_sheet::auto_build(
 		const std::string& /*title*/,
 		const result_matrix& results,
 		const std::string& output_path,
-		const runtime::session_options::file_list& input_files)
+		const image_ptr_list& originals)
 	{
 		bool draw_originals = true;
 		image_ptr_list thumbnails;
 
-		if (input_files.size() == 1)
+		if (originals.size() <= 1)
 			draw_originals = false;
 
 		if (results.get_num_nodes() == 0 )
@@ -77,8 +96,12 @@ namespace image_processing
 					IMAGE_PROC_ASSERT(img_list->get_type() == node_base::Type::FileList);
 					IMAGE_PROC_ASSERT(img_list->get_entries().size() == 1);
 
-					image_ptr img(new image(img_list->get_entries()[0].Path));
-					img->clamp_size(ImageSize, false, image::Interpolation::Cubic);
+					image_ptr img = img_list->get_thumbnail();
+					if (!img)
+					{
+						img.reset(new image(img_list->get_entries()[0].Path));
+						img->clamp_size(ThumbnailSize, false, image::Interpolation::Cubic);
+					}
 
 					thumbnails.push_back(img);
 					img_list->set_user_data(img.get());
@@ -146,12 +169,16 @@ namespace image_processing
 
 				if (draw_originals)
 				{
-					image_ptr orig(new image(input_files[y]));
-
-					if (max_image_width > max_image_height)
-						orig->clamp_size(max_image_width, false, image::Interpolation::Cubic);
-					else
-						orig->clamp_size(max_image_height, false, image::Interpolation::Cubic);
+					// the originals are already at most ThumbnailSize, they only
+					// need scaling if every result is smaller than that
+					image_ptr orig = originals[y];
+					const int max_size = std::max(max_image_width, max_image_height);
+					if (std::max(orig->get_width(), orig->get_height()) > max_size)
+					{
+						orig.reset(new image());
+						orig->set_mat(cv::Mat(), originals[y]->get_format());
+						originals[y]->clamp_size(orig.get(), max_size, false, image::Interpolation::Cubic);
+					}
 
 					int cx_off = (max_image_width - orig->get_width()) / 2;
 					int cy_off = (max_image_height - orig->get_height()) / 2;
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "image_processing_abi.h"
-#include "runtime/session_options.h"
+#include "image.h"
 #include <string>
 #include <list>
 
@@ -62,17 +62,26 @@ namespace image_processing
 			Landscape
 		};
 
+	public:
+		/// Longest edge of the images in each cell of the sheet
+		static const int ThumbnailSize = 512;
+
 	public:
 		/// Default constructor
 		contact_sheet() = default; 		
 
+		/// Scale an image down to the size it's drawn at in the sheet
+		static image_ptr make_thumbnail(const image& src);
+
 		/// Automatically construct the contact sheets from the given results
-		/// matrix.
+		/// matrix. Cells are drawn from the thumbnails of the result nodes, 
+		/// results without one are read back from disk. originals holds the
+		/// thumbnail of the input image of each row.
 		void auto_build(
 			const std::string& title, 
 			const result_matrix& results, 
 			const std::string& output_path,
-			const runtime::session_options::file_list& input_files);
+			const image_ptr_list& originals);
 
 		/// Adds a page to the contact sheet
 		void add_page(const std::string& title, const result_matrix& results);
@@ -92,7 +101,6 @@ namespace image_processing
 			std::string Contents;
 		};
 
-		size_t ImageSize = 512;
 		size_t ImageBorder = 5;
 		size_t ImageTopBorder = 80;
 		size_t InfoRectHeight = 20;
@@ -31,8 +31,22 @@
 #include "program.h"
 #include "function.h"
 #include "image.h"
+#include "image_pool.h"
+#include "native_program.h"
+#include "pixel_kernel.h"
+#include "prefix_cache.h"
+#include "result_cache.h"
+#include "thread_pool.h"
 #include "exception.h"
+#include "functions/common.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <thread>
 
 //----------------------------------------------------------------------------
 // Class
@@ -45,11 +59,56 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
-	context::context(const program* p, execution_interface* i) :
+	context::context(const program* p, execution_interface* i, image_pool* pool, thread_pool* threads) :
 		m_Interface(i),
-		m_Program(p)
+		m_Program(p),
+		m_Pool(pool),
+		m_Threads(threads)
 	{
+		// build the arguments for each statement once with all the compile time
+		// constants bound, only slot arguments change per execution.
+		m_Arguments.resize(p->m_Statements.size());
+		m_Results.resize(p->m_Statements.size());
+		m_Cacheable.resize(p->m_Statements.size());
+		m_CheckOnRead.resize(p->m_Statements.size());
 
+		// slots written by statements are validated as they are read, the 
+		// others hold the same value for the whole run and are validated once
+		std::vector<char> written(p->num_slots(), 0);
+		for (auto& stmt : p->m_Statements)
+		{
+			for (int slot : stmt.Outputs)
+			{
+				if (slot >= 0)
+					written[slot] = 1;
+			}
+		}
+
+		for (size_t s = 0; s < p->m_Statements.size(); ++s)
+		{
+			const statement& stmt = p->m_Statements[s];
+			auto& params = stmt.Func->get_inputs();
+			m_Arguments[s].resize(params.size());
+			m_Results[s].resize(stmt.Func->get_outputs().size());
+			m_CheckOnRead[s].resize(params.size());
+			for (size_t i = 0; i < params.size(); ++i)
+			{
+				if (stmt.Inputs[i].is_constant())
+					m_Arguments[s][i] = stmt.Inputs[i].Constant;
+				else
+					m_CheckOnRead[s][i] = written[stmt.Inputs[i].Slot];
+			}
+
+			// only image results are written to the result cache
+			auto& out_params = stmt.Func->get_outputs();
+			bool cacheable = !stmt.Func->has_side_effects() && !out_params.empty() && stmt.RepeatHead < 0;
+			for (size_t i = 0; i < out_params.size(); ++i)
+			{
+				if (stmt.Outputs[i] < 0 || out_params[i].Type != ObjectType::Image)
+					cacheable = false;
+			}
+			m_Cacheable[s] = cacheable;
+		}
 	}
 
 	//----------------------------------------------------------------------------
@@ -62,16 +121,27 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
-	bool context::execute(image* src, image*& dst, const kv_dict& cinputs)
+	void context::set_register(int slot, const value& val)
+	{
+		m_Registers[slot] = val;
+		m_Defined[slot] = true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::reset_registers(image* src, const kv_dict& cinputs)
 	{
+		m_Registers.assign(m_Program->num_slots(), value());
+		m_Defined.assign(m_Program->num_slots(), false);
+
 		// set program constants
-		for (auto c : m_Program->m_Constants)
+		for (auto& c : m_Program->m_Constants)
 		{
-			m_SymbolTable.set(c.Name, c.Value);
+			set_register(c.get_slot(), c.Value);
 		}
 
 		// set program inputs
-		for (auto c : m_Program->m_Inputs)
+		for (auto& c : m_Program->m_Inputs)
 		{
 			// check to see if this input default has been overridden
 			value val;
@@ -79,108 +149,1476 @@ namespace image_processing
 			{
 				val = c.Value;
 			}
-			else
-			{ 
-				if (val.get_type() == ObjectType::Name)
-				{
-					auto name = val.get_name();
-					if (m_SymbolTable.exists(name))
-					{
-						m_SymbolTable.try_get(name, val);
-					}
-				}
+			else if (val.get_type() == ObjectType::Name)
+			{
+				int slot = m_Program->get_slot(val.get_name());
+				if (slot >= 0 && m_Defined[slot])
+					val = m_Registers[slot];
 			}
-			m_SymbolTable.set(c.Name, val);
+			set_register(c.get_slot(), val);
 		}
 
 		// set global constants
-		m_SymbolTable.set("__src__", value::make_image(src));
-		m_SymbolTable.set("__width__", value::make_integer(src->get_width()));
-		m_SymbolTable.set("__height__", value::make_integer(src->get_height()));
+		set_register(m_Program->m_SrcSlot, value::make_image(src));
+		set_register(m_Program->m_WidthSlot, value::make_integer(src->get_width()));
+		set_register(m_Program->m_HeightSlot, value::make_integer(src->get_height()));
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::is_shared(int slot, const image* img) const
+	{
+		for (size_t i = 0; i < m_Registers.size(); ++i)
+		{
+			if (static_cast<int>(i) != slot && m_Defined[i] &&
+				m_Registers[i].get_type() == ObjectType::Image &&
+				m_Registers[i].get_image() == img)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::store_outputs(size_t s)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+
+		std::vector<value> outputs;
+		for (int slot : stmt.Outputs)
+		{
+			value& val = m_Registers[slot];
+			outputs.push_back(val);
+
+			// the cache owns the images from now on so they are never released
+			// or written over by this context
+			if (val.get_type() == ObjectType::Image && m_Allocated.erase(val.get_image()))
+				m_Cache->take_ownership(val.get_image());
+		}
+		m_Cache->store(s, outputs);
+	}
+
+	//----------------------------------------------------------------------------
+
+	static uint64_t get_result_key(const statement& stmt, const std::vector<uint64_t>& slot_keys)
+	{
+		// results computed by a different library or version are never used
+		static const uint64_t seed = result_cache::combine(program::get_library_hash(), result_cache::ResultVersion);
+
+		const char* name = stmt.Func->get_name();
+		uint64_t key = result_cache::hash(name, strlen(name), seed);
+		for (auto& op : stmt.Inputs)
+		{
+			if (op.is_constant())
+				key = result_cache::combine(key, result_cache::hash(op.Constant));
+			else
+				key = result_cache::combine(key, slot_keys[op.Slot]);
+		}
+		return key;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::plan_cached()
+	{
+		auto& statements = m_Program->m_Statements;
+
+		// a result's key is built from the function, its constant arguments and
+		// the keys of the slots it reads, which for the source image and inputs
+		// are hashes of their values. The source is the only large image so 
+		// its key is taken from the caller if it has already been computed.
+		std::vector<uint64_t> slot_keys(m_Registers.size(), 0);
+		for (size_t i = 0; i < m_Registers.size(); ++i)
+		{
+			if (!m_Defined[i])
+				continue;
+
+			if (static_cast<int>(i) == m_Program->m_SrcSlot)
+				slot_keys[i] = m_SourceKey ? m_SourceKey : result_cache::hash(m_Registers[i].get_image());
+			else
+				slot_keys[i] = result_cache::hash(m_Registers[i]);
+		}
+
+		m_Keys.assign(statements.size(), std::vector<uint64_t>());
+		uint64_t repeat_key = 0;
+		for (size_t s = 0; s < statements.size(); ++s)
+		{
+			const statement& stmt = statements[s];
+
+			// the results of a repeat block depend on the number of times it 
+			// runs and everything its statements read as it starts
+			if (stmt.RepeatHead == static_cast<int>(s))
+			{
+				const operand& count = stmt.RepeatCount;
+				repeat_key = count.is_constant() ? result_cache::hash(count.Constant) : slot_keys[count.Slot];
+				for (size_t f = s; f <= s + stmt.RepeatStatements; ++f)
+					repeat_key = result_cache::combine(repeat_key, get_result_key(statements[f], slot_keys));
+			}
+
+			uint64_t key;
+			if (stmt.RepeatHead >= 0)
+				key = result_cache::combine(repeat_key, s);
+			else
+				key = get_result_key(stmt, slot_keys);
+
+			for (size_t i = 0; i < stmt.Outputs.size(); ++i)
+			{
+				uint64_t out_key = result_cache::combine(key, i);
+				m_Keys[s].push_back(out_key);
+				if (stmt.Outputs[i] >= 0)
+					slot_keys[stmt.Outputs[i]] = out_key;
+			}
+		}
 
-		// execute each statement in the program
-		for (auto stmt : m_Program->m_Statements)
+		// walk backwards from the program outputs, a needed statement whose 
+		// results are all stored is loaded and whatever computed its inputs
+		// doesn't have to run.
+		std::vector<bool> live(m_Registers.size(), false);
+		for (auto& decl : m_Program->m_Outputs)
+			live[decl.get_slot()] = true;
+
+		m_Plan.assign(statements.size(), Plan::Skip);
+		for (size_t s = statements.size(); s-- > 0; )
 		{
-			// resolve arguments
-			kv_dict inputs, outputs;
-			for (auto p : stmt.Func->get_inputs())
+			const statement& stmt = statements[s];
+
+			// a repeat block is run as a whole or not at all, it may not run so
+			// anything it writes is still live before it
+			if (stmt.RepeatHead >= 0)
 			{
-				value val;
-				if (stmt.Arguments.try_get(p.Name, val))
+				const size_t head = stmt.RepeatHead;
+				bool needed = false;
+				for (size_t f = head; f <= s; ++f)
 				{
-					if (val.get_type() == ObjectType::Name)
+					needed |= statements[f].Func->has_side_effects() || statements[f].Outputs.empty();
+					for (int slot : statements[f].Outputs)
+						needed |= slot >= 0 && live[slot];
+				}
+
+				if (needed)
+				{
+					for (size_t f = head; f <= s; ++f)
 					{
-						value ref;
-						if (m_SymbolTable.try_get(val.get_name(), ref))
-						{
-							// parameter validation
-							if (!p.ValidationFunction(ref))
-							{
-								throw invalid_parameter(stmt.Func, p, ref);
-							}
-							inputs.set(p.Name, ref);
-						}
-						else
+						m_Plan[f] = Plan::Run;
+						for (auto& op : statements[f].Inputs)
 						{
-							throw symbol_not_found(val.get_name());
+							if (!op.is_constant())
+								live[op.Slot] = true;
 						}
 					}
-					else
-					{
-						inputs.set(p.Name, val);
-					}
+
+					if (!statements[head].RepeatCount.is_constant())
+						live[statements[head].RepeatCount.Slot] = true;
 				}
-				else
+				s = head;
+				continue;
+			}
+
+			// already run for an earlier variation
+			if (m_Cache && m_Cache->is_filled() && m_Cache->is_invariant(s))
+			{
+				m_Plan[s] = Plan::Run;
+				continue;
+			}
+
+			bool needed = stmt.Func->has_side_effects() || stmt.Outputs.empty() ||
+				(m_Cache && m_Cache->is_stored(s));
+			for (int slot : stmt.Outputs)
+			{
+				if (slot >= 0 && live[slot])
+					needed = true;
+			}
+
+			if (!needed)
+				continue;
+
+			for (int slot : stmt.Outputs)
+			{
+				if (slot >= 0)
+					live[slot] = false;
+			}
+
+			bool stored = m_Cacheable[s] != 0;
+			for (uint64_t key : m_Keys[s])
+				stored = stored && m_ResultCache->contains(key);
+
+			if (stored)
+			{
+				m_Plan[s] = Plan::Load;
+				continue;
+			}
+
+			m_Plan[s] = Plan::Run;
+			for (auto& op : stmt.Inputs)
+			{
+				if (!op.is_constant())
+					live[op.Slot] = true;
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::load_cached()
+	{
+		m_Loaded.assign(m_Program->m_Statements.size(), std::vector<image*>());
+		for (size_t s = 0; s < m_Plan.size(); ++s)
+		{
+			if (m_Plan[s] != Plan::Load)
+				continue;
+
+			for (uint64_t key : m_Keys[s])
+			{
+				image* img = m_ResultCache->load(key, m_Pool);
+				if (!img)
+					return false;
+
+				m_Loaded[s].push_back(img);
+				m_Allocated.insert(img);
+			}
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	static double seconds_since(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::checkpoint(size_t first, size_t last, double seconds, const std::vector<image*>& images)
+	{
+		auto& statements = m_Program->m_Statements;
+		const statement& stmt = statements[last];
+
+		// the cost of a result is the time it takes to compute again from the 
+		// stored results, which includes computing any inputs that weren't 
+		// stored. Inputs written within a group are never created.
+		double cost = seconds;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (size_t f = first; f <= last; ++f)
+			{
+				for (auto& op : statements[f].Inputs)
 				{
-					// use default value
-					inputs.set(p.Name, p.DefaultVal);
+					if (op.is_constant())
+						continue;
+
+					bool internal = false;
+					for (size_t g = first; g < f && !internal; ++g)
+						internal = std::find(statements[g].Outputs.begin(), statements[g].Outputs.end(), op.Slot) != statements[g].Outputs.end();
+					if (!internal)
+						cost += m_Cost[op.Slot];
 				}
 			}
+		}
+
+		size_t bytes = 0;
+		for (const image* img : images)
+			bytes += img->get_opencv()->total() * img->get_opencv()->elemSize();
+
+		const bool stored = m_Cacheable[last] && images.size() == stmt.Outputs.size() &&
+			m_ResultCache->is_worth_storing(bytes, cost);
+		if (stored)
+		{
+			for (size_t i = 0; i < images.size(); ++i)
+				m_ResultCache->store(m_Keys[last][i], images[i]);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (int slot : stmt.Outputs)
+		{
+			if (slot >= 0)
+				m_Cost[slot] = stored ? 0.0 : cost;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::preallocate(const image* src)
+	{
+		const image_shape src_shape(src->get_format(), src->get_width(), src->get_height());
+		if (!m_Pool || src_shape == m_Preallocated)
+			return;
+		m_Preallocated = src_shape;
 
-			stmt.Func->dispatch(this, inputs, outputs);
+		// follow the images in each slot through a run to find how many of each
+		// shape the pool hands out at once. Fused and strip groups are run as
+		// one statement writing the result of their last.
+		auto& statements = m_Program->m_Statements;
+		std::vector<image_shape> slots(m_Program->num_slots());
+		std::vector<char> pooled(m_Program->num_slots(), 0);
+		slots[m_Program->m_SrcSlot] = src_shape;
+		std::map<image_shape, int> available;
+		std::map<image_shape, int> needed;
+		for (size_t s = 0; s < statements.size(); ++s)
+		{
+			const statement& stmt = statements[s];
+			const size_t last = s + std::max(stmt.FusedStatements, stmt.StripStatements);
+			const int out_slot = statements[last].Outputs.empty() ? -1 : statements[last].Outputs[0];
+			const bool grouped = stmt.FusedHead >= 0 || stmt.StripHead >= 0;
 
-			for (auto p : stmt.Func->get_outputs())
+			if (!grouped && out_slot >= 0)
 			{
-				value dst_arg;
-				if (stmt.Arguments.try_get(p.Name, dst_arg))
-				{
-					value res;
-					if (outputs.try_get(p.Name, res))
-					{
-						m_SymbolTable.set(dst_arg.get_name(), res);
+				const bool has_source = !stmt.Inputs.empty() && !stmt.Inputs[0].is_constant() &&
+					stmt.Func->get_inputs()[0].Type == ObjectType::Image;
+				const int in_slot = has_source ? stmt.Inputs[0].Slot : -1;
 
-						// track allocated images so we can clean up at the end
-						if (res.get_type() == ObjectType::Image)
-						{
-							image* new_img = res.get_image();
-							if (m_Allocated.find(new_img) == m_Allocated.end())
-								m_Allocated.insert(new_img);
-						}
-					}
+				// written over its source if it dies here and the result has the
+				// same layout, otherwise allocated from the pool
+				const bool converts = has_source && m_Shapes[last].HasFormat && 
+					slots[in_slot].Format != m_Shapes[last].Format;
+				bool in_place = has_source && stmt.ReuseSource && pooled[in_slot] && !converts;
+				if (stmt.FusedStatements == 0)
+					in_place = in_place && stmt.StripStatements == 0 && stmt.Func->get_destination() == function::Destination::InPlace;
+
+				if (in_place)
+				{
+					pooled[in_slot] = 0;
+				}
+				else if (has_source && slots[in_slot].HasFormat && slots[in_slot].has_size())
+				{
+					// statements that change the format are given an image of their
+					// result's shape, the same as groups
+					const image_shape& like = last != s || converts ? m_Shapes[last] : slots[in_slot];
+					if (available[like] > 0)
+						--available[like];
 					else
-						return false;
+						++needed[like];
 				}
-				else
-					return false;
+
+				slots[out_slot] = m_Shapes[last];
+				pooled[out_slot] = 1;
+			}
+
+			// dead images go back to the pool
+			for (auto& op : stmt.Inputs)
+			{
+				if (op.is_constant() || !op.LastUse || !pooled[op.Slot] || 
+					std::find(stmt.Outputs.begin(), stmt.Outputs.end(), op.Slot) != stmt.Outputs.end())
+				{
+					continue;
+				}
+
+				pooled[op.Slot] = 0;
+				if (slots[op.Slot].HasFormat && slots[op.Slot].has_size())
+					++available[slots[op.Slot]];
 			}
 		}
 
+		for (auto& n : needed)
+			m_Pool->reserve(n.first.Width, n.first.Height, n.first.get_type(), n.first.Format, n.second);
+	}
 
-		value dst_val;
-		dst = nullptr;
-		if (m_SymbolTable.try_get("__dst__", dst_val) && dst_val.get_type() == ObjectType::Image)
+	//----------------------------------------------------------------------------
+
+	void context::release_image(image* img)
+	{
+		m_Allocated.erase(img);
+
+		// kept for the next iteration of the repeat block that's running, the
+		// oldest are released if they aren't being reused
+		if (m_MaxSpares > 0)
 		{
-			dst = dst_val.get_image();
+			m_Spares.push_back(img);
+			if (m_Spares.size() <= m_MaxSpares)
+				return;
+
+			img = m_Spares.front();
+			m_Spares.erase(m_Spares.begin());
 		}
 
-		// clean up
+		if (m_Pool)
+			m_Pool->release(img);
+		else
+			delete img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::free_allocated(const image* keep)
+	{
 		for (auto img : m_Allocated)
 		{
-			if (img != dst)
+			if (img == keep)
+				continue;
+
+			if (m_Pool)
+				m_Pool->release(img);
+			else
 				delete img;
 		}
 		m_Allocated.clear();
+		end_repeat();
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* context::provide_destination(const statement& stmt)
+	{
+		// only functions that map a source image to a destination image
+		auto& in_params = stmt.Func->get_inputs();
+		auto& out_params = stmt.Func->get_outputs();
+		if (in_params.empty() || out_params.empty() ||
+			in_params[0].Type != ObjectType::Image ||
+			out_params[0].Type != ObjectType::Image)
+		{
+			return nullptr;
+		}
+
+		const operand& op = stmt.Inputs[0];
+		if (op.is_constant() || m_Registers[op.Slot].get_type() != ObjectType::Image)
+			return nullptr;
+
+		image* src = m_Registers[op.Slot].get_image();
+		image* dst = nullptr;
+		const auto mode = stmt.Func->get_destination();
+		const image::Format format = stmt.Func->get_output_format();
+
+		// if the source image dies here let the function write straight over it
+		// instead of copying it first.
+		if (format != image::Format::Count && format != src->get_format())
+		{
+			// the result has a different layout so neither the source nor a 
+			// copy of it is any use, an image of the result's shape is used
+			const image_shape shape(format, src->get_width(), src->get_height());
+			if (image* spare = take_spare(shape.Width, shape.Height, shape.get_type(), format))
+				dst = spare;
+			else if (m_Pool)
+				dst = m_Pool->acquire(shape.Width, shape.Height, shape.get_type(), format);
+			if (dst)
+				m_Allocated.insert(dst);
+		}
+		else if (mode == function::Destination::InPlace && stmt.ReuseSource &&
+			m_Allocated.count(src) && !is_shared(op.Slot, src))
+		{
+			dst = src;
+		}
+		else if (image* spare = take_spare(src->get_width(), src->get_height(), src->get_opencv()->type(), src->get_format()))
+		{
+			if (mode != function::Destination::Uninitialised)
+				src->get_opencv()->copyTo(*spare->get_opencv());
+			dst = spare;
+			m_Allocated.insert(dst);
+		}
+		else if (m_Pool)
+		{
+			if (mode == function::Destination::Uninitialised)
+				dst = m_Pool->acquire_like(src);
+			else
+				dst = m_Pool->acquire_copy(src);
+			m_Allocated.insert(dst);
+		}
+
+		return dst;
+	}
+
+	//----------------------------------------------------------------------------
+
+	const value& context::check_input(size_t s, size_t i) const
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+		const operand& op = stmt.Inputs[i];
+		if (!m_Defined[op.Slot])
+			throw symbol_not_found(m_Program->get_slot_declaration(op.Slot).Name.c_str());
+
+		// parameter validation, unless it was done when execution started
+		const value& ref = m_Registers[op.Slot];
+		if (m_CheckOnRead[s][i])
+		{
+			const param_desc& param = stmt.Func->get_inputs()[i];
+			if (!param.ValidationFunction(ref))
+				throw invalid_parameter(stmt.Func, param, ref);
+		}
+		return ref;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::validate_inputs() const
+	{
+		for (size_t s = 0; s < m_Program->m_Statements.size(); ++s)
+		{
+			const statement& stmt = m_Program->m_Statements[s];
+			auto& params = stmt.Func->get_inputs();
+			for (size_t i = 0; i < params.size(); ++i)
+			{
+				const operand& op = stmt.Inputs[i];
+				if (op.is_constant() || m_CheckOnRead[s][i] || !m_Defined[op.Slot])
+					continue;
+
+				if (!params[i].ValidationFunction(m_Registers[op.Slot]))
+					throw invalid_parameter(stmt.Func, params[i], m_Registers[op.Slot]);
+			}
+
+			// repeat counts read from inputs
+			const operand& count = stmt.RepeatCount;
+			if (stmt.RepeatHead == static_cast<int>(s) && !count.is_constant() && m_Defined[count.Slot] &&
+				m_Program->get_slot_declaration(count.Slot).Modifier == declaration::TypeModifier::Input)
+			{
+				get_repeat_count(s);
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::bind_inputs(size_t s, size_t first)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+
+		// resolve slot arguments, constants were bound when the context was created
+		std::vector<value>& inputs = m_Arguments[s];
+		for (size_t i = first; i < inputs.size(); ++i)
+		{
+			if (!stmt.Inputs[i].is_constant())
+				inputs[i] = check_input(s, i);
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	kv_dict context::get_arguments(size_t s) const
+	{
+		// named arguments for the function methods that take them
+		kv_dict args;
+		auto& params = m_Program->m_Statements[s].Func->get_inputs();
+		for (size_t i = 0; i < params.size(); ++i)
+		{
+			if (m_Arguments[s][i].is_valid())
+				args.set(params[i].Name, m_Arguments[s][i]);
+		}
+		return args;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::begin_statement(size_t s, image*& provided)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+		bind_inputs(s, 0);
+		provided = provide_destination(stmt);
+
+		std::vector<value>& outputs = m_Results[s];
+		std::fill(outputs.begin(), outputs.end(), value());
+		if (provided)
+			outputs[0].set_image(provided);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::end_statement(size_t s, image* provided)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+
+		std::vector<value>& outputs = m_Results[s];
+		for (size_t i = 0; i < outputs.size(); ++i)
+		{
+			value& res = outputs[i];
+			if (stmt.Outputs[i] < 0 || !res.is_valid())
+				return false;
+
+			image* overwritten = get_overwritten(s, stmt.Outputs[i]);
+			set_register(stmt.Outputs[i], res);
+
+			// track allocated images so we can clean up at the end
+			if (res.get_type() == ObjectType::Image)
+				m_Allocated.insert(res.get_image());
+			release_overwritten(overwritten, res.get_type() == ObjectType::Image ? res.get_image() : nullptr);
+		}
+
+		finish_statement(s, provided);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
 
+	void context::finish_statement(size_t s, image* provided)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+
+		if (m_Cache && !m_Cache->is_filled() && m_Cache->is_stored(s))
+			store_outputs(s);
+
+		// the function may have chosen not to use the image it was given
+		if (provided && !is_shared(-1, provided))
+			release_image(provided);
+
+		// dead slots are released so their images can be reused by later statements
+		for (auto& op : stmt.Inputs)
+		{
+			if (op.is_constant() || !op.LastUse || !m_Defined[op.Slot])
+				continue;
+
+			if (std::find(stmt.Outputs.begin(), stmt.Outputs.end(), op.Slot) != stmt.Outputs.end())
+				continue;
+
+			m_Defined[op.Slot] = false;
+			value& val = m_Registers[op.Slot];
+			if (val.get_type() == ObjectType::Image &&
+				m_Allocated.count(val.get_image()) &&
+				!is_shared(-1, val.get_image()))
+			{
+				release_image(val.get_image());
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_fused(size_t s)
+	{
+		auto& statements = m_Program->m_Statements;
+		const statement& head = statements[s];
+		const size_t last = s + head.FusedStatements;
+
+		if (!can_run_group(s, last))
+			return false;
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<pixel_kernel> kernels;
+		std::array<uint8_t, 256> lut;
+		bool use_lut = false;
+		image* src = nullptr;
+		image* dst = nullptr;
+		int max_channels = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// the intermediate images are never created so only the first 
+			// statement binds its source
+			for (size_t f = s; f <= last; ++f)
+				bind_inputs(f, f == s ? 0 : 1);
+
+			value& in = m_Registers[head.Inputs[0].Slot];
+			if (in.get_type() != ObjectType::Image)
+				return false;
+
+			src = in.get_image();
+			const cv::Mat& src_mat = *src->get_opencv();
+			if (src_mat.depth() != CV_8U)
+				return false;
+
+			image::Format format = src->get_format();
+			int channels = src_mat.channels();
+			max_channels = channels;
+
+			// a run of table lookups on the kind of image they expect folds to a
+			// single table, this was done at compile time unless some of the 
+			// arguments are program inputs
+			if (head.LutChannels == channels)
+			{
+				if (!head.Lut.empty())
+				{
+					std::copy(head.Lut.begin(), head.Lut.end(), lut.begin());
+					use_lut = true;
+				}
+				else
+				{
+					std::vector<kv_dict> args;
+					for (size_t f = s; f <= last; ++f)
+						args.push_back(get_arguments(f));
+					use_lut = m_Program->fold_lut(s, args.data(), lut);
+				}
+			}
+
+			// otherwise chain the kernels, if any of them can't handle the pixel 
+			// layout it's given the statements run individually as normal
+			for (size_t f = s; f <= last && !use_lut; ++f)
+			{
+				pixel_kernel kernel;
+				kernel.InFormat = format;
+				kernel.InChannels = channels;
+				if (!statements[f].Func->get_pixel_kernel(get_arguments(f), kernel))
+					return false;
+
+				format = kernel.OutFormat;
+				channels = kernel.OutChannels;
+				max_channels = std::max(max_channels, channels);
+				kernels.push_back(std::move(kernel));
+			}
+
+			// write over the source if it dies here and the result has the same layout
+			const int width = src->get_width();
+			const int height = src->get_height();
+			if (head.ReuseSource && m_Allocated.count(src) && !is_shared(head.Inputs[0].Slot, src) &&
+				channels == src_mat.channels() && format == src->get_format())
+			{
+				dst = src;
+			}
+			else if (image* spare = take_spare(width, height, CV_8UC(channels), format))
+			{
+				dst = spare;
+			}
+			else if (m_Pool)
+			{
+				dst = m_Pool->acquire(width, height, CV_8UC(channels), format);
+			}
+			else
+			{
+				dst = new image();
+				dst->set_mat(cv::Mat(height, width, CV_8UC(channels)), format);
+			}
+		}
+
+		// one read of the source and one write of the destination
+		const cv::Mat& src_mat = *src->get_opencv();
+		cv::Mat& dst_mat = *dst->get_opencv();
+		if (use_lut)
+		{
+			cv::LUT(src_mat, cv::Mat(1, 256, CV_8U, lut.data()), dst_mat);
+		}
+		else
+		{
+			// the intermediate rows live in scratch buffers
+			const int width = src_mat.cols;
+			std::vector<uint8_t> scratch[2];
+			scratch[0].resize(width * max_channels);
+			scratch[1].resize(width * max_channels);
+
+			for (int y = 0; y < src_mat.rows; ++y)
+			{
+				const uint8_t* row_in = src_mat.ptr<uint8_t>(y);
+				for (size_t k = 0; k < kernels.size(); ++k)
+				{
+					uint8_t* row_out = k + 1 == kernels.size() ? dst_mat.ptr<uint8_t>(y) : scratch[k & 1].data();
+					kernels[k].Row(row_in, row_out, width);
+					row_in = row_out;
+				}
+			}
+		}
+
+		end_group(s, last, dst, start);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::can_run_group(size_t s, size_t last) const
+	{
+		// results the cache is waiting on have to be kept
+		if (m_Cache && !m_Cache->is_filled())
+		{
+			for (size_t f = s; f < last; ++f)
+			{
+				if (m_Cache->is_stored(f))
+					return false;
+			}
+		}
+
+		// some of the results were loaded from the result cache
+		if (m_ResultCache)
+		{
+			for (size_t f = s; f <= last; ++f)
+			{
+				if (m_Plan[f] != Plan::Run)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::end_group(size_t s, size_t last, image* dst, std::chrono::steady_clock::time_point start)
+	{
+		auto& statements = m_Program->m_Statements;
+
+		// the intermediate results never exist so only the last one is stored
+		if (m_ResultCache)
+			checkpoint(s, last, seconds_since(start), { dst });
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Allocated.insert(dst);
+
+		// undefine everything that died in the group before setting the result
+		// as it may be written to one of those slots
+		std::vector<image*> dead;
+		for (size_t f = s; f <= last; ++f)
+		{
+			for (auto& op : statements[f].Inputs)
+			{
+				if (op.is_constant() || !op.LastUse || !m_Defined[op.Slot])
+					continue;
+
+				m_Defined[op.Slot] = false;
+				value& val = m_Registers[op.Slot];
+				if (val.get_type() == ObjectType::Image && val.get_image() != dst &&
+					std::find(dead.begin(), dead.end(), val.get_image()) == dead.end())
+				{
+					dead.push_back(val.get_image());
+				}
+			}
+		}
+
+		image* overwritten = get_overwritten(last, statements[last].Outputs[0]);
+		set_register(statements[last].Outputs[0], value::make_image(dst));
+		if (m_Cache && !m_Cache->is_filled() && m_Cache->is_stored(last))
+			store_outputs(last);
+
+		for (image* img : dead)
+		{
+			if (m_Allocated.count(img) && !is_shared(-1, img))
+				release_image(img);
+		}
+		if (std::find(dead.begin(), dead.end(), overwritten) == dead.end())
+			release_overwritten(overwritten, dst);
+
+		for (size_t f = s; f <= last; ++f)
+			m_FusedRun[f] = 1;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* context::acquire_rows(const image* like, int rows)
+	{
+		const cv::Mat& mat = *like->get_opencv();
+		if (image* spare = take_spare(mat.cols, rows, mat.type(), like->get_format()))
+			return spare;
+		if (m_Pool)
+			return m_Pool->acquire(mat.cols, rows, mat.type(), like->get_format());
+
+		image* img = new image();
+		img->set_mat(cv::Mat(rows, mat.cols, mat.type()), like->get_format());
+		return img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::discard_image(image* img)
+	{
+		if (m_Pool)
+			m_Pool->release(img);
+		else
+			delete img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_strips(size_t s)
+	{
+		auto& statements = m_Program->m_Statements;
+		const statement& head = statements[s];
+		const size_t last = s + head.StripStatements;
+
+		if (m_StripHeight <= 0 || !can_run_group(s, last))
+			return false;
+
+		const auto start = std::chrono::steady_clock::now();
+		std::vector<std::vector<value>> arguments;
+		image* src = nullptr;
+		int halo = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			for (size_t f = s; f <= last; ++f)
+				bind_inputs(f, f == s ? 0 : 1);
+
+			value& in = m_Registers[head.Inputs[0].Slot];
+			if (in.get_type() != ObjectType::Image)
+				return false;
+
+			src = in.get_image();
+			if (src->get_height() <= m_StripHeight)
+				return false;
+
+			// each statement needs its source to extend past the rows it 
+			// writes by its radius, so the strips read by the first statement
+			// overlap by the sum of them.
+			for (size_t f = s; f <= last; ++f)
+			{
+				const int radius = statements[f].Func->get_halo(get_arguments(f));
+				if (radius < 0)
+					return false;
+				halo += radius;
+
+				// other images would have to be split into strips as well
+				auto& args = m_Arguments[f];
+				for (size_t i = 1; i < args.size(); ++i)
+				{
+					if (args[i].get_type() == ObjectType::Image)
+						return false;
+				}
+				arguments.push_back(args);
+			}
+		}
+
+		const cv::Mat& src_mat = *src->get_opencv();
+		const int height = src_mat.rows;
+		image* dst = nullptr;
+		image* window = nullptr;
+
+		// the strip is abandoned and the statements run on whole images if a
+		// function doesn't behave as its footprint says
+		auto fail = [&]()
+		{
+			if (window)
+				discard_image(window);
+			if (dst)
+				discard_image(dst);
+			return false;
+		};
+
+		try
+		{
+			for (int y0 = 0; y0 < height; y0 += m_StripHeight)
+			{
+				const int y1 = std::min(height, y0 + m_StripHeight);
+				const int w0 = std::max(0, y0 - halo);
+				const int w1 = std::min(height, y1 + halo);
+
+				// rows within the halo of the window edges are wrong unless the
+				// edge is the image edge, they are never copied to the result.
+				window = acquire_rows(src, w1 - w0);
+				src_mat.rowRange(w0, w1).copyTo(*window->get_opencv());
+
+				for (size_t f = s; f <= last; ++f)
+				{
+					const function* func = statements[f].Func;
+					std::vector<value>& args = arguments[f - s];
+					args[0].set_image(window);
+
+					// the window is never needed again so functions that can
+					// work in place write over it
+					image* provided = nullptr;
+					const auto mode = func->get_destination();
+					if (mode == function::Destination::InPlace)
+						provided = window;
+					else if (mode == function::Destination::Uninitialised)
+						provided = acquire_rows(window, w1 - w0);
+					else if (m_Pool)
+						provided = m_Pool->acquire_copy(window);
+
+					std::vector<value> outputs(func->get_outputs().size());
+					if (provided)
+						outputs[0].set_image(provided);
+
+					statements[f].Func->invoke(this, args.data(), outputs.data());
+
+					value& res = outputs[0];
+					if (res.get_type() != ObjectType::Image)
+					{
+						if (provided && provided != window)
+							discard_image(provided);
+						return fail();
+					}
+
+					image* out = res.get_image();
+					if (provided && provided != out && provided != window)
+						discard_image(provided);
+					if (out != window)
+						discard_image(window);
+					window = out;
+				}
+
+				const cv::Mat& window_mat = *window->get_opencv();
+				if (window_mat.rows != w1 - w0 || window_mat.cols != src_mat.cols)
+					return fail();
+
+				if (!dst)
+					dst = acquire_rows(window, height);
+				else if (dst->get_opencv()->type() != window_mat.type() || dst->get_format() != window->get_format())
+					return fail();
+
+				window_mat.rowRange(y0 - w0, y1 - w0).copyTo(dst->get_opencv()->rowRange(y0, y1));
+				discard_image(window);
+				window = nullptr;
+			}
+		}
+		catch (...)
+		{
+			fail();
+			throw;
+		}
+
+		end_group(s, last, dst, start);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_cached(size_t s)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+
+		// statements that don't depend on the swept inputs have already been
+		// run, only the results needed by later statements were kept
+		if (m_Cache && m_Cache->is_filled() && m_Cache->is_invariant(s))
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Cache->is_stored(s))
+			{
+				auto& outputs = m_Cache->get_outputs(s);
+				for (size_t i = 0; i < outputs.size(); ++i)
+					set_register(stmt.Outputs[i], outputs[i]);
+			}
+			return true;
+		}
+
+		// results that are in the result cache were loaded before execution 
+		// started, statements only needed to compute them are skipped
+		if (m_ResultCache && m_Plan[s] != Plan::Run)
+		{
+			if (m_Plan[s] == Plan::Skip)
+				return true;
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (size_t i = 0; i < m_Loaded[s].size(); ++i)
+			{
+				set_register(stmt.Outputs[i], value::make_image(m_Loaded[s][i]));
+				m_Cost[stmt.Outputs[i]] = 0.0;
+			}
+
+			if (m_Cache && !m_Cache->is_filled() && m_Cache->is_stored(s))
+				store_outputs(s);
+			return true;
+		}
+
+		return false;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_statement(size_t s)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+		check_cancelled();
+
+		if (execute_cached(s))
+			return true;
+
+		// run a group of fused pointwise statements as a single pass, falls 
+		// back to running them one at a time if that isn't possible
+		if (stmt.FusedStatements > 0 && execute_fused(s))
+			return true;
+
+		// and a group that only reads nearby pixels a strip of rows at a time
+		if (stmt.StripStatements > 0 && execute_strips(s))
+			return true;
+
+		image* provided = nullptr;
+		{
+			// register file access is serialised, only the function itself runs 
+			// concurrently with other statements
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			// already run as part of an earlier statement
+			if (m_FusedRun[s])
+				return true;
+
+			begin_statement(s, provided);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		stmt.Func->invoke(this, m_Arguments[s].data(), m_Results[s].data());
+
+		// stored before any later statement can see and overwrite the results
+		if (m_ResultCache)
+		{
+			std::vector<image*> images;
+			for (auto& res : m_Results[s])
+			{
+				if (res.get_type() == ObjectType::Image)
+					images.push_back(res.get_image());
+			}
+			checkpoint(s, s, seconds_since(start), images);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return end_statement(s, provided);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_parallel()
+	{
+		auto& statements = m_Program->m_Statements;
+
+		std::mutex mutex;
+		std::condition_variable signal;
+		std::vector<int> pending(statements.size());
+		size_t in_flight = 0;
+		bool failed = false;
+		std::exception_ptr error;
+
+		for (size_t s = 0; s < statements.size(); ++s)
+			pending[s] = statements[s].NumDependencies;
+
+		// called with the mutex held
+		std::function<void(size_t)> submit = [&](size_t s)
+		{
+			++in_flight;
+			m_Threads->submit([&, s]()
+			{
+				bool ok = false;
+				std::exception_ptr ex;
+				try
+				{
+					ok = execute_statement(s);
+				}
+				catch (...)
+				{
+					ex = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (ex && !error)
+					error = ex;
+				if (!ok)
+					failed = true;
+
+				// queue anything this statement was blocking
+				if (!failed)
+				{
+					for (int d : statements[s].Dependents)
+					{
+						if (--pending[d] == 0)
+							submit(d);
+					}
+				}
+
+				--in_flight;
+				signal.notify_all();
+			});
+		};
+
+		std::unique_lock<std::mutex> lock(mutex);
+		for (size_t s = 0; s < statements.size(); ++s)
+		{
+			if (pending[s] == 0)
+				submit(s);
+		}
+
+		// wait for everything to complete or for the in flight statements to 
+		// drain after a failure
+		signal.wait(lock, [&] { return in_flight == 0; });
+
+		if (error)
+			std::rethrow_exception(error);
+
+		return !failed;
+	}
+
+	//----------------------------------------------------------------------------
+
+	const value& context::get_repeat_count(size_t s) const
+	{
+		const statement& head = m_Program->m_Statements[s];
+		const operand& op = head.RepeatCount;
+		if (!op.is_constant() && !m_Defined[op.Slot])
+			throw symbol_not_found(m_Program->get_slot_declaration(op.Slot).Name.c_str());
+
+		const value& count = op.is_constant() ? op.Constant : m_Registers[op.Slot];
+		if (count.get_type() != ObjectType::Integer || count.get_integer() < 0)
+			throw invalid_repeat_count(head.Line, count);
+		return count;
+	}
+
+	//----------------------------------------------------------------------------
+
+	int context::begin_repeat(size_t s)
+	{
+		// images released by one iteration are reused by the next, so the 
+		// body ping-pongs between the same buffers however many times it runs
+		const int count = get_repeat_count(s).get_integer();
+		m_MaxSpares = 2 * (m_Program->m_Statements[s].RepeatStatements + 1);
+		return count;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::next_iteration(size_t s)
+	{
+		// groups in the body run as one pass again
+		const size_t last = s + m_Program->m_Statements[s].RepeatStatements;
+		std::fill(m_FusedRun.begin() + s, m_FusedRun.begin() + last + 1, 0);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::end_repeat()
+	{
+		m_MaxSpares = 0;
+		for (image* img : m_Spares)
+			release_image(img);
+		m_Spares.clear();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_repeat(size_t s)
+	{
+		const size_t last = s + m_Program->m_Statements[s].RepeatStatements;
+		const int count = begin_repeat(s);
+
+		bool ok = true;
+		for (int i = 0; i < count && ok; ++i)
+		{
+			next_iteration(s);
+			for (size_t f = s; f <= last && ok; ++f)
+				ok = execute_statement(f);
+		}
+
+		end_repeat();
+		return ok;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* context::take_spare(int width, int height, int type, image::Format format)
+	{
+		for (auto it = m_Spares.rbegin(); it != m_Spares.rend(); ++it)
+		{
+			const cv::Mat& mat = *(*it)->get_opencv();
+			if (mat.cols == width && mat.rows == height && mat.type() == type && (*it)->get_format() == format)
+			{
+				image* img = *it;
+				m_Spares.erase(std::next(it).base());
+				return img;
+			}
+		}
+		return nullptr;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* context::get_overwritten(size_t s, int slot)
+	{
+		// outside of a repeat block an image that is written over is released
+		// when the run completes, in one it's reused by the next iteration
+		value& val = m_Registers[slot];
+		if (!m_Program->in_repeat(s) || !m_Defined[slot] || val.get_type() != ObjectType::Image)
+			return nullptr;
+		return val.get_image();
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::release_overwritten(image* img, const image* result)
+	{
+		if (img && img != result && m_Allocated.count(img) && !is_shared(-1, img))
+			release_image(img);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::native_cached(size_t s)
+	{
+		check_cancelled();
+		return execute_cached(s) || m_FusedRun[s];
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* context::native_begin(size_t s)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+		for (size_t i = 0; i < stmt.Inputs.size(); ++i)
+		{
+			if (!stmt.Inputs[i].is_constant())
+				check_input(s, i);
+		}
+
+		// without a pool the destination is created as the function would
+		image* dst = provide_destination(stmt);
+		if (!dst)
+		{
+			image* src = m_Registers[stmt.Inputs[0].Slot].get_image();
+			if (stmt.Func->get_destination() == function::Destination::Uninitialised)
+				dst = src->clone_uninitialised();
+			else
+				dst = src->clone();
+			m_Allocated.insert(dst);
+		}
+
+		m_NativeStart = std::chrono::steady_clock::now();
+		return dst;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::native_end(size_t s, image* dst)
+	{
+		const statement& stmt = m_Program->m_Statements[s];
+		if (stmt.Outputs.size() != 1 || stmt.Outputs[0] < 0)
+			return false;
+
+		if (m_ResultCache)
+			checkpoint(s, s, seconds_since(m_NativeStart), { dst });
+
+		image* overwritten = get_overwritten(s, stmt.Outputs[0]);
+		set_register(stmt.Outputs[0], value::make_image(dst));
+		release_overwritten(overwritten, dst);
+
+		finish_statement(s, nullptr);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	const function* context::native_function(size_t s) const
+	{
+		return m_Program->m_Statements[s].Func;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::check_cancelled() const
+	{
+		if (m_Cancelled)
+			throw execution_cancelled();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute(image* src, image*& dst, const kv_dict& cinputs)
+	{
+		m_Cancelled = false;
+		return run(src, dst, cinputs);
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::future<image*> context::execute_async(image* src, const kv_dict& cinputs)
+	{
+		auto promise = std::make_shared<std::promise<image*>>();
+		std::future<image*> result = promise->get_future();
+		execute_async(src, cinputs, [promise](image* dst, std::exception_ptr error)
+		{
+			if (error)
+				promise->set_exception(error);
+			else
+				promise->set_value(dst);
+		});
+		return result;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void context::execute_async(image* src, const kv_dict& cinputs, completion done)
+	{
+		// one executor is shared by every context, statements within a run 
+		// are spread over the context's own thread pool. A pool of one thread
+		// has no workers so there are always at least two.
+		static thread_pool executor(std::max(std::thread::hardware_concurrency(), 2u));
+
+		// cancelling before the run starts stops it before its first statement
+		m_Cancelled = false;
+		executor.submit([this, src, cinputs, done]()
+		{
+			image* dst = nullptr;
+			std::exception_ptr error;
+			try
+			{
+				run(src, dst, cinputs);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+			done(dst, error);
+		});
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::run(image* src, image*& dst, const kv_dict& cinputs)
+	{
+		try
+		{
+			return execute_program(src, dst, cinputs);
+		}
+		catch (...)
+		{
+			// nothing from a failed or cancelled run is kept
+			free_allocated(nullptr);
+			throw;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool context::execute_program(image* src, image*& dst, const kv_dict& cinputs)
+	{
+		reset_registers(src, cinputs);
+		m_FusedRun.assign(m_Program->m_Statements.size(), 0);
+		dst = nullptr;
+
+		// everything that can be checked is checked before any pixels are touched
+		validate_inputs();
+		std::string error;
+		const image_shape src_shape(src->get_format(), src->get_width(), src->get_height());
+		if (!m_Program->infer_shapes(src_shape, m_Registers.data(), m_Shapes, &error))
+			throw shape_mismatch(error);
+		preallocate(src);
+
+		// unreadable results are removed from the cache so planning again 
+		// runs the statements that produce them instead
+		if (m_ResultCache)
+		{
+			m_Cost.assign(m_Program->num_slots(), 0.0);
+			plan_cached();
+			while (!load_cached())
+			{
+				free_allocated(nullptr);
+				plan_cached();
+			}
+		}
+
+		bool ok = true;
+		if (m_Native)
+		{
+			ok = m_Native->get_entry()(this);
+		}
+		else if (m_Threads && m_Threads->get_num_threads() > 1 && m_Program->has_parallel_branches())
+		{
+			ok = execute_parallel();
+		}
+		else
+		{
+			// execute each statement in the program
+			for (size_t s = 0; s < m_Program->m_Statements.size() && ok; ++s)
+			{
+				const statement& stmt = m_Program->m_Statements[s];
+				if (stmt.RepeatHead == static_cast<int>(s))
+				{
+					ok = execute_repeat(s);
+					s += stmt.RepeatStatements;
+				}
+				else
+				{
+					ok = execute_statement(s);
+				}
+			}
+		}
+
+		if (!ok)
+		{
+			free_allocated(nullptr);
+			return false;
+		}
+
+		if (m_Cache && !m_Cache->is_filled())
+			m_Cache->set_filled();
+
+		value& dst_val = m_Registers[m_Program->m_DstSlot];
+		if (m_Defined[m_Program->m_DstSlot] && dst_val.get_type() == ObjectType::Image)
+		{
+			dst = dst_val.get_image();
+
+			// the caller owns the result so anything this context doesn't own, 
+			// i.e. a cached result, is copied
+			if (!m_Allocated.count(dst))
+				dst = dst->clone();
+		}
+
+		// clean up
+		free_allocated(dst);
 
 		return dst != nullptr;
 	}
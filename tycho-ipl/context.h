@@ -35,10 +35,19 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "image_processing_abi.h"
+#include "image.h"
 #include "key_value.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
 #include <string>
 #include <map>
+#include <mutex>
 #include <set>
+#include <vector>
 
 //----------------------------------------------------------------------------
 // Class
@@ -62,13 +71,21 @@ namespace image_processing
 	};
 
 	//----------------------------------------------------------------------------
-	// Execution context when running a filter program
+	// Execution context when running a filter program. This holds all of the 
+	// state of a run, a context must only be used by one thread at a time.
 	//----------------------------------------------------------------------------
 	class TYCHO_IMAGEPROCESSING_ABI context
 	{
 	public:
-		/// Constructor
-		context(const program*, execution_interface*);
+		/// Called when a run started by execute_async() completes with the 
+		/// result execute() would return in dst, or the exception it threw.
+		using completion = std::function<void(image* dst, std::exception_ptr error)>;
+
+	public:
+		/// Constructor. If a pool is supplied temporary images are allocated from
+		/// and returned to it, otherwise they are allocated for each run. If a 
+		/// thread pool is supplied independent statements are run concurrently.
+		context(const program*, execution_interface*, image_pool* pool = nullptr, thread_pool* threads = nullptr);
 		
 		/// Destructor
 		~context();
@@ -76,18 +93,162 @@ namespace image_processing
 		/// Run the program
 		bool execute(image* src, image*& dst, const kv_dict& inputs);
 
+		/// Run the program on a thread owned by the library and return 
+		/// straight away. The future holds the result, null if the program 
+		/// didn't produce one, or the exception the run threw. src and this
+		/// context must not be used or destroyed until it is ready.
+		std::future<image*> execute_async(image* src, const kv_dict& inputs);
+
+		/// As above, calling done from the thread that ran the program instead
+		void execute_async(image* src, const kv_dict& inputs, completion done);
+
+		/// Stop the run in progress before its next statement is started, the
+		/// run throws execution_cancelled. Can be called from any thread.
+		void cancel() { m_Cancelled = true; }
+
+		/// Use a cache of the results of statements that don't depend on the
+		/// inputs that change between executions. If it has been filled those
+		/// statements are skipped, otherwise they're stored as they complete.
+		void set_prefix_cache(prefix_cache* cache) { m_Cache = cache; }
+
+		/// Use a persistent cache of statement results. Statements whose results
+		/// are already stored are loaded instead of run, and anything only 
+		/// needed to compute them is skipped. Results are stored as soon as 
+		/// they are computed if that took longer than reading them back, so a
+		/// run that is interrupted resumes from its last expensive statement.
+		void set_result_cache(result_cache* cache) { m_ResultCache = cache; }
+
+		/// Set the result cache key of the source image of the following runs,
+		/// from result_cache::hash(), so an image run with many variations is 
+		/// only hashed once. 0 hashes the source each time it is run.
+		void set_source_key(uint64_t key) { m_SourceKey = key; }
+
+		/// Set the number of rows in each strip when running statements that 
+		/// only read nearby pixels a strip at a time, 0 to always run them on
+		/// whole images.
+		void set_strip_height(int rows) { m_StripHeight = rows; }
+
+		/// Default strip height
+		static const int DefaultStripHeight = 256;
+
+		/// Run the program with native code built for it by native_program 
+		/// instead of interpreting it. Statements are run in order on the 
+		/// calling thread.
+		void set_native(const native_program* native) { m_Native = native; }
+
 		/// Get the execution interface for this context
 		execution_interface* GetExecutionInterface()
 		{
 			return m_Interface;
 		}
 
+		/// Interface used by the code generated by native_program, statements 
+		/// are identified by their index in the program.
+		/// Returns true if statement s was loaded from a cache or ran as part 
+		/// of a group, otherwise it has to be run.
+		bool native_cached(size_t s);
+
+		/// Run statement s through its function's invoke()
+		bool native_dispatch(size_t s) { return execute_statement(s); }
+
+		/// Validate the inputs of statement s and get the image its function
+		/// writes its result to
+		image* native_begin(size_t s);
+
+		/// Complete statement s after its function has written to dst
+		bool native_end(size_t s, image* dst);
+
+		/// Read inputs for the statement between native_begin and native_end
+		const function* native_function(size_t s) const;
+		image* native_image(int slot) { return m_Registers[slot].get_image(); }
+		int native_integer(int slot) const { return m_Registers[slot].get_integer(); }
+		float native_float(int slot) const { return m_Registers[slot].get_float(); }
+		bool native_boolean(int slot) const { return m_Registers[slot].get_boolean(); }
+
+		/// Start the repeat block at statement s, returns the number of times
+		/// it runs. Each iteration starts with native_repeat_next and the block
+		/// ends with native_repeat_end.
+		int native_repeat_begin(size_t s) { return begin_repeat(s); }
+		void native_repeat_next(size_t s) { next_iteration(s); }
+		void native_repeat_end() { end_repeat(); }
+
+
+	private:
+		bool run(image* src, image*& dst, const kv_dict& inputs);
+		bool execute_program(image* src, image*& dst, const kv_dict& inputs);
+		void check_cancelled() const;
+		void reset_registers(image* src, const kv_dict& inputs);
+		void validate_inputs() const;
+		void preallocate(const image* src);
+		void set_register(int slot, const value& val);
+		void release_image(image* img);
+		void free_allocated(const image* keep);
+		image* provide_destination(const statement& stmt);
+		const value& check_input(size_t s, size_t i) const;
+		void bind_inputs(size_t s, size_t first);
+		kv_dict get_arguments(size_t s) const;
+		void begin_statement(size_t s, image*& provided);
+		bool end_statement(size_t s, image* provided);
+		void finish_statement(size_t s, image* provided);
+		bool execute_cached(size_t s);
+		bool execute_statement(size_t s);
+		bool execute_fused(size_t s);
+		bool execute_strips(size_t s);
+		bool can_run_group(size_t s, size_t last) const;
+		void end_group(size_t s, size_t last, image* dst, std::chrono::steady_clock::time_point start);
+		image* acquire_rows(const image* like, int rows);
+		void discard_image(image* img);
+		bool execute_parallel();
+		bool execute_repeat(size_t s);
+		int begin_repeat(size_t s);
+		void next_iteration(size_t s);
+		void end_repeat();
+		const value& get_repeat_count(size_t s) const;
+		image* take_spare(int width, int height, int type, image::Format format);
+		image* get_overwritten(size_t s, int slot);
+		void release_overwritten(image* img, const image* result);
+		bool is_shared(int slot, const image* img) const;
+		void store_outputs(size_t s);
+		void plan_cached();
+		bool load_cached();
+		void checkpoint(size_t first, size_t last, double seconds, const std::vector<image*>& images);
+
+		enum class Plan
+		{
+			Run,
+			Load,
+			Skip
+		};
 
 	private:
 		execution_interface* m_Interface;
 		const program*	m_Program;
-		kv_dict m_SymbolTable;
+		std::vector<value> m_Registers;
+		std::vector<bool> m_Defined;
+		std::vector<std::vector<value>> m_Arguments;	///< per statement, indexed by function input
+		std::vector<std::vector<value>> m_Results;		///< per statement, indexed by function output
+		std::vector<char> m_FusedRun;	///< per statement, set when its fused or strip group ran as one pass
+		std::vector<std::vector<char>> m_CheckOnRead;	///< per statement input, set if it's validated as it's read
+		std::vector<image_shape> m_Shapes;	///< per statement, the image it writes
+		image_shape		m_Preallocated;	///< source the pool was last filled for
 		std::set<image*> m_Allocated;
+		std::vector<image*> m_Spares;	///< released while a repeat block runs, reused by its next iteration
+		size_t			m_MaxSpares = 0;	///< 0 when no repeat block is running
+		image_pool*		m_Pool;
+		thread_pool*	m_Threads;
+		int				m_StripHeight = DefaultStripHeight;
+		prefix_cache*	m_Cache = nullptr;
+		result_cache*	m_ResultCache = nullptr;
+		uint64_t		m_SourceKey = 0;
+		const native_program* m_Native = nullptr;
+		std::vector<char> m_Cacheable;	///< per statement, set if its results can be stored
+		std::vector<Plan> m_Plan;
+		std::vector<std::vector<uint64_t>> m_Keys;	///< per statement result cache keys of its outputs
+		std::vector<std::vector<image*>> m_Loaded;
+		std::vector<double> m_Cost;	///< per slot, seconds to compute its value again from the stored results
+		std::chrono::steady_clock::time_point m_NativeStart;	///< when the native statement being run started
+		std::mutex		m_Mutex;
+		std::atomic<bool> m_Cancelled{false};
 
 		// noncopyable
 		context& operator=(const context&) = delete;
@@ -28,6 +28,9 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "exception.h"
+#include "function.h"
+
+#include <cstdio>
 
 
 //----------------------------------------------------------------------------
@@ -39,5 +42,27 @@ namespace tycho
 namespace image_processing
 {
 
+	//----------------------------------------------------------------------------
+
+	invalid_parameter::invalid_parameter(const function* func, const param_desc& param, const value& value)
+	{
+		snprintf(
+			&m_buffer[0], m_buffer.size(),
+			"Param '%s' to Function '%s' cannot be assigned '%s'",
+			param.Name.c_str(), func->get_name(), value.to_string().c_str());
+	}
+
+	//----------------------------------------------------------------------------
+
+	invalid_repeat_count::invalid_repeat_count(int line, const value& count)
+	{
+		snprintf(
+			&m_buffer[0], m_buffer.size(),
+			"Line %d : Repeat count cannot be '%s'",
+			line + 1, count.to_string().c_str());
+	}
+
+	//----------------------------------------------------------------------------
+
 } // end namespace
 } // end namespace
@@ -35,10 +35,12 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "image_processing_abi.h"
+#include "forward_decls.h"
 #include "key_value.h"
-#include "function.h"
 #include <exception>
 #include <array>
+#include <cstdio>
+#include <string>
 
 //----------------------------------------------------------------------------
 // Class
@@ -72,23 +74,21 @@ namespace image_processing
 	class symbol_not_found : public runtime_exception
 	{
 	public:
-		symbol_not_found(const char *name) :
-			m_SymbolName(name)
-		{}
-
-		const char* what() const noexcept override
+		symbol_not_found(const char *name)
 		{
-			static std::array<char, 256> buffer;
-			sprintf(
-				&buffer[0],
+			snprintf(
+				&m_buffer[0], m_buffer.size(),
 				"Symbol '%s' cannot be found",
-				m_SymbolName.c_str());
+				name);
+		}
 
-			return buffer.data();
+		const char* what() const noexcept override
+		{
+			return m_buffer.data();
 		}
 
 	private:
-		std::string m_SymbolName;
+		std::array<char, 256> m_buffer;
 	};
 
 	//----------------------------------------------------------------------------
@@ -97,13 +97,7 @@ namespace image_processing
 	class invalid_parameter : public runtime_exception
 	{
 	public:
-		invalid_parameter(const function* func, const param_desc& param, const value& value)
-		{
-			sprintf(
-				&m_buffer[0],
-				"Param '%s' to Function '%s' cannot be assigned '%s'",
-				param.Name.c_str(), func->get_name(), value.to_string().c_str());
-		}
+		invalid_parameter(const function* func, const param_desc& param, const value& value);
 
 		const char* what() const noexcept override
 		{
@@ -113,27 +107,121 @@ namespace image_processing
 	private:
 		std::array<char, 256> m_buffer;
 	};
-	
 
-	class program_load_error : public runtime_exception
+	//----------------------------------------------------------------------------
+	// Image passed to a function has a format or size it can't be used with
+	//----------------------------------------------------------------------------
+	class shape_mismatch : public runtime_exception
 	{
 	public:
-		program_load_error(const std::string& path) :
-			m_Path(path)
+		shape_mismatch(const std::string& message) :
+			m_Message(message)
 		{}
 
 		const char* what() const noexcept override
 		{
-			static std::array<char, 256> buffer;
-			sprintf(
-				&buffer[0],
+			return m_Message.c_str();
+		}
+
+	private:
+		std::string m_Message;
+	};
+
+	//----------------------------------------------------------------------------
+	// Number of times a repeat block runs isn't a non-negative int
+	//----------------------------------------------------------------------------
+	class invalid_repeat_count : public runtime_exception
+	{
+	public:
+		invalid_repeat_count(int line, const value& count);
+
+		const char* what() const noexcept override
+		{
+			return m_buffer.data();
+		}
+
+	private:
+		std::array<char, 256> m_buffer;
+	};
+
+
+	//----------------------------------------------------------------------------
+	// Run was stopped by context::cancel() before it completed
+	//----------------------------------------------------------------------------
+	class execution_cancelled : public runtime_exception
+	{
+	public:
+		const char* what() const noexcept override
+		{
+			return "Execution cancelled";
+		}
+	};
+
+
+	class program_load_error : public runtime_exception
+	{
+	public:
+		program_load_error(const std::string& path)
+		{
+			snprintf(
+				&m_buffer[0], m_buffer.size(),
 				"Error loading program '%s'",
-				m_Path.c_str());
-			return buffer.data();
+				path.c_str());
+		}
+
+		const char* what() const noexcept override
+		{
+			return m_buffer.data();
+		}
+
+	private:
+		std::array<char, 256> m_buffer;
+	};
+
+	//----------------------------------------------------------------------------
+	// A result image couldn't be handed to the encoders to be written
+	//----------------------------------------------------------------------------
+	class image_write_error : public runtime_exception
+	{
+	public:
+		image_write_error(const std::string& path)
+		{
+			snprintf(
+				&m_buffer[0], m_buffer.size(),
+				"Unable to write '%s' : the encoders have stopped",
+				path.c_str());
+		}
+
+		const char* what() const noexcept override
+		{
+			return m_buffer.data();
+		}
+
+	private:
+		std::array<char, 512> m_buffer;
+	};
+
+	//----------------------------------------------------------------------------
+	// Native code for a program could not be built or loaded
+	//----------------------------------------------------------------------------
+	class native_build_error : public runtime_exception
+	{
+	public:
+		native_build_error(const std::string& path, const char* reason)
+		{
+			snprintf(
+				&m_buffer[0], m_buffer.size(),
+				"Unable to build native code '%s' : %s",
+				path.c_str(), reason);
+		}
+
+		const char* what() const noexcept override
+		{
+			return m_buffer.data();
 		}
 
 	private:
-		std::string m_Path;
+		std::array<char, 512> m_buffer;
 	};
 
 } // end namespace
@@ -46,15 +46,24 @@ namespace image_processing
 {
 
 	class image;
+	class image_pool;
 	class function;
+	struct param_desc;
+	struct image_shape;
 	class program;
 	class context;
 	struct key_value;
+	class value;
 	struct statement;
+	struct pixel_kernel;
+	class prefix_cache;
+	class result_cache;
+	class native_program;
 	class declaration;
 	class execution_interface;
 	class ContactSheeet;
 	class result_matrix;
+	class thread_pool;
 
 	namespace functions
 	{
@@ -28,6 +28,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "function.h"
+#include "image.h"
 
 
 //----------------------------------------------------------------------------
@@ -71,6 +72,96 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	image* function::acquire_destination(const image* src, const kv_dict& outputs) const
+	{
+		// use the image provided by the executor if there is one
+		value dst;
+		if (outputs.try_get(m_Outputs[0].Name, dst))
+			return dst.get_image();
+
+		return acquire_destination(src, nullptr);
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* function::acquire_destination(const image* src, image* provided) const
+	{
+		if (provided)
+			return provided;
+
+		if (m_Destination == Destination::Uninitialised)
+			return src->clone_uninitialised();
+
+		return src->clone();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool function::invoke(context* ctx, const value* inputs, value* outputs) const
+	{
+		kv_dict in_dict;
+		for (size_t i = 0; i < m_Inputs.size(); ++i)
+		{
+			if (inputs[i].is_valid())
+				in_dict.set(m_Inputs[i].Name, inputs[i]);
+		}
+
+		kv_dict out_dict;
+		for (size_t i = 0; i < m_Outputs.size(); ++i)
+		{
+			if (outputs[i].is_valid())
+				out_dict.set(m_Outputs[i].Name, outputs[i]);
+		}
+
+		bool ok = dispatch(ctx, in_dict, out_dict);
+		for (size_t i = 0; i < m_Outputs.size(); ++i)
+		{
+			if (!out_dict.try_get(m_Outputs[i].Name, outputs[i]))
+				outputs[i] = value();
+		}
+		return ok;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool function::infer_shape(const value* /*args*/, const image_shape* shapes, image_shape& out, std::string& /*message*/) const
+	{
+		out = image_shape();
+		if (m_Inputs.empty() || m_Inputs[0].Type != ObjectType::Image)
+			return true;
+
+		out = shapes[0];
+		if (m_OutputFormat != image::Format::Count)
+		{
+			out.HasFormat = true;
+			out.Format = m_OutputFormat;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool function::dispatch_indexed(context* ctx, const kv_dict& inputs, kv_dict& outputs) const
+	{
+		std::vector<value> in_values(m_Inputs.size());
+		for (size_t i = 0; i < m_Inputs.size(); ++i)
+			inputs.try_get(m_Inputs[i].Name, in_values[i]);
+
+		std::vector<value> out_values(m_Outputs.size());
+		for (size_t i = 0; i < m_Outputs.size(); ++i)
+			outputs.try_get(m_Outputs[i].Name, out_values[i]);
+
+		bool ok = invoke(ctx, in_values.data(), out_values.data());
+		for (size_t i = 0; i < m_Outputs.size(); ++i)
+		{
+			if (out_values[i].is_valid())
+				outputs.set(m_Outputs[i].Name, out_values[i]);
+		}
+		return ok;
+	}
+
+	//----------------------------------------------------------------------------
+
 	std::string function::get_signature() const
 	{
 		std::string result(m_Name);
@@ -175,7 +266,7 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
-	bool function::get_param(const std::string& key, param_desc& desc)
+	bool function::get_param(const std::string& key, param_desc& desc) const
 	{
 		auto& inputs = get_inputs();
 		for (auto p : inputs)
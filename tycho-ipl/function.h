@@ -35,10 +35,18 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "image_processing_abi.h"
+#include "image.h"
 #include "key_value.h"
 #include "program.h"
 #include "utils.h"
 
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <initializer_list>
+#include <string>
+
 //----------------------------------------------------------------------------
 // Class
 //----------------------------------------------------------------------------
@@ -50,10 +58,24 @@ namespace image_processing
 
 	namespace validation
 	{
-		using ValidationFunc = std::function < bool(const value&) > ;
+		/// Validation function taking the value and the argument it was bound with
+		using ValidationFunc = bool(*)(const value&, int);
+
+		/// A validation function and its bound argument. This is a plain function
+		/// pointer so validating slot arguments as statements run is cheap.
+		struct rule
+		{
+			rule() = default;
+			rule(ValidationFunc func, int arg = 0) : Func(func), Arg(arg) {}
+
+			bool operator()(const value& val) const { return !Func || Func(val, Arg); }
+
+			ValidationFunc Func = nullptr;
+			int			   Arg = 0;
+		};
 
 		/// Default validation function that just accepts all values
-		inline bool no_validation(const value&) { return true; }
+		inline bool no_validation(const value&, int) { return true; }
 
 		inline bool odd_only_integer(const value& val, int max)
 		{
@@ -71,7 +93,7 @@ namespace image_processing
 			return true;
 		}
 
-		inline bool unit_float(const value& val)
+		inline bool unit_float(const value& val, int)
 		{
 			float v = val.get_float();
 
@@ -82,7 +104,7 @@ namespace image_processing
 			return true;
 		}
 
-		inline bool positive_integer(const value& val, int max = std::numeric_limits<int>::max())
+		inline bool positive_integer(const value& val, int max)
 		{
 			int v = val.get_integer();
 			
@@ -95,13 +117,19 @@ namespace image_processing
 			return true;
 		}
 
-		inline bool pow2_integer(const value& val)
+		inline bool pow2_integer(const value& val, int)
 		{
 			int v = val.get_integer();
 
 			return utils::num_bits_set(v) == 1;
 		}
 
+		/// Rules for the functions above
+		inline rule odd_only(int max) { return rule(odd_only_integer, max); }
+		inline rule positive(int max = std::numeric_limits<int>::max()) { return rule(positive_integer, max); }
+		inline rule unit() { return rule(unit_float); }
+		inline rule pow2() { return rule(pow2_integer); }
+
 	}
 
 
@@ -115,7 +143,7 @@ namespace image_processing
 			const std::string& name, 
 			const std::string& desc, 
 			const value& def,
-			validation::ValidationFunc vfunc = std::bind(validation::no_validation, std::placeholders::_1)) :
+			validation::rule vfunc = validation::rule()) :
 			Type(type),
 			Name(name),
 			Description(desc),
@@ -130,8 +158,7 @@ namespace image_processing
 			const std::string& desc) :
 			Type(type),
 			Name(name),
-			Description(desc),
-			ValidationFunction(std::bind(validation::no_validation, std::placeholders::_1))
+			Description(desc)
 		{
 		}
 
@@ -141,7 +168,7 @@ namespace image_processing
 		std::string Name;
 		std::string Description;
 		value		DefaultVal;
-		validation::ValidationFunc ValidationFunction;
+		validation::rule ValidationFunction;
 	};
 
 	using param_list = std::vector < param_desc > ;
@@ -171,6 +198,24 @@ namespace image_processing
 			Artistic
 		};
 
+		/// How a function needs its destination image to be provided. This
+		/// lets the executor avoid copying the source image when it is able to.
+		enum class Destination
+		{
+			Copy,			///< dst must start as a copy of the first source image
+			InPlace,		///< dst may be the first source image itself
+			Uninitialised	///< dst is fully overwritten so its contents are unused
+		};
+
+		/// Which pixels of the source image each destination pixel depends on.
+		/// Functions that aren't global can be run on strips of the image.
+		enum class Footprint
+		{
+			Global,			///< any pixel, i.e. histograms or clustering
+			Pointwise,		///< only the pixel at the same position
+			Neighbourhood	///< pixels within get_radius() of the same position
+		};
+
 	public:
 		/// Constructor
 		function(Group group, const char* name, const char* desc,
@@ -189,7 +234,41 @@ namespace image_processing
 		/// Destructor
 		virtual ~function() = default;
 		
-		virtual bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) = 0;
+		virtual bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const = 0;
+
+		/// Run the function with its arguments indexed in the order of 
+		/// get_inputs() and get_outputs(). An image in outputs[0] on entry is 
+		/// the destination provided by the executor. This is what the executor 
+		/// calls, by default the arguments are looked up by name and passed to 
+		/// dispatch(). Functions binding their parameters with typed_function
+		/// read them by index instead.
+		virtual bool invoke(context* ctx, const value* inputs, value* outputs) const;
+
+		/// Pointwise functions fill in a kernel computing the function for the
+		/// passed inputs on a row of pixels in the kernel's input format. Returns
+		/// false if the format isn't supported, in which case dispatch() is used.
+		virtual bool get_pixel_kernel(const kv_dict& /*inputs*/, pixel_kernel& /*kernel*/) const { return false; }
+
+		/// Functions that map each channel value independently through the same
+		/// table fill in that table for the passed inputs.
+		virtual bool get_lut(const kv_dict& /*inputs*/, std::array<uint8_t, 256>& /*lut*/) const { return false; }
+
+		/// Neighbourhood functions return the furthest distance in pixels from
+		/// a destination pixel that source pixels are read for the passed 
+		/// inputs, or -1 if they need the whole image for those inputs.
+		virtual int get_radius(const kv_dict& /*inputs*/) const { return 0; }
+
+		/// Infer the shape of the image written to the first output before the
+		/// function is run. args[i] is the value of input i if it is known and
+		/// invalid otherwise, shapes[i] is its shape if it is an image. Returns 
+		/// false with the reason in message if the function can't be used with
+		/// these inputs, a message when returning true is a warning. By default 
+		/// the result has the shape of the first input and the format set by 
+		/// set_output_format().
+		virtual bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const;
+
+		/// Get the radius for the passed inputs, -1 for global functions
+		int get_halo(const kv_dict& inputs) const { return m_Footprint == Footprint::Global ? -1 : get_radius(inputs); }
 
 		const param_list& get_inputs() const;
 		const param_list& get_outputs() const;
@@ -200,14 +279,77 @@ namespace image_processing
 		bool has_output(const char*) const;
 
 		bool has_param(const char*) const;
-		bool get_param(const std::string& key, param_desc&);
+		bool get_param(const std::string& key, param_desc&) const;
 
 		Group       get_group() const { return m_group; }
+		Destination get_destination() const { return m_Destination; }
+		bool        has_side_effects() const { return m_SideEffects; }
+		bool        is_pointwise() const { return m_Pointwise; }
+		Footprint   get_footprint() const { return m_Footprint; }
+		int         get_lut_channels() const { return m_LutChannels; }
+		image::Format get_output_format() const { return m_OutputFormat; }
 		std::string get_signature() const;
 		std::string get_simple_signature() const;
 		const char* get_name() const { return m_Name; }
 		const char* get_description() const { return m_Desc; }
 
+		/// Class and header declaring the typed execute() method dispatch() 
+		/// forwards to, null if there isn't one. Native code generated for a
+		/// program calls it directly.
+		const char* get_native_class() const { return m_NativeClass; }
+		const char* get_native_header() const { return m_NativeHeader; }
+
+		/// Names of the inputs and outputs passed to execute() in order
+		const std::vector<const char*>& get_native_args() const { return m_NativeArgs; }
+
+	protected:
+		/// Set the destination requirements, called from derived constructors
+		void set_destination(Destination d) { m_Destination = d; }
+
+		/// Mark the function as having effects outside of its outputs, i.e. 
+		/// writing files. These calls are always made in program order.
+		void set_side_effects(bool side_effects) { m_SideEffects = side_effects; }
+
+		/// Mark the function as pointwise, each output pixel depends only on the
+		/// input pixel at the same position. These must implement get_pixel_kernel().
+		void set_pointwise(bool pointwise) 
+		{ 
+			m_Pointwise = pointwise; 
+			if (pointwise)
+				m_Footprint = Footprint::Pointwise;
+		}
+
+		/// Set the format of the images the function writes when it isn't the
+		/// format of its first input
+		void set_output_format(image::Format format) { m_OutputFormat = format; }
+
+		/// Set the spatial footprint, functions are global unless they set this
+		void set_footprint(Footprint footprint) { m_Footprint = footprint; }
+
+		/// Mark the function as a table lookup on images with the given number
+		/// of channels, 0 if it isn't one. These must implement get_lut().
+		void set_lut_channels(int channels) { m_LutChannels = channels; }
+
+		/// Declare the typed execute() method of class_name that dispatch() 
+		/// forwards to. It must take the named parameters in order and write 
+		/// to the destination from acquire_destination() of the first source.
+		/// The header is relative to the library root.
+		void set_native(const char* class_name, const char* header, std::initializer_list<const char*> args)
+		{
+			m_NativeClass = class_name;
+			m_NativeHeader = header;
+			m_NativeArgs = args;
+		}
+
+		/// Get the image to write the result to. If the executor has supplied
+		/// an output image, either src itself or a pooled buffer, it is used
+		/// directly, otherwise a new one is created as required by get_destination().
+		image* acquire_destination(const image* src, const kv_dict& outputs) const;
+		image* acquire_destination(const image* src, image* provided) const;
+
+		/// Implement dispatch() by passing the named arguments to invoke() 
+		bool dispatch_indexed(context* ctx, const kv_dict& inputs, kv_dict& outputs) const;
+
 	protected:
 		const Group m_group;
 		const char* m_Name = nullptr;
@@ -215,6 +357,15 @@ namespace image_processing
 		const param_list m_Inputs;
 		const param_list m_Outputs;
 		const declaration_list m_Constants;
+		Destination m_Destination = Destination::Copy;
+		bool		m_SideEffects = false;
+		bool		m_Pointwise = false;
+		Footprint	m_Footprint = Footprint::Global;
+		int			m_LutChannels = 0;
+		image::Format m_OutputFormat = image::Format::Count;	///< Count if it is the input format
+		const char* m_NativeClass = nullptr;
+		const char* m_NativeHeader = nullptr;
+		std::vector<const char*> m_NativeArgs;
 	};
 	
 	
@@ -50,49 +50,44 @@ namespace functions
 							   "contains the closest to the requested percentage "
 							   "of edge pixels";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-
-		param_desc(ObjectType::Integer,
-		"edge_percent",
-		"Percentage of edge pixels to target",
-		value::make_integer(5)),
-
-		param_desc(ObjectType::Integer,
-		"min",
-		"Minimum value to be classified as an edge pixels. Pixels >= than this will be forced to 255",
-		value::make_integer(64)),
-
-		param_desc(ObjectType::Boolean,
-		"invert",
-		"Invert the results",
-		value::make_boolean(false)),
-
-		param_desc(ObjectType::Boolean,
-		"adaptive_cutoff",
-		"Refine the best image found searching the filter space by changing the cutoff value",
-		value::make_boolean(false))
-
+	static const param_binding<adaptive_edge_laplacian_params> Params = {
+		{
+			{ &adaptive_edge_laplacian_params::src, function::DefaultInput() },
+			{ &adaptive_edge_laplacian_params::edge_percent, param_desc(ObjectType::Integer,
+				"edge_percent",
+				"Percentage of edge pixels to target",
+				value::make_integer(5)) },
+			{ &adaptive_edge_laplacian_params::min, param_desc(ObjectType::Integer,
+				"min",
+				"Minimum value to be classified as an edge pixels. Pixels >= than this will be forced to 255",
+				value::make_integer(64)) },
+			{ &adaptive_edge_laplacian_params::invert, param_desc(ObjectType::Boolean,
+				"invert",
+				"Invert the results",
+				value::make_boolean(false)) },
+			{ &adaptive_edge_laplacian_params::adaptive_cutoff, param_desc(ObjectType::Boolean,
+				"adaptive_cutoff",
+				"Refine the best image found searching the filter space by changing the cutoff value",
+				value::make_boolean(false)) }
+		},
+		{ { &adaptive_edge_laplacian_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	adaptive_edge_laplacian::adaptive_edge_laplacian() :
-		function(Group::EdgeDetection, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::EdgeDetection, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_native("functions::adaptive_edge_laplacian", "functions/adaptive_edge_laplacian.h", { "src", "dst", "edge_percent", "min", "invert", "adaptive_cutoff" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool adaptive_edge_laplacian::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool adaptive_edge_laplacian::run(context* /*ctx*/, adaptive_edge_laplacian_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int edge_percent = inputs.get_integer("edge_percent");
-		int lower_cutoff = inputs.get_integer("min");
-		bool invert = inputs.get_boolean("invert");
-		bool apply_adaptive_cutoff = inputs.get_boolean("adaptive_cutoff");
-		image* dst = src->clone();
-		execute(src, dst, edge_percent, lower_cutoff, invert, apply_adaptive_cutoff);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.edge_percent, p.min, p.invert, p.adaptive_cutoff);
 		return true;
 	}
 	//----------------------------------------------------------------------------
@@ -139,7 +134,7 @@ namespace functions
 	void adaptive_edge_laplacian::execute(
 		image* in_src, image* in_dst, 
 		int edge_percent, int lower_cutoff, 
-		bool invert, bool apply_adaptive_cutoff)
+		bool invert, bool apply_adaptive_cutoff) const
 	{
 		edge_laplacian filter;
 		
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -47,20 +47,32 @@ namespace image_processing
 {
 namespace functions
 { 
+	struct adaptive_edge_laplacian_params
+	{
+		image* src;
+		int    edge_percent;
+		int    min;
+		bool   invert;
+		bool   adaptive_cutoff;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Calculate edges using laplacian filter. This version will search the filter
 	// input space to find the result that is closest to supplied edge ratio. This
 	// is the number of pixels detected as edges over the image area.
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI adaptive_edge_laplacian : public function
+	class TYCHO_IMAGEPROCESSING_ABI adaptive_edge_laplacian : public typed_function<adaptive_edge_laplacian_params>
 	{
 	public:
 		adaptive_edge_laplacian();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
 		virtual void execute(
 			image* src, image* dst, 
 			int edge_percent, int lower_cutoff, 
-			bool invert, bool apply_adaptive_cutoff);
+			bool invert, bool apply_adaptive_cutoff) const;
+
+	protected:
+		bool run(context* ctx, adaptive_edge_laplacian_params& params) const override;
 	};
 
 	
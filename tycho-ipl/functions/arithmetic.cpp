@@ -114,10 +114,10 @@ namespace functions
 		cv::bitwise_xor(*src1->get_opencv(), *src2->get_opencv(), *dst->get_opencv());
 	}
 
-	IMAG_PROC_DEFINE_UNARY_FUNCTION(
+	IMAG_PROC_DEFINE_UNARY_FUNCTION_FORMAT(
 		Group::Arithmetic,
 		"max",
-		"max", max)
+		"max", max, image::Format::Grey)
 	{
 		std::vector<cv::Mat> channels;
 		cv::split(*src->get_opencv(), channels);
@@ -140,10 +140,10 @@ namespace functions
 		dst->set_mat(dst_mat, image::Format::Grey);
 	}
 
-	IMAG_PROC_DEFINE_UNARY_FUNCTION(
+	IMAG_PROC_DEFINE_UNARY_FUNCTION_FORMAT(
 		Group::Arithmetic,
 		"min",
-		"min", min)
+		"min", min, image::Format::Grey)
 	{
 		std::vector<cv::Mat> channels;
 		cv::split(*src->get_opencv(), channels);
@@ -50,11 +50,12 @@ namespace functions
 	auto_level_component_stretch::auto_level_component_stretch() :
 		UnaryFunction(Group::Leveling, Name, Desc)
 	{
+		set_destination(Destination::InPlace);
 	}
 
 	//----------------------------------------------------------------------------
 
-	void auto_level_component_stretch::execute(image* in_src, image* in_dst)
+	void auto_level_component_stretch::execute(image* in_src, image* in_dst) const
 	{
 		using namespace cv;
 
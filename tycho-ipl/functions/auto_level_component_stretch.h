@@ -55,7 +55,7 @@ namespace functions
 	{
 	public:
 		auto_level_component_stretch();
-		void execute(image* src, image* dst) override;
+		void execute(image* src, image* dst) const override;
 	};
 
 
@@ -46,32 +46,35 @@ namespace functions
 	static const char Name[] = "auto_level_histogram_clip";
 	static const char Desc[] = "Auto levels image lighting based on the image histogram.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Float, "clip_percent", "percentage to clip from histogram", value::make_float(1.0f))
+	static const param_binding<auto_level_histogram_clip_params> Params = {
+		{
+			{ &auto_level_histogram_clip_params::src, function::DefaultInput() },
+			{ &auto_level_histogram_clip_params::clip_percent, param_desc(ObjectType::Float, "clip_percent", "percentage to clip from histogram", value::make_float(1.0f)) }
+		},
+		{ { &auto_level_histogram_clip_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	auto_level_histogram_clip::auto_level_histogram_clip() :
-		function(Group::Leveling, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Leveling, Name, Desc, Params)
+	{
+		set_destination(Destination::InPlace);
+		set_native("functions::auto_level_histogram_clip", "functions/auto_level_histogram_clip.h", { "src", "dst", "clip_percent" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool auto_level_histogram_clip::dispatch(context* /*ctx*/, const kv_dict& inputs,  kv_dict& outputs)
+	bool auto_level_histogram_clip::run(context* /*ctx*/, auto_level_histogram_clip_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		float clip_percent = inputs.get_float("clip_percent");
-		image* dst = src->clone();
-		execute(src, dst, clip_percent);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.clip_percent);
 		return true;
 	}
 	//----------------------------------------------------------------------------
 	
-	void auto_level_histogram_clip::execute(image* in_src, image* in_dst, float clipHistPercent)
+	void auto_level_histogram_clip::execute(image* in_src, image* in_dst, float clipHistPercent) const
 	{
 		using namespace cv;
 
@@ -34,7 +34,7 @@
 //----------------------------------------------------------------------------
 // Includes
 //----------------------------------------------------------------------------
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -47,17 +47,26 @@ namespace image_processing
 namespace functions
 {
 
+	struct auto_level_histogram_clip_params
+	{
+		image* src;
+		float  clip_percent;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Auto levels image lighting base on its intensity histogram. This version
 	// also allow clipping of the ends of the histogram and expanding into the 
 	// full range. 
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI auto_level_histogram_clip: public function
+	class TYCHO_IMAGEPROCESSING_ABI auto_level_histogram_clip: public typed_function<auto_level_histogram_clip_params>
 	{
 	public:
 		auto_level_histogram_clip();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float clipHistPercent);
+		virtual void execute(image* src, image* dst, float clipHistPercent) const;
+
+	protected:
+		bool run(context* ctx, auto_level_histogram_clip_params& params) const override;
 	};
 
 
@@ -50,11 +50,12 @@ namespace functions
 	auto_level_open_cv::auto_level_open_cv() :
 		UnaryFunction(Group::Leveling, Name, Desc)
 	{
+		set_destination(Destination::InPlace);
 	}
 
 	//----------------------------------------------------------------------------
 	
-	void auto_level_open_cv::execute(image* src, image* dst)
+	void auto_level_open_cv::execute(image* src, image* dst) const
 	{
 		using namespace cv;
 
@@ -55,7 +55,7 @@ namespace functions
 	{
 	public:
 		auto_level_open_cv();
-		void execute(image* src, image* dst) override;
+		void execute(image* src, image* dst) const override;
 	};
 
 	
@@ -46,41 +46,53 @@ namespace functions
 	static const char Name[] = "bilateral";
 	static const char Desc[] = "Apply bilateral filter to the image. This maintains edges and softens flat regions.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer, "sigma_color", "", value::make_integer(20)),
-		param_desc(ObjectType::Integer, "filter_size", "", value::make_integer(9)),
-		param_desc(ObjectType::Integer, "sigma_space", "", value::make_integer(78)),
-		param_desc(ObjectType::Integer, "iterations", "Number of times to apply the filter", value::make_integer(1))
+	static const param_binding<bilateral_params> Params = {
+		{
+			{ &bilateral_params::src, function::DefaultInput() },
+			{ &bilateral_params::sigma_color, param_desc(ObjectType::Integer, "sigma_color", "", value::make_integer(20)) },
+			{ &bilateral_params::filter_size, param_desc(ObjectType::Integer, "filter_size", "", value::make_integer(9)) },
+			{ &bilateral_params::sigma_space, param_desc(ObjectType::Integer, "sigma_space", "", value::make_integer(78)) },
+			{ &bilateral_params::iterations, param_desc(ObjectType::Integer, "iterations", "Number of times to apply the filter", value::make_integer(1)) }
+		},
+		{ { &bilateral_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	bilateral::bilateral() :
-		function(Group::Filtering, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Filtering, Name, Desc, Params)
+	{
+		set_destination(Destination::InPlace);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::bilateral", "functions/bilateral.h", { "src", "dst", "iterations", "sigma_space", "sigma_color", "filter_size" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool bilateral::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool bilateral::run(context* /*ctx*/, bilateral_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int sigma_space = inputs.get_integer("sigma_space");
-		int sigma_color = inputs.get_integer("sigma_color");
-		int filter_size = inputs.get_integer("filter_size");
-		int iterations  = inputs.get_integer("iterations");
-		image* dst = src->clone();
-		execute(src, dst, iterations, sigma_space, sigma_color, filter_size);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.iterations, p.sigma_space, p.sigma_color, p.filter_size);
 		return true;
 	}
+
+	//----------------------------------------------------------------------------
+
+	int bilateral::get_radius(const kv_dict& inputs) const
+	{
+		// the filter size is derived from sigma_space when it isn't given
+		const int filter_size = inputs.get_integer("filter_size");
+		if (filter_size <= 0)
+			return -1;
+		return std::max(0, inputs.get_integer("iterations")) * (filter_size / 2);
+	}
 	//----------------------------------------------------------------------------
 
 	void bilateral::execute(
 		image* in_src, image* in_dst, 
 		int iterations, 
-		int sigma_space, int sigma_color, int filter_size)
+		int sigma_space, int sigma_color, int filter_size) const
 	{
 		using namespace cv;
 
@@ -34,7 +34,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -47,17 +47,30 @@ namespace image_processing
 namespace functions
 {
 
+	struct bilateral_params
+	{
+		image* src;
+		int    sigma_color;
+		int    filter_size;
+		int    sigma_space;
+		int    iterations;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Bilateral filtering.
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI bilateral : public function
+	class TYCHO_IMAGEPROCESSING_ABI bilateral : public typed_function<bilateral_params>
 	{
 	public:
 		bilateral();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
+		int get_radius(const kv_dict& inputs) const override;
 		virtual void execute(image* src, image* dst,
 			int iterations,
-			int sigma_space, int sigma_color, int filter_size);
+			int sigma_space, int sigma_color, int filter_size) const;
+
+	protected:
+		bool run(context* ctx, bilateral_params& params) const override;
 	};
 
 
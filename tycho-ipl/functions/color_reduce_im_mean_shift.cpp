@@ -56,12 +56,12 @@ namespace functions
 		"kernel_size",
 		"Size of kernel window. Must be odd and greater than 1.",
 		value::make_integer(7),
-		std::bind(validation::odd_only_integer, std::placeholders::_1, std::numeric_limits<int>::max())),
+		validation::odd_only(std::numeric_limits<int>::max())),
 		param_desc(ObjectType::Float,
 		"color_distance",
 		"Euclidean distance to merge colors in the range (0,1)",
 		value::make_float(0.5f),
-		std::bind(validation::unit_float, std::placeholders::_1)),
+		validation::unit()),
 	};
 
 	//----------------------------------------------------------------------------
@@ -74,12 +74,24 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	bool color_reduce_im_mean_shift::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs)
+	bool color_reduce_im_mean_shift::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		if (shapes[0].HasFormat && shapes[0].Format != image::Format::RGB)
+		{
+			message = "source image must be RGB";
+			return false;
+		}
+		return function::infer_shape(args, shapes, out, message);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool color_reduce_im_mean_shift::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs) const
 	{
 		image* src = inputs.get_image("src");
 		int kernel_size = inputs.get_integer("kernel_size");
 		float color_distance = inputs.get_float("color_distance");
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, kernel_size, color_distance);
 		outputs.set_image("dst", dst);
 		return true;
@@ -88,7 +100,7 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	void color_reduce_im_mean_shift::execute(image* in_src, image* in_dst, int kernel_size, float color_distance)
+	void color_reduce_im_mean_shift::execute(image* in_src, image* in_dst, int kernel_size, float color_distance) const
 	{
 		using namespace cv;
 		namespace im = Magick;
@@ -59,8 +59,9 @@ namespace functions
 	public:
 		/// Default constructor
 		color_reduce_im_mean_shift();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int kernel_size, float color_distance);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) const override;
+		virtual void execute(image* src, image* dst, int kernel_size, float color_distance) const;
 	};
 
 	
@@ -56,7 +56,7 @@ namespace functions
 		"num_colors",
 		"Number of colors to reduce the image to. This must be a power of 2 (2, 4, 8, 16, etc).",
 		value::make_integer(256),
-		std::bind(validation::pow2_integer, std::placeholders::_1))
+		validation::pow2())
 	};
 
 	//----------------------------------------------------------------------------
@@ -69,12 +69,24 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	bool color_reduce_im_quantize::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs)
+	bool color_reduce_im_quantize::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		if (shapes[0].HasFormat && shapes[0].Format != image::Format::RGB)
+		{
+			message = "source image must be RGB";
+			return false;
+		}
+		return function::infer_shape(args, shapes, out, message);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool color_reduce_im_quantize::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs) const
 	{
 		image* src = inputs.get_image("src");
 		int num_colors = inputs.get_integer("num_colors");
 
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, num_colors);
 		outputs.set_image("dst", dst);
 		return true;
@@ -83,7 +95,7 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	void color_reduce_im_quantize::execute(image* in_src, image* in_dst, int num_colors)
+	void color_reduce_im_quantize::execute(image* in_src, image* in_dst, int num_colors) const
 	{
 		using namespace cv;
 		namespace im = Magick;
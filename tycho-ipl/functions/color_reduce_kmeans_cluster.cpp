@@ -46,54 +46,48 @@ namespace functions
 	static const char Name[] = "color_reduce_kmeans";
 	static const char Desc[] = "Reduces the number of colors in the image to a specified number.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer,
-		"num_colors",
-		"Number of colors to reduce the image to. Must be greater than 0",
-		value::make_integer(256),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max())),
-
-		param_desc(ObjectType::Integer,
-		"num_attempts",
-		"Number of iterations to search for a result",
-		value::make_integer(1),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max())),
-
-		param_desc(ObjectType::Integer,
-		"term_epsilon",
-		"Termination epsilon",
-		value::make_integer(50),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max())),
-
-		param_desc(ObjectType::Integer,
-		"term_iterations",
-		"Number of iterations to search for a result",
-		value::make_integer(4),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max())),
-
-
+	static const param_binding<color_reduce_kmeans_cluster_params> Params = {
+		{
+			{ &color_reduce_kmeans_cluster_params::src, function::DefaultInput() },
+			{ &color_reduce_kmeans_cluster_params::num_colors, param_desc(ObjectType::Integer,
+				"num_colors",
+				"Number of colors to reduce the image to. Must be greater than 0",
+				value::make_integer(256),
+				validation::positive()) },
+			{ &color_reduce_kmeans_cluster_params::num_attempts, param_desc(ObjectType::Integer,
+				"num_attempts",
+				"Number of iterations to search for a result",
+				value::make_integer(1),
+				validation::positive()) },
+			{ &color_reduce_kmeans_cluster_params::term_epsilon, param_desc(ObjectType::Integer,
+				"term_epsilon",
+				"Termination epsilon",
+				value::make_integer(50),
+				validation::positive()) },
+			{ &color_reduce_kmeans_cluster_params::term_iterations, param_desc(ObjectType::Integer,
+				"term_iterations",
+				"Number of iterations to search for a result",
+				value::make_integer(4),
+				validation::positive()) }
+		},
+		{ { &color_reduce_kmeans_cluster_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	color_reduce_kmeans_cluster::color_reduce_kmeans_cluster() : 
-		function(Group::ColorReduction, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::ColorReduction, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_native("functions::color_reduce_kmeans_cluster", "functions/color_reduce_kmeans_cluster.h", { "src", "dst", "num_colors", "num_attempts", "term_epsilon", "term_iterations" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool color_reduce_kmeans_cluster::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs)
+	bool color_reduce_kmeans_cluster::run(context* /*ctx*/, color_reduce_kmeans_cluster_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int num_colors = inputs.get_integer("num_colors");
-		int num_attempts = inputs.get_integer("num_attempts");
-		int term_epsilon = inputs.get_integer("term_epsilon");
-		int term_iterations = inputs.get_integer("term_iterations");
-
-		image* dst = src->clone();
-		execute(src, dst, num_colors, num_attempts, term_epsilon, term_iterations);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.num_colors, p.num_attempts, p.term_epsilon, p.term_iterations);
 		return true;
 	}
 
@@ -101,7 +95,7 @@ namespace functions
 
 	void color_reduce_kmeans_cluster::execute(image* in_src, image* in_dst,
 		int num_colors, int num_attempts,
-		int term_epsilon, int term_iterations)
+		int term_epsilon, int term_iterations) const
 	{
 		using namespace cv;
 
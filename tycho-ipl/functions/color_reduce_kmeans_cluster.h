@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,21 +48,29 @@ namespace image_processing
 namespace functions
 {
 
+struct color_reduce_kmeans_cluster_params
+{
+	image* src;
+	int    num_colors;
+	int    num_attempts;
+	int    term_epsilon;
+	int    term_iterations;
+	image* dst;
+};
 
 //----------------------------------------------------------------------------
 // Colour reduction using builtin OpenCV K-means clustering algorithm
 //----------------------------------------------------------------------------
-class TYCHO_IMAGEPROCESSING_ABI color_reduce_kmeans_cluster: public function
+class TYCHO_IMAGEPROCESSING_ABI color_reduce_kmeans_cluster: public typed_function<color_reduce_kmeans_cluster_params>
 {
 public:
 	/// Default constructor
 	color_reduce_kmeans_cluster();
-	bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
 	virtual void execute(image* src, image* dst, int num_colors, int num_attempts, 
-		int term_epsilon, int term_iterations);
-
-private:
+		int term_epsilon, int term_iterations) const;
 
+protected:
+	bool run(context* ctx, color_reduce_kmeans_cluster_params& params) const override;
 };
 
 	
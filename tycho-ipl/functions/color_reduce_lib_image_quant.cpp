@@ -48,37 +48,39 @@ namespace functions
 	static const char Name[] = "color_reduce_libimagequant";
 	static const char Desc[] = "Reduces the number of colors in the image to a specified number.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer,
-		"num_colors",
-		"Number of colors to reduce the image to. If it is 0 then it will automatically determine the number of colors.",
-		value::make_integer(256),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max()))
+	static const param_binding<color_reduce_lib_image_quant_params> Params = {
+		{
+			{ &color_reduce_lib_image_quant_params::src, function::DefaultInput() },
+			{ &color_reduce_lib_image_quant_params::num_colors, param_desc(ObjectType::Integer,
+				"num_colors",
+				"Number of colors to reduce the image to. If it is 0 then it will automatically determine the number of colors.",
+				value::make_integer(256),
+				validation::positive()) }
+		},
+		{ { &color_reduce_lib_image_quant_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	color_reduce_lib_image_quant::color_reduce_lib_image_quant() :
-		function(Group::ColorReduction, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::ColorReduction, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_native("functions::color_reduce_lib_image_quant", "functions/color_reduce_lib_image_quant.h", { "src", "dst", "num_colors" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool color_reduce_lib_image_quant::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs)
+	bool color_reduce_lib_image_quant::run(context* /*ctx*/, color_reduce_lib_image_quant_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int num_colors = inputs.get_integer("num_colors");
-
-		image* dst = src->clone();
-		execute(src, dst, num_colors);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.num_colors);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
-	void color_reduce_lib_image_quant::execute(image* in_src, image* in_dst, int num_colors)
+	void color_reduce_lib_image_quant::execute(image* in_src, image* in_dst, int num_colors) const
 	{
 		using namespace cv;
 
@@ -38,7 +38,7 @@
 
 #ifdef HAVE_LIBIMAGEQUANT
 
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -52,17 +52,26 @@ namespace functions
 {
 
 
+	struct color_reduce_lib_image_quant_params
+	{
+		image* src;
+		int    num_colors;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// 
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI color_reduce_lib_image_quant : public function
+	class TYCHO_IMAGEPROCESSING_ABI color_reduce_lib_image_quant : public typed_function<color_reduce_lib_image_quant_params>
 	{
 	public:
 		/// Default constructor
 		color_reduce_lib_image_quant();
 		
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int num_colors);
+		virtual void execute(image* src, image* dst, int num_colors) const;
+
+	protected:
+		bool run(context* ctx, color_reduce_lib_image_quant_params& params) const override;
 	};
 
 	
@@ -58,8 +58,8 @@ namespace functions
 	public:
 		/// Default constructor
 		color_reduce_median_cut();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int num_colors);
+		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) const override;
+		virtual void execute(image* src, image* dst, int num_colors) const;
 	};
 
 
@@ -54,7 +54,7 @@ namespace functions
 		"num_colors",
 		"Number of colors to reduce the image to.",
 		value::make_integer(256),
-		std::bind(validation::positive_integer, std::placeholders::_1, std::numeric_limits<int>::max()))
+		validation::positive())
 	};
 
 	//----------------------------------------------------------------------------
@@ -65,12 +65,12 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	bool color_reduce_population::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs)
+	bool color_reduce_population::dispatch(context * /*ctx*/, const kv_dict & inputs, kv_dict & outputs) const
 	{
 		image* src = inputs.get_image("src");
 		int num_colors = inputs.get_integer("num_colors");
 
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, num_colors);
 		outputs.set_image("dst", dst);
 		return true;
@@ -78,7 +78,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void color_reduce_population::execute(image* /*in_src*/, image* /*in_dst*/, int /*num_colors*/)
+	void color_reduce_population::execute(image* /*in_src*/, image* /*in_dst*/, int /*num_colors*/) const
 	{
 #if 0
 		using namespace cv;
@@ -54,11 +54,14 @@ namespace functions
 
 	copy::copy() :
 		function(Group::Support, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+	{
+		set_destination(Destination::Uninitialised);
+		set_footprint(Footprint::Pointwise);
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool copy::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool copy::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		image* src = inputs.get_image("src");
 
@@ -67,7 +70,7 @@ namespace functions
 		if (inputs.try_get("mask", mask_val) && mask_val.get_type() == ObjectType::Image)
 			mask = mask_val.get_image();
 
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, mask);
 		outputs.set_image("dst", dst);
 		return true;
@@ -75,7 +78,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void copy::execute(image* in_src, image* in_dst, image* mask)
+	void copy::execute(image* in_src, image* in_dst, image* mask) const
 	{
 		IMAGE_PROC_ASSERT(in_src);
 		IMAGE_PROC_ASSERT(in_dst);
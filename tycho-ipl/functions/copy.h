@@ -54,8 +54,8 @@ namespace functions
 	{
 	public:
 		copy();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		void execute(image* src, image* dst, image* mask);
+		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) const override;
+		void execute(image* src, image* dst, image* mask) const;
 	};
 
 
@@ -44,31 +44,43 @@ namespace functions
 {
 	static const char Name[] = "denoise";
 	static const char Desc[] = "Remove noise from the passed image.";
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Float, "strength", "higher removes more noise but will remove more features", value::make_float(3.0f))
+	static const param_binding<denoise_params> Params = {
+		{
+			{ &denoise_params::src, function::DefaultInput() },
+			{ &denoise_params::strength, param_desc(ObjectType::Float, "strength", "higher removes more noise but will remove more features", value::make_float(3.0f)) }
+		},
+		{ { &denoise_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	denoise::denoise() :
-		function(Group::Support, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Support, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::denoise", "functions/denoise.h", { "src", "dst", "strength" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool denoise::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool denoise::run(context* /*ctx*/, denoise_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		float stength = inputs.get_float("strength");
-		image* dst = src->clone();
-		execute(src, dst, stength);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.strength);
 		return true;
 	}
+
+	//----------------------------------------------------------------------------
+
+	int denoise::get_radius(const kv_dict& /*inputs*/) const
+	{
+		// a pixel reads patches centred anywhere in its search window
+		return TemplateWindowSize / 2 + SearchWindowSize / 2;
+	}
 	//----------------------------------------------------------------------------
 
-	void denoise::execute(image* in_src, image* in_dst, float strength)
+	void denoise::execute(image* in_src, image* in_dst, float strength) const
 	{
 		using namespace cv;
 
@@ -79,10 +91,12 @@ namespace functions
 		// this hangs in debug opencv lib
 		src.copyTo(dst);
 #else		
+		// opencv's default colour component strength
+		const float color_strength = 10.0f;
 		if (src.channels() == 1)
-			fastNlMeansDenoising(src, dst, strength);
+			fastNlMeansDenoising(src, dst, strength, TemplateWindowSize, SearchWindowSize);
 		else
-			fastNlMeansDenoisingColored(src, dst, strength);
+			fastNlMeansDenoisingColored(src, dst, strength, color_strength, TemplateWindowSize, SearchWindowSize);
 #endif
 	}
 
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,31 @@ namespace image_processing
 namespace functions
 {
 
+	struct denoise_params
+	{
+		image* src;
+		float  strength;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Noise filter images
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI denoise : public function
+	class TYCHO_IMAGEPROCESSING_ABI denoise : public typed_function<denoise_params>
 	{
+	public:
+		/// Size of the patches compared, and of the window searched for 
+		/// similar patches, around each pixel
+		static const int TemplateWindowSize = 7;
+		static const int SearchWindowSize = 21;
+
 	public:
 		denoise();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float strength);
+		int get_radius(const kv_dict& inputs) const override;
+		virtual void execute(image* src, image* dst, float strength) const;
+
+	protected:
+		bool run(context* ctx, denoise_params& params) const override;
 	};
 
 
@@ -45,52 +45,50 @@ namespace functions
 {
 	static const char Name[] = "edge_canny";
 	static const char Desc[] = "Canny edge detection filter";
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(
-			ObjectType::Integer, 
-			"kernel_size", 
-			"Kernel size for the sobel operator", 
-			value::make_integer(3),
-			std::bind(validation::odd_only_integer, std::placeholders::_1, 9)),
-
-		param_desc(ObjectType::Float, "threshold_low", "First threshold for the hysteresis procedure", value::make_float(25.0f)),
-		param_desc(ObjectType::Float, "threshold_high", "Second threshold for the hysteresis procedure", value::make_float(50.0f)),
-		param_desc(ObjectType::Boolean, "invert", "Invert the results", value::make_boolean(false))
+	static const param_binding<edge_canny_params> Params = {
+		{
+			{ &edge_canny_params::src, function::DefaultInput() },
+			{ &edge_canny_params::kernel_size, param_desc(
+				ObjectType::Integer, 
+				"kernel_size", 
+				"Kernel size for the sobel operator", 
+				value::make_integer(3),
+				validation::odd_only(9)) },
+			{ &edge_canny_params::threshold_low, param_desc(ObjectType::Float, "threshold_low", "First threshold for the hysteresis procedure", value::make_float(25.0f)) },
+			{ &edge_canny_params::threshold_high, param_desc(ObjectType::Float, "threshold_high", "Second threshold for the hysteresis procedure", value::make_float(50.0f)) },
+			{ &edge_canny_params::invert, param_desc(ObjectType::Boolean, "invert", "Invert the results", value::make_boolean(false)) }
+		},
+		{ { &edge_canny_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	edge_canny::edge_canny() :
-		function(Group::EdgeDetection, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::EdgeDetection, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_output_format(image::Format::Grey);
+		set_native("functions::edge_canny", "functions/edge_canny.h", { "src", "dst", "threshold_low", "threshold_high", "kernel_size", "invert" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool edge_canny::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool edge_canny::run(context* /*ctx*/, edge_canny_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int ksize = inputs.get_integer("kernel_size");
-		float tlow = inputs.get_float("threshold_low");
-		float thigh = inputs.get_float("threshold_high");
-		bool invert = inputs.get_boolean("invert");
-
-		image* dst = src->clone();
-		execute(src, dst, tlow, thigh, ksize, invert);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.threshold_low, p.threshold_high, p.kernel_size, p.invert);
 		return true;
 	}
 	//----------------------------------------------------------------------------
 
 	void edge_canny::execute(image* in_src, image* in_dst, 
-		float threshold_low, float threashold_high, int ksize, bool invert)
+		float threshold_low, float threashold_high, int ksize, bool invert) const
 	{
 		using namespace cv;
 
 		IMAGE_PROC_ASSERT((ksize & 1) == 1);
 
 		Mat& src = *in_src->get_opencv();
-		Mat& dst = *in_dst->get_opencv();
 
 		std::vector<cv::Mat> channels;
 		cv::split(src, channels);
@@ -98,8 +96,12 @@ namespace functions
 		{
 			Canny(channels[c], channels[c], threshold_low, threashold_high, ksize);
 		}
-		cv::merge(channels, dst);
-		in_dst->convert_to(in_dst, image::Format::Grey);
+		// the destination may already be single channel, the merged result
+		// keeps the source's format until it is converted
+		image merged;
+		merged.set_mat(Mat(), in_src->get_format());
+		cv::merge(channels, *merged.get_opencv());
+		merged.convert_to(in_dst, image::Format::Grey);
 
 		if (invert)
 			cv::bitwise_not(*in_dst->get_opencv(), *in_dst->get_opencv());
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,27 @@ namespace image_processing
 namespace functions
 {
 
+	struct edge_canny_params
+	{
+		image* src;
+		int    kernel_size;
+		float  threshold_low;
+		float  threshold_high;
+		bool   invert;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Calculate edges using Canny's algorithm
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI edge_canny : public function
+	class TYCHO_IMAGEPROCESSING_ABI edge_canny : public typed_function<edge_canny_params>
 	{
 	public:
 		edge_canny();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float threshold_low, float threashold_high, int ksize, bool invert);
+		virtual void execute(image* src, image* dst, float threshold_low, float threashold_high, int ksize, bool invert) const;
+
+	protected:
+		bool run(context* ctx, edge_canny_params& params) const override;
 	};
 
 
@@ -46,47 +46,55 @@ namespace functions
 	static const char Name[] = "edge_laplacian";
 	static const char Desc[] = "Find edges using laplacian filter";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-
-		param_desc(ObjectType::Integer,
-			"kernel_size", 
-			"Higher increases sensitivity. Must be an odd value.", 
-			value::make_integer(3),
-			std::bind(validation::odd_only_integer, std::placeholders::_1, 9)),
-		
-		param_desc(ObjectType::Boolean, 
-			"invert", 
-			"Invert the results", 
-			value::make_boolean(false))
+	static const param_binding<edge_laplacian_params> Params = {
+		{
+			{ &edge_laplacian_params::src, function::DefaultInput() },
+			{ &edge_laplacian_params::kernel_size, param_desc(ObjectType::Integer,
+				"kernel_size", 
+				"Higher increases sensitivity. Must be an odd value.", 
+				value::make_integer(3),
+				validation::odd_only(9)) },
+			{ &edge_laplacian_params::invert, param_desc(ObjectType::Boolean, 
+				"invert", 
+				"Invert the results", 
+				value::make_boolean(false)) }
+		},
+		{ { &edge_laplacian_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	edge_laplacian::edge_laplacian() :
-		function(Group::EdgeDetection, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::EdgeDetection, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_output_format(image::Format::Grey);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::edge_laplacian", "functions/edge_laplacian.h", { "src", "dst", "kernel_size", "invert" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool edge_laplacian::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool edge_laplacian::run(context* /*ctx*/, edge_laplacian_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int kernel_size = inputs.get_integer("kernel_size");
-		bool invert = inputs.get_boolean("invert");
-		image* dst = src->clone();
-		execute(src, dst, kernel_size, invert);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.kernel_size, p.invert);
 		return true;
 	}
+
+	//----------------------------------------------------------------------------
+
+	int edge_laplacian::get_radius(const kv_dict& inputs) const
+	{
+		return std::max(1, inputs.get_integer("kernel_size") / 2);
+	}
 	//----------------------------------------------------------------------------
 
-	void edge_laplacian::execute(image* in_src, image* in_dst, int kernel_size, bool invert)
+	void edge_laplacian::execute(image* in_src, image* in_dst, int kernel_size, bool invert) const
 	{
 		using namespace cv;
 
 		Mat& src = *in_src->get_opencv();
-		Mat& dst = *in_dst->get_opencv();
 
 		std::vector<cv::Mat> channels;
 		cv::split(src, channels);
@@ -94,8 +102,12 @@ namespace functions
 		{
 			Laplacian(channels[c], channels[c], CV_8U, kernel_size);
 		}
-		cv::merge(channels, dst);
-		in_dst->convert_to(in_dst, image::Format::Grey);
+		// the destination may already be single channel, the merged result
+		// keeps the source's format until it is converted
+		image merged;
+		merged.set_mat(Mat(), in_src->get_format());
+		cv::merge(channels, *merged.get_opencv());
+		merged.convert_to(in_dst, image::Format::Grey);
 
 		if(invert)
 			cv::bitwise_not(*in_dst->get_opencv(), *in_dst->get_opencv());
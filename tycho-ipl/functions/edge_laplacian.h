@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,26 @@ namespace image_processing
 namespace functions
 {
 
+	struct edge_laplacian_params
+	{
+		image* src;
+		int    kernel_size;
+		bool   invert;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Calculate edges using laplacian filter
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI edge_laplacian : public function
+	class TYCHO_IMAGEPROCESSING_ABI edge_laplacian : public typed_function<edge_laplacian_params>
 	{
 	public:
 		edge_laplacian();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int strength, bool invert);
+		int get_radius(const kv_dict& inputs) const override;
+		virtual void execute(image* src, image* dst, int strength, bool invert) const;
+
+	protected:
+		bool run(context* ctx, edge_laplacian_params& params) const override;
 	};
 
 
@@ -46,60 +46,64 @@ namespace functions
 	static const char Name[] = "edge_sobel";
 	static const char Desc[] = "Find edges using Sobel filter";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-
-		param_desc(ObjectType::Integer,
-		"kernel_size",
-		"Higher increases sensitivity. Must be one of 1, 3, 5 or 7.",
-		value::make_integer(3),
-		std::bind(validation::odd_only_integer, std::placeholders::_1, 7)),
-
-		param_desc(ObjectType::Float,
-		"scale",
-		"Scale factor for the computed derivative values",
-		value::make_float(1)),
-
-		param_desc(ObjectType::Float,
-		"delta",
-		"Delta value that is added to the results prior to storing them.",
-		value::make_float(0)),
-
-		param_desc(ObjectType::Boolean,
-		"invert",
-		"Invert the results",
-		value::make_boolean(false))
+	static const param_binding<edge_sobel_params> Params = {
+		{
+			{ &edge_sobel_params::src, function::DefaultInput() },
+			{ &edge_sobel_params::kernel_size, param_desc(ObjectType::Integer,
+				"kernel_size",
+				"Higher increases sensitivity. Must be one of 1, 3, 5 or 7.",
+				value::make_integer(3),
+				validation::odd_only(7)) },
+			{ &edge_sobel_params::scale, param_desc(ObjectType::Float,
+				"scale",
+				"Scale factor for the computed derivative values",
+				value::make_float(1)) },
+			{ &edge_sobel_params::delta, param_desc(ObjectType::Float,
+				"delta",
+				"Delta value that is added to the results prior to storing them.",
+				value::make_float(0)) },
+			{ &edge_sobel_params::invert, param_desc(ObjectType::Boolean,
+				"invert",
+				"Invert the results",
+				value::make_boolean(false)) }
+		},
+		{ { &edge_sobel_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	edge_sobel::edge_sobel() :
-		function(Group::EdgeDetection, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::EdgeDetection, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_output_format(image::Format::Grey);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::edge_sobel", "functions/edge_sobel.h", { "src", "dst", "kernel_size", "scale", "delta", "invert" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool edge_sobel::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool edge_sobel::run(context* /*ctx*/, edge_sobel_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int kernel_size = inputs.get_integer("kernel_size");
-		float scale = inputs.get_float("scale");
-		float delta = inputs.get_float("delta");
-		bool invert = inputs.get_boolean("invert");
-		image* dst = src->clone();
-		execute(src, dst, kernel_size, scale, delta, invert);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.kernel_size, p.scale, p.delta, p.invert);
 		return true;
 	}
+
+	//----------------------------------------------------------------------------
+
+	int edge_sobel::get_radius(const kv_dict& inputs) const
+	{
+		return std::max(1, inputs.get_integer("kernel_size") / 2);
+	}
 	//----------------------------------------------------------------------------
 
 	void edge_sobel::execute(image* in_src, image* in_dst, 
-		int kernel_size, float scale, float delta, bool invert)
+		int kernel_size, float scale, float delta, bool invert) const
 	{
 		using namespace cv;
 
 		Mat& src = *in_src->get_opencv();
-		Mat& dst = *in_dst->get_opencv();
 
 		std::vector<cv::Mat> dst_channels;
 		std::vector<cv::Mat> src_channels;
@@ -115,8 +119,12 @@ namespace functions
 			addWeighted(abs_dx, 0.5, abs_dy, 0.5, 0, res);
 			dst_channels.push_back(res);
 		}
-		cv::merge(dst_channels, dst);
-		in_dst->convert_to(in_dst, image::Format::Grey);
+		// the destination may already be single channel, the merged result
+		// keeps the source's format until it is converted
+		image merged;
+		merged.set_mat(Mat(), in_src->get_format());
+		cv::merge(dst_channels, *merged.get_opencv());
+		merged.convert_to(in_dst, image::Format::Grey);
 
 		if (invert)
 			cv::bitwise_not(*in_dst->get_opencv(), *in_dst->get_opencv());
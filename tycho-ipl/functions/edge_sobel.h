@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,16 +48,29 @@ namespace image_processing
 namespace functions
 {
 
+	struct edge_sobel_params
+	{
+		image* src;
+		int    kernel_size;
+		float  scale;
+		float  delta;
+		bool   invert;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Calculate edges using a Sobel filter
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI edge_sobel : public function
+	class TYCHO_IMAGEPROCESSING_ABI edge_sobel : public typed_function<edge_sobel_params>
 	{
 	public:
 		edge_sobel();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
+		int get_radius(const kv_dict& inputs) const override;
 		virtual void execute(image* src, image* dst, int kernel_size,
-			float scale, float delta, bool invert);
+			float scale, float delta, bool invert) const;
+
+	protected:
+		bool run(context* ctx, edge_sobel_params& params) const override;
 	};
 
 
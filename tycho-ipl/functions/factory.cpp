@@ -188,7 +188,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	function* factory::create(const std::string& name) const
+	const function* factory::create(const std::string& name) const
 	{
 		auto it = m_functions.find(name);
 		if (it != m_functions.end())
@@ -205,14 +205,6 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void factory::enumerate(std::function<void(function*)> func)
-	{
-		for (auto f : m_functions)
-			func(f.second);
-	}
-
-	//----------------------------------------------------------------------------
-
 	void factory::enumerate(std::function<void(const function*)> func) const
 	{
 		for (auto f : m_functions)
@@ -60,20 +60,19 @@ namespace functions
 		/// Destructor
 		~factory();
 
-		/// Create a new function object
-		function* create(const std::string& name) const;
+		/// Get the function object of the passed name. It is shared by every 
+		/// call to it in a program and by every thread running that program, 
+		/// functions must not change any state when they are run.
+		const function* create(const std::string& name) const;
 
 		/// Returns true if a function of the passed name exists
 		bool exists(const std::string& name) const;
 
-		// Enumerate functions
-		void enumerate(std::function<void(function*)>);
-
 		// Enumerate functions
 		void enumerate(std::function<void(const function*)>) const;
 
 	private:
-		using FMap = std::map < std::string, function* > ;
+		using FMap = std::map < std::string, const function* > ;
 
 		FMap m_functions;
 
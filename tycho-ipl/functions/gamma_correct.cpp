@@ -30,8 +30,11 @@
 #include "gamma_correct.h"
 #include "common.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 #include "../context.h"
 
+#include <array>
+
 //----------------------------------------------------------------------------
 // Class
 //----------------------------------------------------------------------------
@@ -45,33 +48,43 @@ namespace functions
 
 	static const char Name[] = "gamma_correct";
 	static const char Desc[] = "Apply gamma correct to an image";
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Float, "gamma", "Gamma correction amount", value::make_float(1))
-	}; 
+	static const param_binding<gamma_correct_params> Params = {
+		{
+			{ &gamma_correct_params::src, function::DefaultInput() },
+			{ &gamma_correct_params::gamma, param_desc(ObjectType::Float, "gamma", "Gamma correction amount", value::make_float(1)) }
+		},
+		{ { &gamma_correct_params::dst, function::DefaultOutput() } }
+	};
+
+	static void build_lut(float gamma, std::array<uint8_t, 256>& lut)
+	{
+		for (int i = 0; i < 256; i++)
+			lut[i] = cv::saturate_cast<uchar>(pow((float)(i / 255.0), gamma) * 255.0f);
+	}
 
 	//----------------------------------------------------------------------------
 
 	gamma_correct::gamma_correct() :
-		function(Group::Leveling, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Leveling, Name, Desc, Params)
+	{
+		set_destination(Destination::InPlace);
+		set_pointwise(true);
+		set_lut_channels(3);
+		set_native("functions::gamma_correct", "functions/gamma_correct.h", { "src", "dst", "gamma" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool gamma_correct::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool gamma_correct::run(context* /*ctx*/, gamma_correct_params& p) const
 	{
-		image* src = inputs.get_image("src");
-
-		float gamma = inputs.get_float("gamma");
-		image* dst = src->clone();
-		execute(src, dst, gamma);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.gamma);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
-	void gamma_correct::execute(image* in_src, image* in_dst, float gamma)
+	void gamma_correct::execute(image* in_src, image* in_dst, float gamma) const
 	{
 		IMAGE_PROC_ASSERT(in_src);
 		IMAGE_PROC_ASSERT(in_dst);
@@ -79,10 +92,8 @@ namespace functions
 		cv::Mat& src = *in_src->get_opencv();
 		cv::Mat& dst = *in_dst->get_opencv();
 
-		unsigned char lut[256];
-
-		for (int i = 0; i < 256; i++)
-			lut[i] = cv::saturate_cast<uchar>(pow((float)(i / 255.0), gamma) * 255.0f);
+		std::array<uint8_t, 256> lut;
+		build_lut(gamma, lut);
 
 		for (int y = 0; y < src.rows; y++)
 		{
@@ -98,6 +109,34 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
+	bool gamma_correct::get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const
+	{
+		build_lut(inputs.get_float("gamma"), lut);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool gamma_correct::get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const
+	{
+		if (kernel.InChannels != 3)
+			return false;
+
+		std::array<uint8_t, 256> lut;
+		build_lut(inputs.get_float("gamma"), lut);
+
+		kernel.OutChannels = 3;
+		kernel.OutFormat = kernel.InFormat;
+		kernel.Row = [lut](const uint8_t* src, uint8_t* dst, int width)
+		{
+			for (int x = 0; x < width * 3; ++x)
+				dst[x] = lut[src[x]];
+		};
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
 } // end namespace
 } // end namespace
 } // end namespace
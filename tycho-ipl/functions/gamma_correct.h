@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,26 @@ namespace image_processing
 namespace functions
 {
 
+	struct gamma_correct_params
+	{
+		image* src;
+		float  gamma;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Apply gamma correction to an image
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI gamma_correct : public function
+	class TYCHO_IMAGEPROCESSING_ABI gamma_correct : public typed_function<gamma_correct_params>
 	{
 	public:
 		gamma_correct();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float gamma);
+		virtual void execute(image* src, image* dst, float gamma) const;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
+		bool get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const override;
+
+	protected:
+		bool run(context* ctx, gamma_correct_params& params) const override;
 	};
 
 
@@ -46,37 +46,48 @@ namespace functions
 	static const char Name[] = "gaussian_blur";
 	static const char Desc[] = "Blur the image using a gaussian filter";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer, "kernel_size", "Size of the kernel", value::make_integer(3)),
-		param_desc(ObjectType::Float, "sigma_x", "Gaussian kernel standard deviation in X direction", value::make_float(0.0f)),
-		param_desc(ObjectType::Float, "sigma_y", "Gaussian kernel standard deviation in Y direction", value::make_float(0.0f))
+	static const param_binding<gaussian_blur_params> Params = {
+		{
+			{ &gaussian_blur_params::src, function::DefaultInput() },
+			{ &gaussian_blur_params::kernel_size, param_desc(ObjectType::Integer, "kernel_size", "Size of the kernel", value::make_integer(3)) },
+			{ &gaussian_blur_params::sigma_x, param_desc(ObjectType::Float, "sigma_x", "Gaussian kernel standard deviation in X direction", value::make_float(0.0f)) },
+			{ &gaussian_blur_params::sigma_y, param_desc(ObjectType::Float, "sigma_y", "Gaussian kernel standard deviation in Y direction", value::make_float(0.0f)) }
+		},
+		{ { &gaussian_blur_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	gaussian_blur::gaussian_blur() :
-		function(Group::Filtering, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Filtering, Name, Desc, Params)
+	{
+		set_destination(Destination::InPlace);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::gaussian_blur", "functions/gaussian_blur.h", { "src", "dst", "kernel_size", "sigma_x", "sigma_y" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool gaussian_blur::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool gaussian_blur::run(context* /*ctx*/, gaussian_blur_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int kernel_size = inputs.get_integer("kernel_size");
-		float sigma_x = inputs.get_float("sigma_x");
-		float sigma_y = inputs.get_float("sigma_y");
-		image* dst = src->clone();
-		execute(src, dst, kernel_size, sigma_x, sigma_y);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.kernel_size, p.sigma_x, p.sigma_y);
 		return true;
 	}
+
+	//----------------------------------------------------------------------------
+
+	int gaussian_blur::get_radius(const kv_dict& inputs) const
+	{
+		// the kernel size is derived from sigma when it isn't given
+		const int kernel_size = inputs.get_integer("kernel_size");
+		return kernel_size > 0 ? kernel_size / 2 : -1;
+	}
 	//----------------------------------------------------------------------------
 
 	void gaussian_blur::execute(image* in_src, image* in_dst, 
-		int ksize, float sigma_x, float sigma_y)
+		int ksize, float sigma_x, float sigma_y) const
 	{
 		using namespace cv;
 
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,27 @@ namespace image_processing
 namespace functions
 {
 
+	struct gaussian_blur_params
+	{
+		image* src;
+		int    kernel_size;
+		float  sigma_x;
+		float  sigma_y;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Guassian filter the image
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI gaussian_blur : public function
+	class TYCHO_IMAGEPROCESSING_ABI gaussian_blur : public typed_function<gaussian_blur_params>
 	{
 	public:
 		gaussian_blur();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int ksize, float sigma_x, float sigma_y);
+		int get_radius(const kv_dict& inputs) const override;
+		virtual void execute(image* src, image* dst, int ksize, float sigma_x, float sigma_y) const;
+
+	protected:
+		bool run(context* ctx, gaussian_blur_params& params) const override;
 	};
 
 
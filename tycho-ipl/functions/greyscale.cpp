@@ -30,8 +30,11 @@
 #include "greyscale.h"
 #include "common.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 #include "../context.h"
 
+#include <cstring>
+
 //----------------------------------------------------------------------------
 // Class
 //----------------------------------------------------------------------------
@@ -51,12 +54,15 @@ namespace functions
 	greyscale::greyscale() :
 		UnaryFunction(Group::Artistic, Name, Desc)
 	{
+		set_destination(Destination::InPlace);
+		set_output_format(image::Format::Grey);
+		set_pointwise(true);
 	}
 
 
 	//----------------------------------------------------------------------------
 
-	void greyscale::execute(image* src, image* dst)
+	void greyscale::execute(image* src, image* dst) const
 	{
 		IMAGE_PROC_ASSERT(src);
 		IMAGE_PROC_ASSERT(dst);
@@ -66,6 +72,59 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
+	bool greyscale::get_pixel_kernel(const kv_dict& /*inputs*/, pixel_kernel& kernel) const
+	{
+		return get_grey_kernel(kernel);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool greyscale::get_grey_kernel(pixel_kernel& kernel)
+	{
+		kernel.OutChannels = 1;
+		kernel.OutFormat = image::Format::Grey;
+
+		if (kernel.InFormat == image::Format::Grey && kernel.InChannels == 1)
+		{
+			kernel.Row = [](const uint8_t* src, uint8_t* dst, int width)
+			{
+				memcpy(dst, src, width);
+			};
+			return true;
+		}
+
+		if (kernel.InChannels != 3)
+			return false;
+
+		if (kernel.InFormat == image::Format::RGB)
+		{
+			// same fixed point weights as OpenCV's BGR2GRAY conversion so the 
+			// results match image::convert_to
+			kernel.Row = [](const uint8_t* src, uint8_t* dst, int width)
+			{
+				const int shift = 14;
+				const int b2y = 1868, g2y = 9617, r2y = 4899;
+				for (int x = 0; x < width; ++x, src += 3)
+					dst[x] = static_cast<uint8_t>((src[0] * b2y + src[1] * g2y + src[2] * r2y + (1 << (shift - 1))) >> shift);
+			};
+			return true;
+		}
+
+		// other formats use their intensity channel directly
+		const int channel = get_intensity_channel(kernel.InFormat);
+		if (channel == -1)
+			return false;
+
+		kernel.Row = [channel](const uint8_t* src, uint8_t* dst, int width)
+		{
+			for (int x = 0; x < width; ++x)
+				dst[x] = src[x * 3 + channel];
+		};
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
 } // end namespace
 } // end namespace
 } // end namespace
@@ -54,7 +54,11 @@ namespace functions
 	{
 	public:		
 		greyscale();
-		void execute(image* src, image* dst) override;
+		void execute(image* src, image* dst) const override;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
+
+		/// Get a kernel converting a row of pixels in the given format to greyscale
+		static bool get_grey_kernel(pixel_kernel& kernel);
 	};
 
 	
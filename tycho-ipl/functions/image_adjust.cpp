@@ -29,8 +29,11 @@
 #include "image_adjust.h"
 #include "common.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 #include "../context.h"
 
+#include <array>
+
 //----------------------------------------------------------------------------
 // Class
 //----------------------------------------------------------------------------
@@ -44,37 +47,40 @@ namespace functions
 
 	static const char Name[] = "image_adjust";
 	static const char Desc[] = "Adjust the contrast and brightness of an image";
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer, "brightness", "Brightness in range [0,255] to add to pixel.", value::make_integer(0)),
-		param_desc(ObjectType::Float, "contrast", "Amount to scale existing pixel by.", value::make_float(0))
+	static const param_binding<image_adjust_params> Params = {
+		{
+			{ &image_adjust_params::src, function::DefaultInput() },
+			{ &image_adjust_params::brightness, param_desc(ObjectType::Integer, "brightness", "Brightness in range [0,255] to add to pixel.", value::make_integer(0)) },
+			{ &image_adjust_params::contrast, param_desc(ObjectType::Float, "contrast", "Amount to scale existing pixel by.", value::make_float(0)) }
+		},
+		{ { &image_adjust_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	image_adjust::image_adjust() :
-		function(Group::Leveling, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Leveling, Name, Desc, Params)
+	{
+		set_destination(Destination::InPlace);
+		set_pointwise(true);
+		set_lut_channels(3);
+		set_native("functions::image_adjust", "functions/image_adjust.h", { "src", "dst", "contrast", "brightness" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool image_adjust::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool image_adjust::run(context* /*ctx*/, image_adjust_params& p) const
 	{
-		image* src = inputs.get_image("src");
-
-		float gain = inputs.get_float("contrast");
-		int bias = inputs.get_integer("brightness");
-		image* dst = src->clone();
-		execute(src, dst, gain, bias);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.contrast, p.brightness);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
 	void image_adjust::execute(image* in_src, image* in_dst, 
-		float gain, int bias)
+		float gain, int bias) const
 	{
 		IMAGE_PROC_ASSERT(in_src);
 		IMAGE_PROC_ASSERT(in_dst);
@@ -97,6 +103,38 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
+	bool image_adjust::get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const
+	{
+		if (kernel.InChannels != 3)
+			return false;
+
+		std::array<uint8_t, 256> lut;
+		get_lut(inputs, lut);
+
+		kernel.OutChannels = 3;
+		kernel.OutFormat = kernel.InFormat;
+		kernel.Row = [lut](const uint8_t* src, uint8_t* dst, int width)
+		{
+			for (int x = 0; x < width * 3; ++x)
+				dst[x] = lut[src[x]];
+		};
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool image_adjust::get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const
+	{
+		const float gain = inputs.get_float("contrast");
+		const int bias = inputs.get_integer("brightness");
+
+		for (int i = 0; i < 256; ++i)
+			lut[i] = cv::saturate_cast<uchar>(gain*i + bias);
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
 } // end namespace
 } // end namespace
 } // end namespace
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,27 @@ namespace image_processing
 namespace functions
 {
 
+	struct image_adjust_params
+	{
+		image* src;
+		int    brightness;
+		float  contrast;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Adjust brightness and contrast of an image
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI image_adjust : public function
+	class TYCHO_IMAGEPROCESSING_ABI image_adjust : public typed_function<image_adjust_params>
 	{
 	public:
 		image_adjust();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float gain, int bias);
+		virtual void execute(image* src, image* dst, float gain, int bias) const;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
+		bool get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const override;
+
+	protected:
+		bool run(context* ctx, image_adjust_params& params) const override;
 	};
 
 
@@ -64,7 +64,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	bool image_load::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool image_load::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		std::string path = inputs.get_string("path");
 		auto* dst = new image(path.c_str());
@@ -89,12 +89,14 @@ namespace functions
 		"save_image",
 		"Write image to disk",
 		SaveInputs, function::NoOutputs(), declaration_list())
-	{}
+	{
+		set_side_effects(true);
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool image_save::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict&)
+	bool image_save::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict&) const
 	{
 		image* src = inputs.get_image("src");
 		std::string path = inputs.get_string("path");
@@ -120,16 +122,42 @@ namespace functions
 			"convert_image",
 			"Convert an image to a different format",
 			ConvertInputs, function::DefaultOutputs(), declaration_list())
-	{}
+	{
+		set_destination(Destination::InPlace);
+		set_footprint(Footprint::Pointwise);
+	}
+
+
+	//----------------------------------------------------------------------------
 
+	bool image_convert::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		out = shapes[0];
+		if (args[1].get_type() != ObjectType::Integer)
+		{
+			out.HasFormat = false;
+			return true;
+		}
+
+		const int format = args[1].get_integer();
+		if (format < 0 || format >= static_cast<int>(image::Format::Count))
+		{
+			message = "unknown image format";
+			return false;
+		}
+
+		out.HasFormat = true;
+		out.Format = static_cast<image::Format>(format);
+		return true;
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool image_convert::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool image_convert::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		image* src = inputs.get_image("src");
 		int format = inputs.get_integer("format");
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, (image::Format)format);
 		outputs.set_image("dst", dst);
 		return true;
@@ -137,7 +165,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void image_convert::execute(image* in_src, image* in_dst, image::Format format)
+	void image_convert::execute(image* in_src, image* in_dst, image::Format format) const
 	{
 		IMAGE_PROC_ASSERT(in_src);
 		IMAGE_PROC_ASSERT(in_dst);
@@ -170,12 +198,30 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	bool image_clamp_size::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool image_clamp_size::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& /*message*/) const
+	{
+		out = shapes[0];
+		if (out.has_size() && 
+			args[1].get_type() == ObjectType::Integer && 
+			args[2].get_type() == ObjectType::Boolean)
+		{
+			image::get_clamped_size(out.Width, out.Height, args[1].get_integer(), args[2].get_boolean());
+		}
+		else
+		{
+			out.Width = out.Height = 0;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool image_clamp_size::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		image* src = inputs.get_image("src");
 		int size = inputs.get_integer("size");
 		bool enlarge = inputs.get_boolean("enlarge");
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, size, enlarge);
 		outputs.set_image("dst", dst);
 		return true;
@@ -183,7 +229,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void image_clamp_size::execute(image* in_src, image* in_dst, int max_size, bool enlarge)
+	void image_clamp_size::execute(image* in_src, image* in_dst, int max_size, bool enlarge) const
 	{
 		using namespace cv;
 
@@ -53,7 +53,7 @@ namespace functions
 	{
 	public:
 		image_load();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override;
 
 	};
 
@@ -62,7 +62,7 @@ namespace functions
 	{
 	public:
 		image_save();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override;
 	};
 
 	
@@ -71,8 +71,9 @@ namespace functions
 	{
 	public:
 		image_convert();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* in_src, image* in_dst, image::Format format);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override;
+		void execute(image* in_src, image* in_dst, image::Format format) const;
 	};
 
 	/// Clamp an image to a given size. If the image is less than the given
@@ -83,8 +84,9 @@ namespace functions
 	{
 	public:
 		image_clamp_size();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* in_src, image* in_dst, int size, bool enlarge);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override;
+		void execute(image* in_src, image* in_dst, int size, bool enlarge) const;
 	};
 
 } // end namespace
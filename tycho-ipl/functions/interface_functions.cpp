@@ -55,12 +55,14 @@ namespace functions
 
 	experiment_add_image::experiment_add_image() :
 		function(Group::Support, Name, Desc, Inputs, function::NoOutputs(), declaration_list())
-	{}
+	{
+		set_side_effects(true);
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool experiment_add_image::dispatch(context* ctx, const kv_dict& inputs, kv_dict& /*outputs*/)
+	bool experiment_add_image::dispatch(context* ctx, const kv_dict& inputs, kv_dict& /*outputs*/) const
 	{
 		image* src = inputs.get_image("src");
 		std::string name = inputs.get_string("name");
@@ -55,7 +55,7 @@ namespace functions
 	{
 	public:
 		experiment_add_image();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
+		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) const override;
 	};
 
 	
@@ -46,41 +46,60 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(
-		ObjectType::Integer,
-		"kernel_size",
-		"Radius around each pixel to examine",
-		value::make_integer(5),
-		std::bind(validation::odd_only_integer, std::placeholders::_1, 255))
+	static const param_binding<kuwahara_params> Params = {
+		{
+			{ &kuwahara_params::src, function::DefaultInput() },
+			{ &kuwahara_params::kernel_size, param_desc(
+				ObjectType::Integer,
+				"kernel_size",
+				"Radius around each pixel to examine",
+				value::make_integer(5),
+				validation::odd_only(255)) }
+		},
+		{ { &kuwahara_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
-	kuwahara::kuwahara() : function(
+	kuwahara::kuwahara() : typed_function(
 		Group::Artistic,
 		"kuwahara",
 		"Apply the kuwahara operator. This smooths textured regions whilst maintaining edges.",
-		Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::kuwahara", "functions/kuwahara.h", { "src", "dst", "kernel_size" });
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool kuwahara::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		if (shapes[0].HasFormat && shapes[0].Format != image::Format::RGB)
+			message = "only RGB images are filtered, the result is undefined";
+		return function::infer_shape(args, shapes, out, message);
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool kuwahara::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool kuwahara::run(context* /*ctx*/, kuwahara_params& p) const
 	{
-		int radius = inputs.get_integer("kernel_size");
-		image *src = inputs.get_image("src");
-		image* dst = src->clone();
-		execute(src, dst, radius);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.kernel_size);
 		return true;
+	}
+
+	//----------------------------------------------------------------------------
 
+	int kuwahara::get_radius(const kv_dict& inputs) const
+	{
+		return std::max(0, (inputs.get_integer("kernel_size") - 1) / 2);
 	}
 
 	//----------------------------------------------------------------------------
 
-	void kuwahara::execute(image* in_src, image* in_dst, int kernel_size)
+	void kuwahara::execute(image* in_src, image* in_dst, int kernel_size) const
 	{
 		cv::Mat& src_mat = *in_src->get_opencv();
 		cv::Mat& dst_mat = *in_dst->get_opencv();
@@ -168,6 +187,11 @@ namespace functions
 				}
 			}
 		}
+		else
+		{
+			// only rgb images are filtered, pass anything else through unchanged
+			src_mat.copyTo(dst_mat);
+		}
 	}
 
 	//----------------------------------------------------------------------------
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 #include "../image.h"
 
 //----------------------------------------------------------------------------
@@ -49,16 +49,27 @@ namespace image_processing
 namespace functions
 {
 
+	struct kuwahara_params
+	{
+		image* src;
+		int    kernel_size;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Kuwahara operator. See https://en.wikipedia.org/wiki/Kuwahara_filter for
 	// details.
  	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI kuwahara : public function
+	class TYCHO_IMAGEPROCESSING_ABI kuwahara : public typed_function<kuwahara_params>
 	{
 	public:
 		kuwahara();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* in_src, image* in_dst, int kernel_size);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		int get_radius(const kv_dict& inputs) const override;
+		void execute(image* in_src, image* in_dst, int kernel_size) const;
+
+	protected:
+		bool run(context* ctx, kuwahara_params& params) const override;
 	};
 
 
@@ -46,52 +46,59 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(
-			ObjectType::Integer,
-			"size",
-			"",
-			value::make_integer(3),
-			std::bind(validation::positive_integer, std::placeholders::_1, 4096)
-		),
-		param_desc(
-			ObjectType::Integer,
-			"element",
-			"Structuring element. One of MORPH_RECT, MORPH_CROSS, MORPH_ELLIPSE.",
-			value::make_integer(cv::MORPH_ELLIPSE)
-		)
+	static const param_binding<morphological_params> Params = {
+		{
+			{ &morphological_params::src, function::DefaultInput() },
+			{ &morphological_params::size, param_desc(
+				ObjectType::Integer,
+				"size",
+				"",
+				value::make_integer(3),
+				validation::positive(4096)
+			) },
+			{ &morphological_params::element, param_desc(
+				ObjectType::Integer,
+				"element",
+				"Structuring element. One of MORPH_RECT, MORPH_CROSS, MORPH_ELLIPSE.",
+				value::make_integer(cv::MORPH_ELLIPSE)
+			) }
+		},
+		{ { &morphological_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	morphological_function::morphological_function(const char* name, const char* desc) :
-		function(Group::Structural, name, desc,  Inputs, function::DefaultOutputs(), declaration_list())
+		typed_function(Group::Structural, name, desc, Params)
 	{
-
+		set_destination(Destination::InPlace);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::morphological_function", "functions/morphological.h", { "src", "dst", "element", "size" });
 	}
 
 	//----------------------------------------------------------------------------
 
-	bool morphological_function::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool morphological_function::run(context* /*ctx*/, morphological_params& p) const
 	{
-		int morph_size = inputs.get_integer("size");
-		int element = inputs.get_integer("element");
-
-		image *src = inputs.get_image("src");
-		image* dst = src->clone();
-		execute(src, dst, element, morph_size);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.element, p.size);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
+	int morphological_function::get_radius(const kv_dict& inputs) const
+	{
+		return std::max(0, inputs.get_integer("size"));
+	}
+
+	//----------------------------------------------------------------------------
+
 	dilate::dilate() :
 		morphological_function("dilate", "dilate the image.")
 	{}
 
-	void dilate::execute(image* in_src, image* in_dst, int elem, int size)
+	void dilate::execute(image* in_src, image* in_dst, int elem, int size) const
 	{
 		using namespace cv;
 
@@ -108,7 +115,7 @@ namespace functions
 		morphological_function("erode", "erode the image.")
 	{}
 
-	void erode::execute(image* in_src, image* in_dst, int elem, int size)
+	void erode::execute(image* in_src, image* in_dst, int elem, int size) const
 	{
 		using namespace cv;
 
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,26 @@ namespace image_processing
 namespace functions
 {
 
+	struct morphological_params
+	{
+		image* src;
+		int    size;
+		int    element;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Base for morphological operation
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI morphological_function : public function
+	class TYCHO_IMAGEPROCESSING_ABI morphological_function : public typed_function<morphological_params>
 	{
 	public:
 		morphological_function(const char* name, const char* desc);
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		virtual void execute(image* in_src, image* in_dst, int elem, int size) = 0;
+		int get_radius(const kv_dict& inputs) const override;
+		virtual void execute(image* in_src, image* in_dst, int elem, int size) const = 0;
+
+	protected:
+		bool run(context* ctx, morphological_params& params) const override;
 	};
 
 
@@ -67,7 +78,7 @@ namespace functions
 	{
 	public:
 		dilate();
-		void execute(image* in_src, image* in_dst, int elem, int size) override;
+		void execute(image* in_src, image* in_dst, int elem, int size) const override;
 	};
 
 
@@ -78,7 +89,7 @@ namespace functions
 	{
 	public:
 		erode();
-		void execute(image* in_src, image* in_dst, int elem, int size) override;
+		void execute(image* in_src, image* in_dst, int elem, int size) const override;
 	};
 
 
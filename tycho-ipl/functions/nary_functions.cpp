@@ -43,69 +43,79 @@ namespace functions
 {
 	//----------------------------------------------------------------------------
 
-	bool UnaryFunction::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	static const param_binding<unary_params> UnaryFuncParams = {
+		{ { &unary_params::src, function::DefaultInput() } },
+		{ { &unary_params::dst, function::DefaultOutput() } }
+	};
+
+	UnaryFunction::UnaryFunction(Group group, const char* name, const char* desc) :
+		typed_function(group, name, desc, UnaryFuncParams)
 	{
-		image* src = inputs.get_image("src");
-		image* dst = src->clone();
-		execute(src, dst);
-		outputs.set_image("dst", dst);
+		set_native("functions::UnaryFunction", "functions/nary_functions.h", { "src", "dst" });
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool UnaryFunction::run(context* /*ctx*/, unary_params& p) const
+	{
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
-	static const std::vector<param_desc> BinaryFuncInputs = {
-		param_desc(ObjectType::Image, "src1", "First source image", value()),
-		param_desc(ObjectType::Image, "src2", "Second source image", value())
+	static const param_binding<binary_params> BinaryFuncParams = {
+		{
+			{ &binary_params::src1, param_desc(ObjectType::Image, "src1", "First source image", value()) },
+			{ &binary_params::src2, param_desc(ObjectType::Image, "src2", "Second source image", value()) }
+		},
+		{ { &binary_params::dst, function::DefaultOutput() } }
 	};
 
 
 	BinaryFunction::BinaryFunction(Group group, const char* name, const char* desc) :
-		function(
-			group, name, desc,
-			BinaryFuncInputs, 
-			function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(group, name, desc, BinaryFuncParams)
+	{
+		set_destination(Destination::InPlace);
+		set_native("functions::BinaryFunction", "functions/nary_functions.h", { "src1", "src2", "dst" });
+	}
 
 	
 	//----------------------------------------------------------------------------
 
-	bool BinaryFunction::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool BinaryFunction::run(context* /*ctx*/, binary_params& p) const
 	{
-		image* src1 = inputs.get_image("src1");
-		image* src2 = inputs.get_image("src2");
-		image* dst = src1->clone();
-		execute(src1, src2, dst);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src1, p.dst);
+		execute(p.src1, p.src2, p.dst);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
-	static const std::vector<param_desc> ScaledBinaryFuncInputs = {
-		param_desc(ObjectType::Image, "src1", "First source image", value()),
-		param_desc(ObjectType::Image, "src2", "Second source image", value()),
-		param_desc(ObjectType::Float, "scale", "Scale factor applied to src1", value::make_float(1))
+	static const param_binding<scaled_binary_params> ScaledBinaryFuncParams = {
+		{
+			{ &scaled_binary_params::src1, param_desc(ObjectType::Image, "src1", "First source image", value()) },
+			{ &scaled_binary_params::src2, param_desc(ObjectType::Image, "src2", "Second source image", value()) },
+			{ &scaled_binary_params::scale, param_desc(ObjectType::Float, "scale", "Scale factor applied to src1", value::make_float(1)) }
+		},
+		{ { &scaled_binary_params::dst, function::DefaultOutput() } }
 	};
 
 	ScaledBinaryFunction::ScaledBinaryFunction(Group group, const char* name, const char* desc) :
-		function(
-		group, name, desc,
-		ScaledBinaryFuncInputs,
-		function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(group, name, desc, ScaledBinaryFuncParams)
+	{
+		set_destination(Destination::InPlace);
+		set_native("functions::ScaledBinaryFunction", "functions/nary_functions.h", { "src1", "scale", "src2", "dst" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool ScaledBinaryFunction::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool ScaledBinaryFunction::run(context* /*ctx*/, scaled_binary_params& p) const
 	{
-		image* src1 = inputs.get_image("src1");
-		image* src2 = inputs.get_image("src2");
-		image* dst = src1->clone();
-		float scale = inputs.get_float("scale");
-		execute(src1, scale, src2, dst);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src1, p.dst);
+		execute(p.src1, p.scale, p.src2, p.dst);
 		return true;
 	}
 
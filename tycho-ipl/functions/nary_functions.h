@@ -34,7 +34,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -47,74 +47,102 @@ namespace image_processing
 namespace functions
 {
 
+	struct unary_params
+	{
+		image* src;
+		image* dst;
+	};
+
+	struct binary_params
+	{
+		image* src1;
+		image* src2;
+		image* dst;
+	};
+
+	struct scaled_binary_params
+	{
+		image* src1;
+		image* src2;
+		float  scale;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Base class for functions that just take single input and output arguments 
 	// (src, dst) of image type.
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI UnaryFunction : public function
+	class TYCHO_IMAGEPROCESSING_ABI UnaryFunction : public typed_function<unary_params>
 	{
 	public:
-		UnaryFunction(Group group, const char* name, const char* desc) :
-			function(group, name, desc, function::DefaultInputs(), function::DefaultOutputs(), declaration_list())
-		{}
+		UnaryFunction(Group group, const char* name, const char* desc);
+		virtual void execute(image* src, image* dst) const = 0;
 
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst) = 0;
+	protected:
+		bool run(context* ctx, unary_params& params) const override;
 	};
 
 	//----------------------------------------------------------------------------
 	// Base class for functions that just take two inputs input and a single 
 	// output arguments (src1, src2, dst) of image type.
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI BinaryFunction : public function
+	class TYCHO_IMAGEPROCESSING_ABI BinaryFunction : public typed_function<binary_params>
 	{
 	public:
 		BinaryFunction(Group group, const char* name, const char* desc);
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		virtual void execute(image* src1, image* src2, image* dst) = 0;
+		virtual void execute(image* src1, image* src2, image* dst) const = 0;
+
+	protected:
+		bool run(context* ctx, binary_params& params) const override;
 	};
 
 	//----------------------------------------------------------------------------
 	// Base class for functions that just take two inputs input and a single 
 	// output arguments (src1 * scale, src2, dst) of image type. 
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI ScaledBinaryFunction : public function
+	class TYCHO_IMAGEPROCESSING_ABI ScaledBinaryFunction : public typed_function<scaled_binary_params>
 	{
 	public:
 		ScaledBinaryFunction(Group group, const char* name, const char* desc);
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		virtual void execute(image* src1, float scale, image* src2, image* dst) = 0;
+		virtual void execute(image* src1, float scale, image* src2, image* dst) const = 0;
+
+	protected:
+		bool run(context* ctx, scaled_binary_params& params) const override;
 	};
 
 #define IMAG_PROC_DECLARE_UNARY_FUNCTION(Name) \
 	class TYCHO_IMAGEPROCESSING_ABI Name : public UnaryFunction \
 					{ public: \
 		Name (); \
-		void execute(image* src, image* dst);	};
+		void execute(image* src, image* dst) const;	};
 
 #define IMAG_PROC_DEFINE_UNARY_FUNCTION(Group, Name, Desc, ClassName) \
 	ClassName :: ClassName() : UnaryFunction(Group, Name, Desc) {} \
-	void ClassName::execute(image* src, image* dst)
+	void ClassName::execute(image* src, image* dst) const
+
+#define IMAG_PROC_DEFINE_UNARY_FUNCTION_FORMAT(Group, Name, Desc, ClassName, Format) \
+	ClassName :: ClassName() : UnaryFunction(Group, Name, Desc) { set_output_format(Format); } \
+	void ClassName::execute(image* src, image* dst) const
 
 #define IMAG_PROC_DECLARE_BINARY_FUNCTION(Name) \
 	class TYCHO_IMAGEPROCESSING_ABI Name : public BinaryFunction \
 			{ public: \
 		Name (); \
-		void execute(image* src1, image* src2, image* dst);	};
+		void execute(image* src1, image* src2, image* dst) const;	};
 
 #define IMAG_PROC_DEFINE_BINARY_FUNCTION(Group, Name, Desc, ClassName) \
 	ClassName :: ClassName() : BinaryFunction(Group, Name, Desc) {} \
-	void ClassName::execute(image* src1, image* src2, image* dst)
+	void ClassName::execute(image* src1, image* src2, image* dst) const
 
 #define IMAG_PROC_DECLARE_SCALED_BINARY_FUNCTION(Name) \
 	class TYCHO_IMAGEPROCESSING_ABI Name : public ScaledBinaryFunction \
 	{ public: \
 		Name (); \
-		void execute(image* src1, float scale, image* src2, image* dst);	};
+		void execute(image* src1, float scale, image* src2, image* dst) const;	};
 
 #define IMAG_PROC_DEFINE_SCALED_BINARY_FUNCTION(Name, Desc, ClassName) \
 	ClassName :: ClassName() : ScaledBinaryFunction(Group::Arithmetic, Name, Desc) {} \
-	void ClassName::execute(image* src1, float scale, image* src2, image* dst)
+	void ClassName::execute(image* src1, float scale, image* src2, image* dst) const
 
 } // end namespace
 } // end namespace
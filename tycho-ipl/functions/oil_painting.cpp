@@ -46,46 +46,64 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(
-		ObjectType::Integer,
-		"kernel_size",
-		"Radius around each pixel to examine",
-		value::make_integer(5)),
-		param_desc(
-		ObjectType::Integer,
-		"levels",
-		"Number of intensity levels",
-		value::make_integer(20)),
+	static const param_binding<oil_painting_params> Params = {
+		{
+			{ &oil_painting_params::src, function::DefaultInput() },
+			{ &oil_painting_params::kernel_size, param_desc(
+				ObjectType::Integer,
+				"kernel_size",
+				"Radius around each pixel to examine",
+				value::make_integer(5)) },
+			{ &oil_painting_params::levels, param_desc(
+				ObjectType::Integer,
+				"levels",
+				"Number of intensity levels",
+				value::make_integer(20)) }
+		},
+		{ { &oil_painting_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
-	oil_painting::oil_painting() : function(
+	oil_painting::oil_painting() : typed_function(
 		Group::Artistic,
 		"oil_painting",
 		"Transform the image to have an oil painted appearance",
-		Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_footprint(Footprint::Neighbourhood);
+		set_native("functions::oil_painting", "functions/oil_painting.h", { "src", "dst", "kernel_size", "levels" });
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool oil_painting::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		if (shapes[0].HasFormat && shapes[0].Format != image::Format::RGB)
+			message = "only RGB images are filtered, the result is undefined";
+		return function::infer_shape(args, shapes, out, message);
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool oil_painting::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool oil_painting::run(context* /*ctx*/, oil_painting_params& p) const
 	{
-		int radius = inputs.get_integer("kernel_size");
-		int levels = inputs.get_integer("levels");
-		image *src = inputs.get_image("src");
-		image* dst = src->clone();
-		execute(src, dst, radius, levels);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.kernel_size, p.levels);
 		return true;
+	}
+
+	//----------------------------------------------------------------------------
 
+	int oil_painting::get_radius(const kv_dict& inputs) const
+	{
+		return std::max(0, (inputs.get_integer("kernel_size") - 1) / 2);
 	}
 
 	//----------------------------------------------------------------------------
 
-	void oil_painting::execute(image* in_src, image* in_dst, int kernel_size, int num_levels)
+	void oil_painting::execute(image* in_src, image* in_dst, int kernel_size, int num_levels) const
 	{
 		// http://supercomputingblog.com/graphics/oil-painting-algorithm/
 
@@ -147,6 +165,11 @@ namespace functions
 				}
 			}
 		}
+		else
+		{
+			// only rgb images are filtered, pass anything else through unchanged
+			src_mat.copyTo(dst_mat);
+		}
 	}
 
 	//----------------------------------------------------------------------------
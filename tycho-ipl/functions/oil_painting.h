@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 #include "../image.h"
 
 //----------------------------------------------------------------------------
@@ -49,15 +49,27 @@ namespace image_processing
 namespace functions
 {
 
+	struct oil_painting_params
+	{
+		image* src;
+		int    kernel_size;
+		int    levels;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Transforms the image to appear more like an oil painting
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI oil_painting : public function
+	class TYCHO_IMAGEPROCESSING_ABI oil_painting : public typed_function<oil_painting_params>
 	{
 	public:
 		oil_painting();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* in_src, image* in_dst, int kernel_size, int num_levels);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		int get_radius(const kv_dict& inputs) const override;
+		void execute(image* in_src, image* in_dst, int kernel_size, int num_levels) const;
+
+	protected:
+		bool run(context* ctx, oil_painting_params& params) const override;
 	};
 
 
@@ -30,6 +30,7 @@
 #include "remove_intensity.h"
 #include "common.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 #include "../context.h"
 
 
@@ -46,18 +47,21 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(
-			ObjectType::Integer, 
-			"black-cutoff", 
-			"Value under which the sum (A + G + B) will be clamped to 0", 
-			value::make_integer(64))
+	static const param_binding<remove_intensity_params> Params = {
+		{
+			{ &remove_intensity_params::src, function::DefaultInput() },
+			{ &remove_intensity_params::black_cutoff, param_desc(
+				ObjectType::Integer, 
+				"black-cutoff", 
+				"Value under which the sum (A + G + B) will be clamped to 0", 
+				value::make_integer(64)) }
+		},
+		{ { &remove_intensity_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
-	remove_intensity::remove_intensity() : function(
+	remove_intensity::remove_intensity() : typed_function(
 		Group::Support,
 		"remove_intensity",
 		"Removes the intensity from the image. If the image is in a colour space that " \
@@ -65,25 +69,25 @@ namespace functions
 		"image is in RGB space then each texel is normalized as sum = R + G + B, " \
 		"R' = R / sum, G' = G / sum, B' = B / sum. If sum is less than black-cutoff " \
 		"then it is clamped to zero.",
-		Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		Params)
+	{
+		set_destination(Destination::InPlace);
+		set_pointwise(true);
+		set_native("functions::remove_intensity", "functions/remove_intensity.h", { "src", "dst", "black-cutoff" });
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool remove_intensity::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool remove_intensity::run(context* /*ctx*/, remove_intensity_params& p) const
 	{
-		int cutoff = inputs.get_integer("black-cutoff");
-		image *src = inputs.get_image("src");
-		image* dst = src->clone();
-		execute(src, dst, cutoff);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.black_cutoff);
 		return true;
-
 	}
 
 	//----------------------------------------------------------------------------
 
-	void remove_intensity::execute(image* in_src, image* in_dst, int black_cutoff)
+	void remove_intensity::execute(image* in_src, image* in_dst, int black_cutoff) const
 	{
 		cv::Mat& src_mat = *in_src->get_opencv();
 		cv::Mat& dst_mat = *in_dst->get_opencv();
@@ -126,6 +130,60 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
+	bool remove_intensity::get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const
+	{
+		if (kernel.InChannels != 3)
+			return false;
+
+		kernel.OutChannels = 3;
+		kernel.OutFormat = kernel.InFormat;
+
+		if (kernel.InFormat == image::Format::RGB)
+		{
+			const int black_cutoff = inputs.get_integer("black-cutoff");
+			kernel.Row = [black_cutoff](const uint8_t* src, uint8_t* dst, int width)
+			{
+				for (int x = 0; x < width * 3; x += 3)
+				{
+					double sum = src[x + 0] + src[x + 1] + src[x + 2];
+					for (int c = 0; c < 3; ++c)
+					{
+						double val = src[x + c];
+						if (sum > black_cutoff)
+						{
+							val /= sum;
+							val *= 255;
+						}
+						else
+							val = 0;
+
+						dst[x + c] = cv::saturate_cast<uchar>(val);
+					}
+				}
+			};
+		}
+		else
+		{
+			const int channel = get_intensity_channel(kernel.InFormat);
+			if (channel == -1)
+				return false;
+
+			kernel.Row = [channel](const uint8_t* src, uint8_t* dst, int width)
+			{
+				for (int x = 0; x < width * 3; x += 3)
+				{
+					dst[x + 0] = src[x + 0];
+					dst[x + 1] = src[x + 1];
+					dst[x + 2] = src[x + 2];
+					dst[x + channel] = 0;
+				}
+			};
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
 
 } // end namespace
 } // end namespace
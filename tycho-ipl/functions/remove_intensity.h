@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 #include "../image.h"
 
 //----------------------------------------------------------------------------
@@ -49,6 +49,13 @@ namespace image_processing
 namespace functions
 { 
 
+	struct remove_intensity_params
+	{
+		image* src;
+		int    black_cutoff;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Removes intensity from the image depending on the passed image type.
 	// 
@@ -56,12 +63,15 @@ namespace functions
 	// Normalise in RGB space by normalising each component
 	// using C / (R + G + B) with C in [R, G, B]. 
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI remove_intensity : public function
+	class TYCHO_IMAGEPROCESSING_ABI remove_intensity : public typed_function<remove_intensity_params>
 	{
 	public:
 		remove_intensity();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* in_src, image* in_dst, int cutoff);
+		void execute(image* in_src, image* in_dst, int cutoff) const;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
+
+	protected:
+		bool run(context* ctx, remove_intensity_params& params) const override;
 	};
 
 	
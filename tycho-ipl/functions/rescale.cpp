@@ -46,34 +46,67 @@ namespace functions
 	static const char Name[] = "rescale";
 	static const char Desc[] = "Proportionally resize an image";
 	
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Float, "scale_x", "Amount to scale width", value::make_float(1.0f)),
-		param_desc(ObjectType::Float, "scale_y", "Amount to scale height", value::make_float(1.0f))
-		};
+	static const param_binding<rescale_params> Params = {
+		{
+			{ &rescale_params::src, function::DefaultInput() },
+			{ &rescale_params::scale_x, param_desc(ObjectType::Float, "scale_x", "Amount to scale width", value::make_float(1.0f)) },
+			{ &rescale_params::scale_y, param_desc(ObjectType::Float, "scale_y", "Amount to scale height", value::make_float(1.0f)) }
+		},
+		{ { &rescale_params::dst, function::DefaultOutput() } }
+	};
 
 	//----------------------------------------------------------------------------
 
 	rescale::rescale() :
-		function(Group::Support, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		typed_function(Group::Support, Name, Desc, Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_native("functions::rescale", "functions/rescale.h", { "src", "dst", "scale_x", "scale_y" });
+	}
+
+
+	//----------------------------------------------------------------------------
 
+	bool rescale::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		out = shapes[0];
+		if (args[1].get_type() != ObjectType::Float || args[2].get_type() != ObjectType::Float)
+		{
+			out.Width = out.Height = 0;
+			return true;
+		}
+
+		if (args[1].get_float() <= 0.0f || args[2].get_float() <= 0.0f)
+		{
+			message = "scale must be greater than zero";
+			return false;
+		}
+
+		// scaled as execute() does
+		if (out.has_size())
+		{
+			out.Width = (int)(out.Width * args[1].get_float());
+			out.Height = (int)(out.Height * args[2].get_float());
+			if (!out.has_size())
+			{
+				message = "image is scaled to nothing";
+				return false;
+			}
+		}
+		return true;
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool rescale::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool rescale::run(context* /*ctx*/, rescale_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		float scale_x = inputs.get_float("scale_x");
-		float scale_y = inputs.get_float("scale_y");
-		image* dst = src->clone();
-		execute(src, dst, scale_x, scale_y);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.scale_x, p.scale_y);
 		return true;
 	}
 	//----------------------------------------------------------------------------
 
-	void rescale::execute(image* in_src, image* in_dst, float scale_x, float scale_y)
+	void rescale::execute(image* in_src, image* in_dst, float scale_x, float scale_y) const
 	{
 		using namespace cv;
 
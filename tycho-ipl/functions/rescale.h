@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,26 @@ namespace image_processing
 namespace functions
 {
 
+	struct rescale_params
+	{
+		image* src;
+		float  scale_x;
+		float  scale_y;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Rescale an image
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI rescale : public function
+	class TYCHO_IMAGEPROCESSING_ABI rescale : public typed_function<rescale_params>
 	{
 	public:
 		rescale();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float scale_x, float scale_y);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		virtual void execute(image* src, image* dst, float scale_x, float scale_y) const;
+
+	protected:
+		bool run(context* ctx, rescale_params& params) const override;
 	};
 
 
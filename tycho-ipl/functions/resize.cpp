@@ -51,28 +51,67 @@ namespace functions
 		param_desc(ObjectType::Float, "height", "New height", value())
 	};
 
+	/// The size can be given as an integer, i.e. __width__, or a float
+	static bool get_size(const value& val, int& size)
+	{
+		if (val.get_type() == ObjectType::Integer)
+			size = val.get_integer();
+		else if (val.get_type() == ObjectType::Float)
+			size = static_cast<int>(val.get_float());
+		else
+			return false;
+		return true;
+	}
+
 	//----------------------------------------------------------------------------
 
 	resize::resize() :
 		function(Group::Support, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+	{
+		set_destination(Destination::Uninitialised);
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool resize::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool resize::infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const
+	{
+		out = shapes[0];
+		if (!get_size(args[1], out.Width) || !get_size(args[2], out.Height))
+		{
+			out.Width = out.Height = 0;
+			return true;
+		}
+
+		if (!out.has_size())
+		{
+			message = "width and height must be greater than zero";
+			return false;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool resize::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		image* src = inputs.get_image("src");
-		int width = inputs.get_integer("width");
-		int height = inputs.get_integer("height");
-		image* dst = src->clone();
+		value width_arg, height_arg;
+		inputs.try_get("width", width_arg);
+		inputs.try_get("height", height_arg);
+
+		int width = 0;
+		int height = 0;
+		get_size(width_arg, width);
+		get_size(height_arg, height);
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, width, height);
 		outputs.set_image("dst", dst);
 		return true;
 	}
 	//----------------------------------------------------------------------------
 
-	void resize::execute(image* in_src, image* in_dst, int width, int height)
+	void resize::execute(image* in_src, image* in_dst, int width, int height) const
 	{
 		cv::Mat& src = *in_src->get_opencv();
 		cv::Mat& dst = *in_dst->get_opencv();
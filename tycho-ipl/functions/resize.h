@@ -55,8 +55,9 @@ namespace functions
 	{
 	public:
 		resize();
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int width, int height);
+		bool infer_shape(const value* args, const image_shape* shapes, image_shape& out, std::string& message) const override;
+		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) const override;
+		virtual void execute(image* src, image* dst, int width, int height) const;
 	};
 
 
@@ -32,6 +32,7 @@
 #include "../key_value.h"
 #include "../context.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -52,12 +53,14 @@ namespace functions
 	sepia_rgb::sepia_rgb() :
 		UnaryFunction(Group::Artistic, Name, Desc)
 	{
+		set_destination(Destination::Uninitialised);
+		set_pointwise(true);
 	}
 
 
 	//----------------------------------------------------------------------------
 
-	void sepia_rgb::execute(image* src, image* dst)
+	void sepia_rgb::execute(image* src, image* dst) const
 	{
 		IMAGE_PROC_ASSERT(src);
 		IMAGE_PROC_ASSERT(dst);
@@ -86,6 +89,30 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
+	bool sepia_rgb::get_pixel_kernel(const kv_dict& /*inputs*/, pixel_kernel& kernel) const
+	{
+		if (kernel.InChannels != 3)
+			return false;
+
+		kernel.OutChannels = 3;
+		kernel.OutFormat = kernel.InFormat;
+		kernel.Row = [](const uint8_t* src, uint8_t* dst, int width)
+		{
+			for (int x = 0; x < width * 3; x += 3)
+			{
+				const float b = src[x + 0];
+				const float g = src[x + 1];
+				const float r = src[x + 2];
+				dst[x + 0] = cv::saturate_cast<uchar>(0.272f * b + 0.534f * g + 0.131f * r);
+				dst[x + 1] = cv::saturate_cast<uchar>(0.349f * b + 0.686f * g + 0.168f * r);
+				dst[x + 2] = cv::saturate_cast<uchar>(0.393f * b + 0.769f * g + 0.189f * r);
+			}
+		};
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
 
 } // end namespace
 } // end namespace
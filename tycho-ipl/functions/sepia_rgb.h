@@ -55,7 +55,8 @@ namespace functions
 	{
 	public:
 		sepia_rgb();
-		void execute(image* src, image* dst) override;
+		void execute(image* src, image* dst) const override;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
 	};
 
 	
@@ -47,36 +47,40 @@ namespace functions
 	static const char Name[] = "sepia_yiq";
 	static const char Desc[] = "Sepia tone effect calculated in YIQ space. Results in a deeper brown colour than sepia_rgb.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer, "offset", "Colour offset to move around the default sepia tone."),
+	static const param_binding<sepia_yiq_params> Params = {
+		{
+			{ &sepia_yiq_params::src, function::DefaultInput() },
+			{ &sepia_yiq_params::offset, param_desc(ObjectType::Integer, "offset", "Colour offset to move around the default sepia tone.") }
+		},
+		{ { &sepia_yiq_params::dst, function::DefaultOutput() } }
 	};
 
 	//----------------------------------------------------------------------------
 
 	sepia_yiq::sepia_yiq() :
-		function(
+		typed_function(
 		Group::Artistic, 
 		Name, Desc,
-		Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+		Params)
+	{
+		set_destination(Destination::Uninitialised);
+		set_footprint(Footprint::Pointwise);
+		set_native("functions::sepia_yiq", "functions/sepia_yiq.h", { "src", "dst", "offset" });
+	}
 
 
 	//----------------------------------------------------------------------------
 
-	bool sepia_yiq::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool sepia_yiq::run(context* /*ctx*/, sepia_yiq_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int size = inputs.get_integer("offset");
-		image* dst = src->clone();
-		execute(src, dst, size);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.offset);
 		return true;
 	}
 
 	//----------------------------------------------------------------------------
 
-	void sepia_yiq::execute(image* src, image* dst, int offset)
+	void sepia_yiq::execute(image* src, image* dst, int offset) const
 	{
 		// Converts into YIQ space using the following formula
 		//		Y = 0.299 * R + 0.587 * G + 0.114 * B
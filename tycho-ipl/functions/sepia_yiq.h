@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../functions/nary_functions.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,15 +48,24 @@ namespace image_processing
 namespace functions
 {
 
+	struct sepia_yiq_params
+	{
+		image* src;
+		int    offset;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Sepia tone effect calculated in YIQ space.
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI sepia_yiq : public function
+	class TYCHO_IMAGEPROCESSING_ABI sepia_yiq : public typed_function<sepia_yiq_params>
 	{
 	public:
 		sepia_yiq();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		void execute(image* src, image* dst, int offset);
+		void execute(image* src, image* dst, int offset) const;
+
+	protected:
+		bool run(context* ctx, sepia_yiq_params& params) const override;
 	};
 
 	
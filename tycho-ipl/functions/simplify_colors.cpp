@@ -74,12 +74,12 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 
-	bool simplify_colors::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool simplify_colors::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs) const
 	{
 		float merge_distance = inputs.get_float("merge_distance");
 		float min_coverage = inputs.get_float("min_coverage");
 		image* src = inputs.get_image("src");
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst, merge_distance, min_coverage);
 		outputs.set_image("dst", dst);
 		return true;
@@ -192,7 +192,7 @@ namespace functions
 		}
 	}
 
-	void simplify_colors::execute(image* in_src, image* in_dst, float merge_dist, float min_coverage)
+	void simplify_colors::execute(image* in_src, image* in_dst, float merge_dist, float min_coverage) const
 	{
 		using namespace cv;
 
@@ -56,8 +56,8 @@ namespace functions
 	{
 	public:
 		simplify_colors();
-		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, float merge_distance, float min_coverage);
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override;
+		virtual void execute(image* src, image* dst, float merge_distance, float min_coverage) const;
 	};
 
 
@@ -28,11 +28,15 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "threshold.h"
+#include "greyscale.h"
 #include "common.h"
 #include "../image.h"
+#include "../pixel_kernel.h"
 #include "../context.h"
 #include "../program.h"
 
+#include <array>
+
 
 //----------------------------------------------------------------------------
 // Class
@@ -47,17 +51,20 @@ namespace functions
 	static const char Name[] = "threshold";
 	static const char Desc[] = "Remove noise from the passed image.";
 
-	static const std::vector<param_desc> Inputs = {
-		function::DefaultInput(),
-		param_desc(ObjectType::Integer, 
-			"threshold", 
-			"Threshold value",
-			value::make_integer(127)),
-		param_desc(ObjectType::Integer,
-			"maxval", 
-			"Maximum value to use with the THRESH_BINARY and THRESH_BINARY_INV thresholding types",
-			value::make_integer(127)),
-		param_desc(ObjectType::Integer, "type", "Thresholding type")
+	static const param_binding<threshold_params> Params = {
+		{
+			{ &threshold_params::src, function::DefaultInput() },
+			{ &threshold_params::threshold, param_desc(ObjectType::Integer, 
+				"threshold", 
+				"Threshold value",
+				value::make_integer(127)) },
+			{ &threshold_params::maxval, param_desc(ObjectType::Integer,
+				"maxval", 
+				"Maximum value to use with the THRESH_BINARY and THRESH_BINARY_INV thresholding types",
+				value::make_integer(127)) },
+			{ &threshold_params::type, param_desc(ObjectType::Integer, "type", "Thresholding type") }
+		},
+		{ { &threshold_params::dst, function::DefaultOutput() } }
 	};
 
 	static const declaration_list Constants = {
@@ -71,26 +78,36 @@ namespace functions
 	//----------------------------------------------------------------------------
 
 	threshold::threshold() :
-		function(Group::Filtering, Name, Desc, Inputs, function::DefaultOutputs(), Constants)
-	{}
+		typed_function(Group::Filtering, Name, Desc, Params, Constants)
+	{
+		set_destination(Destination::InPlace);
+		set_output_format(image::Format::Grey);
+		set_pointwise(true);
+		set_lut_channels(1);
+		set_native("functions::threshold", "functions/threshold.h", { "src", "dst", "threshold", "maxval", "type" });
+	}
 
 	//----------------------------------------------------------------------------
 
 
-	bool threshold::dispatch(context* /*ctx*/, const kv_dict& inputs, kv_dict& outputs)
+	bool threshold::run(context* /*ctx*/, threshold_params& p) const
 	{
-		image* src = inputs.get_image("src");
-		int threshold = inputs.get_integer("threshold");
-		int maxval = inputs.get_integer("maxval");
-		int type = inputs.get_integer("type");
-		image* dst = src->clone();
-		execute(src, dst, threshold, maxval, type);
-		outputs.set_image("dst", dst);
+		p.dst = acquire_destination(p.src, p.dst);
+		execute(p.src, p.dst, p.threshold, p.maxval, p.type);
 		return true;
 	}
+
 	//----------------------------------------------------------------------------
 
-	void threshold::execute(image* in_src, image* in_dst, int threshold, int maxval, int type)
+	int threshold::get_radius(const kv_dict& inputs) const
+	{
+		// automatic threshold selection needs the whole image
+		const int type = inputs.get_integer("type");
+		return type >= cv::THRESH_BINARY && type <= cv::THRESH_TOZERO_INV ? 0 : -1;
+	}
+	//----------------------------------------------------------------------------
+
+	void threshold::execute(image* in_src, image* in_dst, int threshold, int maxval, int type) const
 	{
 		using namespace cv;
 		image intensity {};
@@ -103,7 +120,63 @@ namespace functions
 		Mat& src = *in_src->get_opencv();
 		Mat& dst = *in_dst->get_opencv();
 		
-		cv::threshold(src, dst, threshold, maxval, type);;
+		// the result is always single channel, tagged as the fused kernel does
+		cv::threshold(src, dst, threshold, maxval, type);
+		const Mat result = dst;
+		in_dst->set_mat(result, image::Format::Grey);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool threshold::get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const
+	{
+		std::array<uint8_t, 256> lut;
+		if (!get_lut(inputs, lut))
+			return false;
+
+		// thresholding is always done on the intensity, as in execute()
+		pixel_kernel grey;
+		grey.InFormat = kernel.InFormat;
+		grey.InChannels = kernel.InChannels;
+		if (!greyscale::get_grey_kernel(grey))
+			return false;
+
+		kernel.OutChannels = 1;
+		kernel.OutFormat = image::Format::Grey;
+		kernel.Row = [lut, grey](const uint8_t* src, uint8_t* dst, int width)
+		{
+			grey.Row(src, dst, width);
+			for (int x = 0; x < width; ++x)
+				dst[x] = lut[dst[x]];
+		};
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool threshold::get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const
+	{
+		const int thresh = inputs.get_integer("threshold");
+		const uint8_t maxval = cv::saturate_cast<uchar>(inputs.get_integer("maxval"));
+		const int type = inputs.get_integer("type");
+
+		// automatic threshold selection needs the whole image
+		if (type < cv::THRESH_BINARY || type > cv::THRESH_TOZERO_INV)
+			return false;
+
+		for (int i = 0; i < 256; ++i)
+		{
+			const bool above = i > thresh;
+			switch (type)
+			{
+			case cv::THRESH_BINARY:		lut[i] = above ? maxval : 0; break;
+			case cv::THRESH_BINARY_INV:	lut[i] = above ? 0 : maxval; break;
+			case cv::THRESH_TRUNC:		lut[i] = above ? cv::saturate_cast<uchar>(thresh) : static_cast<uint8_t>(i); break;
+			case cv::THRESH_TOZERO:		lut[i] = above ? static_cast<uint8_t>(i) : 0; break;
+			default:					lut[i] = above ? 0 : static_cast<uint8_t>(i); break;
+			}
+		}
+		return true;
 	}
 
 	//----------------------------------------------------------------------------
@@ -35,7 +35,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
-#include "../function.h"
+#include "../typed_function.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -48,16 +48,30 @@ namespace image_processing
 namespace functions
 {
 
+	struct threshold_params
+	{
+		image* src;
+		int    threshold;
+		int    maxval;
+		int    type;
+		image* dst;
+	};
+
 	//----------------------------------------------------------------------------
 	// Threshold the image values
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI threshold : public function
+	class TYCHO_IMAGEPROCESSING_ABI threshold : public typed_function<threshold_params>
 	{
 	public:
 		threshold();
 		declaration_list GetConstants() const;
-		bool dispatch(context* ctx, const kv_dict& kwargs, kv_dict& outputs) override;
-		virtual void execute(image* src, image* dst, int threshold, int maxval, int type);
+		int get_radius(const kv_dict& inputs) const override;
+		virtual void execute(image* src, image* dst, int threshold, int maxval, int type) const;
+		bool get_pixel_kernel(const kv_dict& inputs, pixel_kernel& kernel) const override;
+		bool get_lut(const kv_dict& inputs, std::array<uint8_t, 256>& lut) const override;
+
+	protected:
+		bool run(context* ctx, threshold_params& params) const override;
 	};
 
 
@@ -57,14 +57,26 @@ namespace functions
 
 	visualize_palette::visualize_palette() :
 		function(Group::Support, Name, Desc, Inputs, function::DefaultOutputs(), declaration_list())
-	{}
+	{
+		set_destination(Destination::Uninitialised);
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool visualize_palette::infer_shape(const value* /*args*/, const image_shape* shapes, image_shape& out, std::string& /*message*/) const
+	{
+		// the palette is drawn beside the image so the size depends on its colours
+		out = shapes[0];
+		out.Width = out.Height = 0;
+		return true;
+	}
 
 	//----------------------------------------------------------------------------
 
-	bool visualize_palette::dispatch(context * /*ctx*/, const kv_dict &inputs, kv_dict & outputs)
+	bool visualize_palette::dispatch(context * /*ctx*/, const kv_dict &inputs, kv_dict & outputs) const
 	{
 		image* src = inputs.get_image("src");
-		image* dst = src->clone();
+		image* dst = acquire_destination(src, outputs);
 		execute(src, dst);
 		outputs.set_image("dst", dst);
 		return true;
@@ -72,7 +84,7 @@ namespace functions
 
 	//----------------------------------------------------------------------------
 
-	void visualize_palette::execute(image *in_src, image *in_dst)
+	void visualize_palette::execute(image *in_src, image *in_dst) const
 	{
 		std::set<uint32_t> unique_clrs;
 
@@ -29,9 +29,13 @@
 //----------------------------------------------------------------------------
 #include "image.h"
 #include "functions/common.h"
+#include "qoi_codec.h"
 #include "opencv2/imgproc/types_c.h"
 #include "opencv2/imgproc/imgproc_c.h"
 
+#include <algorithm>
+#include <map>
+
 //----------------------------------------------------------------------------
 // Class
 //----------------------------------------------------------------------------
@@ -66,7 +70,15 @@ namespace image_processing
 	{
 		IMAGE_PROC_ASSERT(src);
 
-		auto mat = cv::imread(src, 1);
+		cv::Mat mat;
+		if (qoi::has_extension(src))
+		{
+			// alpha is dropped as imread does for other formats
+			if (qoi::read_file(src, mat) && mat.channels() == 4)
+				cv::cvtColor(mat, mat, cv::COLOR_BGRA2BGR);
+		}
+		else
+			mat = cv::imread(src, 1);
 		if (mat.dims == 0)
 			throw image_read_error(src);
 		set_mat(mat, mat.channels() == 1 ? Format::Grey : Format::RGB);
@@ -98,6 +110,17 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	image* image::clone_uninitialised() const
+	{
+		auto *c = new image();
+		c->m_CVMat = new cv::Mat(get_height(), get_width(), get_opencv()->type());
+		c->m_Format = m_Format;
+		c->m_SourcePath = m_SourcePath;
+		return c;
+	}
+
+	//----------------------------------------------------------------------------
+
 	cv::Mat* image::get_opencv()
 	{
 		return m_CVMat;
@@ -107,6 +130,8 @@ namespace image_processing
 
 	bool image::write_to_file(const char* path) const
 	{
+		if (qoi::has_extension(path))
+			return qoi::write_file(path, *m_CVMat);
 		return imwrite(path, *m_CVMat);
 	}
 
@@ -119,6 +144,79 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	bool image::write_to_file(const std::string& path, const image_write_options& options) const
+	{
+		if (options.Format == image_write_options::FileFormat::QOI)
+			return qoi::write_file(path, *m_CVMat);
+		return imwrite(path, *m_CVMat, options.get_encoder_params());
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::vector<int> image_write_options::get_encoder_params() const
+	{
+		std::vector<int> params;
+		switch (Format)
+		{
+		case FileFormat::PNG:
+		{
+			static const std::map<Strategy, int> strategies = {
+				{ Strategy::Default,	 cv::IMWRITE_PNG_STRATEGY_DEFAULT },
+				{ Strategy::Filtered,	 cv::IMWRITE_PNG_STRATEGY_FILTERED },
+				{ Strategy::HuffmanOnly, cv::IMWRITE_PNG_STRATEGY_HUFFMAN_ONLY },
+				{ Strategy::RLE,		 cv::IMWRITE_PNG_STRATEGY_RLE },
+				{ Strategy::Fixed,		 cv::IMWRITE_PNG_STRATEGY_FIXED }
+			};
+
+			if (PngLevel >= 0)
+			{
+				params.push_back(cv::IMWRITE_PNG_COMPRESSION);
+				params.push_back(std::min(PngLevel, 9));
+			}
+			params.push_back(cv::IMWRITE_PNG_STRATEGY);
+			params.push_back(strategies.at(PngStrategy));
+			break;
+		}
+
+		case FileFormat::JPEG:
+			params.push_back(cv::IMWRITE_JPEG_QUALITY);
+			params.push_back(std::max(0, std::min(JpegQuality, 100)));
+			break;
+
+		case FileFormat::PPM:
+			params.push_back(cv::IMWRITE_PXM_BINARY);
+			params.push_back(1);
+			break;
+
+		case FileFormat::TIFF:
+			// IMWRITE_TIFF_COMPRESSION isn't in every opencv we build against, 
+			// 259 is the libtiff compression tag and 1 is COMPRESSION_NONE
+			params.push_back(259);
+			params.push_back(1);
+			break;
+
+		case FileFormat::QOI:
+			break;
+		}
+		return params;
+	}
+
+	//----------------------------------------------------------------------------
+
+	const char* image_write_options::get_extension() const
+	{
+		switch (Format)
+		{
+		case FileFormat::JPEG: return ".jpg";
+		case FileFormat::PPM:  return ".ppm";
+		case FileFormat::TIFF: return ".tif";
+		case FileFormat::QOI:  return qoi::Extension;
+		default:			   return ".png";
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
 	int image::get_width() const
 	{
 		if (m_CVMat)
@@ -358,17 +456,10 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
-	void image::clamp_size(cv::Mat* in_dst, int max_size, bool enlarge, Interpolation interp) const
+	void image::get_clamped_size(int& width, int& height, int max_size, bool enlarge)
 	{
-		using namespace cv;
-
-		IMAGE_PROC_ASSERT(in_dst);
-
 		// clamp the image to a maximum size whilst maintaining
 		// the correct aspect ratio
-		int width = get_width();
-		int height = get_height();
-
 		if (width == height)
 		{
 			// square
@@ -395,6 +486,19 @@ namespace image_processing
 				width = (int)(scale * width);
 			}
 		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image::clamp_size(cv::Mat* in_dst, int max_size, bool enlarge, Interpolation interp) const
+	{
+		using namespace cv;
+
+		IMAGE_PROC_ASSERT(in_dst);
+
+		int width = get_width();
+		int height = get_height();
+		get_clamped_size(width, height, max_size, enlarge);
 
 		if (get_width() != width || get_height() != height)
 		{
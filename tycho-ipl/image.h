@@ -54,18 +54,17 @@ namespace image_processing
 	/// thrown if there is a problem reading an image file
 	class image_read_error : public exception {
 	public:
-		image_read_error(const char *path) :
-			m_Path(path)
-		{}
+		image_read_error(const char *path)
+		{
+			snprintf(&m_buffer[0], m_buffer.size(), "Failed to read '%s'", path);
+		}
 
 		const char* what() const noexcept override {
-			static std::array<char, 256> buffer;
-			sprintf(&buffer[0], "Failed to read '%s'", m_Path.c_str());
-			return buffer.data();
+			return m_buffer.data();
 		}
 
 	private:
-		std::string m_Path;
+		std::array<char, 256> m_buffer;
 	};
 
 	struct palette_entry
@@ -82,6 +81,42 @@ namespace image_processing
 
 	using detailed_palette = std::vector<palette_entry>;
 
+	//----------------------------------------------------------------------------
+	// File format and encoder settings used when an image is written to disk
+	//----------------------------------------------------------------------------
+	struct image_write_options
+	{
+		enum class FileFormat
+		{
+			PNG,
+			JPEG,
+			PPM,	///< uncompressed
+			TIFF,	///< uncompressed
+			QOI		///< fast lossless, see qoi_codec.h
+		};
+
+		/// zlib strategies used by the PNG encoder
+		enum class Strategy
+		{
+			Default,
+			Filtered,
+			HuffmanOnly,
+			RLE,
+			Fixed
+		};
+
+		/// Extension, including the dot, of files written in this format
+		const char* get_extension() const;
+
+		/// Parameters passed to the opencv encoder, unused for QOI
+		std::vector<int> get_encoder_params() const;
+
+		FileFormat  Format = FileFormat::PNG;
+		int			PngLevel = -1;	///< 0-9, -1 for the encoder default
+		Strategy	PngStrategy = Strategy::Default;
+		int			JpegQuality = 95;	///< 0-100
+	};
+
 	//----------------------------------------------------------------------------
 	// 
 	//----------------------------------------------------------------------------
@@ -132,6 +167,10 @@ namespace image_processing
 
 		/// Clone this image
 		image* clone() const; 
+
+		/// Create an image with the same size, type and format as this one 
+		/// without copying the pixel data.
+		image* clone_uninitialised() const;
 		
 		/// Get underlying OpenCV image
 		cv::Mat* get_opencv();
@@ -154,6 +193,10 @@ namespace image_processing
 		/// Write the image to disk
 		bool write_to_file(const std::string& ) const;
 
+		/// Write the image to disk with the given encoder settings. The path 
+		/// must end in the extension of the options format.
+		bool write_to_file(const std::string&, const image_write_options&) const;
+
 		/// Returns the width of the image
 		int get_width() const;
 
@@ -200,6 +243,9 @@ namespace image_processing
 		/// As clamp_size but modifies current image
 		void clamp_size(int max_size, bool enlarge, Interpolation);
 
+		/// Get the size clamp_size scales an image of the given size to
+		static void get_clamped_size(int& width, int& height, int max_size, bool enlarge);
+
 		/// Remaps all the pixels in the image to closest match in the passed
 		/// palette
 		void remap_to_palette(const cv::Vec3b* palette, size_t num_entries);
@@ -219,6 +265,46 @@ namespace image_processing
 	};
 
 
+	//----------------------------------------------------------------------------
+	// Format and size of an image as far as they are known before a program is
+	// run. A size of zero isn't known.
+	//----------------------------------------------------------------------------
+	struct image_shape
+	{
+		image_shape() = default;
+
+		image_shape(image::Format format, int width, int height) :
+			HasFormat(true),
+			Format(format),
+			Width(width),
+			Height(height)
+		{}
+
+		bool has_size() const { return Width > 0 && Height > 0; }
+
+		/// OpenCV pixel type of images with this format
+		int get_type() const { return Format == image::Format::Grey ? CV_8UC1 : CV_8UC3; }
+
+		bool operator==(const image_shape& rhs) const
+		{
+			return HasFormat == rhs.HasFormat && Format == rhs.Format && 
+				Width == rhs.Width && Height == rhs.Height;
+		}
+
+		bool operator<(const image_shape& rhs) const
+		{
+			if (HasFormat != rhs.HasFormat) return HasFormat < rhs.HasFormat;
+			if (Format != rhs.Format) return Format < rhs.Format;
+			if (Width != rhs.Width) return Width < rhs.Width;
+			return Height < rhs.Height;
+		}
+
+		bool		  HasFormat = false;
+		image::Format Format = image::Format::RGB;
+		int			  Width = 0;
+		int			  Height = 0;
+	};
+
 	int get_intensity_channel(image::Format format);
 
 	using image_ptr = std::shared_ptr < image > ;
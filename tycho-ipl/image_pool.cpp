@@ -0,0 +1,201 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_pool.h"
+#include "image.h"
+#include "functions/common.h"
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+
+	image_pool::image_pool(size_t max_bytes) :
+		m_MaxBytes(max_bytes)
+	{}
+
+	//----------------------------------------------------------------------------
+
+	image_pool::~image_pool()
+	{
+		clear();
+	}
+
+	//----------------------------------------------------------------------------
+
+	size_t image_pool::get_image_bytes(const image* img)
+	{
+		const cv::Mat& mat = *img->get_opencv();
+		return mat.total() * mat.elemSize();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool image_pool::matches(const image* img, int width, int height, int type, image::Format format)
+	{
+		const cv::Mat& mat = *img->get_opencv();
+		return mat.rows == height && mat.cols == width &&
+			mat.type() == type && img->get_format() == format;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* image_pool::find_free(int width, int height, int type, image::Format format)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// search most recently released first as they are more likely to be resident
+		for (auto it = m_Free.rbegin(); it != m_Free.rend(); ++it)
+		{
+			image* img = *it;
+			if (matches(img, width, height, type, format))
+			{
+				m_Bytes -= get_image_bytes(img);
+				m_Free.erase(std::next(it).base());
+				return img;
+			}
+		}
+		return nullptr;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* image_pool::acquire_like(const image* src)
+	{
+		const cv::Mat& src_mat = *src->get_opencv();
+		if (image* img = find_free(src_mat.cols, src_mat.rows, src_mat.type(), src->get_format()))
+			return img;
+
+		return src->clone_uninitialised();
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* image_pool::acquire(int width, int height, int type, image::Format format)
+	{
+		if (image* img = find_free(width, height, type, format))
+			return img;
+
+		auto* img = new image();
+		img->set_mat(cv::Mat(height, width, type), format);
+		return img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* image_pool::acquire_copy(const image* src)
+	{
+		image* img = acquire_like(src);
+		src->get_opencv()->copyTo(*img->get_opencv());
+		return img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image_pool::reserve(int width, int height, int type, image::Format format, size_t count)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (image* img : m_Free)
+		{
+			if (count > 0 && matches(img, width, height, type, format))
+				--count;
+		}
+
+		const size_t bytes = static_cast<size_t>(width) * height * CV_ELEM_SIZE(type);
+		for (; count > 0 && bytes > 0 && m_Bytes + bytes <= m_MaxBytes; --count)
+		{
+			auto* img = new image();
+			img->set_mat(cv::Mat(height, width, type), format);
+			m_Free.push_back(img);
+			m_Bytes += bytes;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image_pool::release(image* img)
+	{
+		if (!img)
+			return;
+
+		const size_t bytes = get_image_bytes(img);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (bytes == 0 || bytes > m_MaxBytes)
+		{
+			delete img;
+			return;
+		}
+
+		trim(m_MaxBytes - bytes);
+		m_Free.push_back(img);
+		m_Bytes += bytes;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image_pool::clear()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		trim(0);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image_pool::set_max_bytes(size_t max_bytes)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_MaxBytes = max_bytes;
+		trim(m_MaxBytes);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void image_pool::trim(size_t max_bytes)
+	{
+		// evict least recently released images until we are within the limit
+		while (!m_Free.empty() && m_Bytes > max_bytes)
+		{
+			image* img = m_Free.front();
+			m_Bytes -= get_image_bytes(img);
+			m_Free.pop_front();
+			delete img;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
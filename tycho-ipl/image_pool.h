@@ -0,0 +1,126 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef IMAGE_POOL_H_DE2FEFBB_E4A3_44DF_A0FE_76E22BD2F9A2
+#define IMAGE_POOL_H_DE2FEFBB_E4A3_44DF_A0FE_76E22BD2F9A2
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "forward_decls.h"
+#include "image.h"
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Cache of image buffers that are no longer in use. Released images are kept
+	// up to a maximum total size and handed back out to requests for an image
+	// of the same size, type and format, which avoids reallocating and faulting
+	// in large buffers for every temporary in every run. Safe to share between
+	// threads.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI image_pool
+	{
+	public:
+		/// Default maximum size of the pooled buffers in bytes
+		static const size_t DefaultMaxBytes = 512 * 1024 * 1024;
+
+	public:
+		/// Constructor
+		explicit image_pool(size_t max_bytes = DefaultMaxBytes);
+
+		/// Destructor, deletes all pooled images
+		~image_pool();
+
+		/// Get an image with the same size, type and format as src. The pixel
+		/// contents are undefined.
+		image* acquire_like(const image* src);
+
+		/// Get an image of the given size, OpenCV pixel type and format. The 
+		/// pixel contents are undefined.
+		image* acquire(int width, int height, int type, image::Format format);
+
+		/// Get an image that is a copy of src
+		image* acquire_copy(const image* src);
+
+		/// Make sure there are at least count free images of the given size,
+		/// OpenCV pixel type and format so they aren't allocated as they are 
+		/// acquired. Stops allocating when the pool is full.
+		void reserve(int width, int height, int type, image::Format format, size_t count);
+
+		/// Return an image to the pool. If the pool is full the least recently 
+		/// released images are deleted to make room.
+		void release(image* img);
+
+		/// Delete all pooled images
+		void clear();
+
+		/// Set the maximum size of the pooled images in bytes, 0 disables pooling
+		void set_max_bytes(size_t max_bytes);
+
+		/// Get the maximum size of the pooled images in bytes
+		size_t get_max_bytes() const { return m_MaxBytes; }
+
+		/// Get the current size of the pooled images in bytes
+		size_t get_size_bytes() const { return m_Bytes; }
+
+	private:
+		static size_t get_image_bytes(const image* img);
+		static bool matches(const image* img, int width, int height, int type, image::Format format);
+		image* find_free(int width, int height, int type, image::Format format);
+		void trim(size_t max_bytes);
+
+	private:
+		std::mutex		  m_Mutex;
+		std::list<image*> m_Free;	///< most recently released at the back
+		size_t			  m_Bytes = 0;
+		size_t			  m_MaxBytes;
+
+		// noncopyable
+		image_pool(const image_pool&) = delete;
+		image_pool& operator=(const image_pool&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // IMAGE_POOL_H_DE2FEFBB_E4A3_44DF_A0FE_76E22BD2F9A2
@@ -29,6 +29,8 @@
 //----------------------------------------------------------------------------
 #include "key_value.h"
 #include <cstring>
+#include <mutex>
+#include <unordered_set>
 
 //----------------------------------------------------------------------------
 // Class
@@ -41,6 +43,18 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	const char* intern(const char* str)
+	{
+		// set nodes never move so the pointers stay valid as it grows
+		static std::mutex mutex;
+		static std::unordered_set<std::string> strings;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		return strings.insert(str).first->c_str();
+	}
+
+	//----------------------------------------------------------------------------
+
 	value value::from_string(const std::string& str)
 	{
 		auto type = deduce_object_type(str);
@@ -168,7 +182,7 @@ namespace image_processing
 				sprintf(buf, "%d", m_Value.Integer);
 			} break;
 			case ObjectType::Name: {
-				return m_Value.Name;
+				return m_Value.Str;
 			}
 			case ObjectType::Image: {
 				sprintf(buf, "%p", m_Value.Image);
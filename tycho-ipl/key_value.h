@@ -37,7 +37,7 @@
 #include "image_processing_abi.h"
 #include <vector>
 #include <string>
-#include <map>
+#include <utility>
 #include <cstring>
 #include <stdlib.h>
 
@@ -63,11 +63,19 @@ namespace image_processing
 
 	const char* to_string(ObjectType type);
 
+	/// Get the single copy of str shared by every caller passing an equal 
+	/// string. Interned strings live until the process exits, so they are 
+	/// only used for names and string literals from scripts and options.
+	TYCHO_IMAGEPROCESSING_ABI const char* intern(const char* str);
+	inline const char* intern(const std::string& str) { return intern(str.c_str()); }
+
+	//----------------------------------------------------------------------------
+	// Script value. Names and strings are interned so a value is a tagged 
+	// 8 byte payload and copies don't touch the string.
+	//----------------------------------------------------------------------------
 	class value
 	{
 	public:
-		static const int MaxName = 128;
-
 		static ObjectType deduce_object_type(const std::string&);
 		static value from_string(const std::string&);
 
@@ -76,14 +84,14 @@ namespace image_processing
 		static value make_name(const std::string& str)
 		{ 
 			value_ v;
-			strcpy(&v.Name[0], str.c_str()); 
+			v.Str = intern(str);
 			return value(v, ObjectType::Name);
 		}
 
 		static value make_string(const std::string& str)
 		{
 			value_ v;
-			strcpy(&v.Name[0], str.c_str());
+			v.Str = intern(str);
 			return value(v, ObjectType::String);
 		}
 
@@ -106,13 +114,13 @@ namespace image_processing
 		void set_float(float val) { m_Value.Float = val; m_Type = ObjectType::Float; }
 		void set_name(const char* name) 
 		{ 
-			strcpy(&m_Value.Name[0], name);
+			m_Value.Str = intern(name);
 			m_Type = ObjectType::Name;
 		}
 
 		void set_string(const char* name)
 		{
-			strcpy(&m_Value.Name[0], name);
+			m_Value.Str = intern(name);
 			m_Type = ObjectType::String;
 		}
 
@@ -127,18 +135,18 @@ namespace image_processing
 		int get_integer() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::Integer); return m_Value.Integer; }
 		float get_float() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::Float); return m_Value.Float; }
 		bool get_boolean() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::Boolean); return m_Value.Boolean; }
-		const char* get_name() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::Name); return m_Value.Name; }
-		const char* get_string() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::String); return m_Value.Name; }
+		const char* get_name() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::Name); return m_Value.Str; }
+		const char* get_string() const { IMAGE_PROC_ASSERT(m_Type == ObjectType::String); return m_Value.Str; }
 		std::string to_string() const;
 
 	private:
 		union value_
 		{
-			image* Image;
-			float  Float;
-			int    Integer;
-			bool   Boolean;
-			char   Name[MaxName];
+			image*		Image;
+			float		Float;
+			int			Integer;
+			bool		Boolean;
+			const char* Str;	///< interned
 		};
 
 		value(value_ value, ObjectType type) :
@@ -165,31 +173,34 @@ namespace image_processing
 
 	using kv_list = std::vector < key_value >;
 
+	//----------------------------------------------------------------------------
+	// Named values. These only ever hold a handful of entries so they are kept
+	// in a flat vector and searched linearly.
+	//----------------------------------------------------------------------------
 	class kv_dict
 	{
 	public:
 
 		bool exists(const std::string& key) const
 		{
-			return m_dict.find(key) != m_dict.end();
+			return find(key) != nullptr;
 		}
 
 		void set(const std::string& key, const value& value)
 		{
-			auto it = m_dict.find(key);
-			if (it != m_dict.end())
-				it->second = value;
+			if (auto* v = find(key))
+				*v = value;
 			else
-				m_dict.insert(std::make_pair(key, value));
+				m_Entries.emplace_back(key, value);
 		}
 		
 		bool try_get(const std::string &key, value& value) const 
 		{
-			auto it = m_dict.find(key);
-			if (it == m_dict.end())
+			const auto* v = find(key);
+			if (!v)
 				return false;
 
-			value = it->second;
+			value = *v;
 			return true;
 		}
 
@@ -214,7 +225,22 @@ namespace image_processing
 #undef DEFINE_GET_METHODS
 
 	private:
-		std::map<std::string, value> m_dict;
+		value* find(const std::string& key)
+		{
+			for (auto& e : m_Entries)
+			{
+				if (e.first == key)
+					return &e.second;
+			}
+			return nullptr;
+		}
+
+		const value* find(const std::string& key) const
+		{
+			return const_cast<kv_dict*>(this)->find(key);
+		}
+
+		std::vector<std::pair<std::string, value>> m_Entries;
 	};
 	
 } // end namespace
@@ -0,0 +1,438 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "native_program.h"
+#include "program.h"
+#include "function.h"
+#include "exception.h"
+#include "result_cache.h"
+#include "utils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// compiler and flags to build generated code with, set by the build
+#ifndef TYCHO_NATIVE_CXX
+#define TYCHO_NATIVE_CXX "c++"
+#endif
+
+#ifndef TYCHO_NATIVE_CXXFLAGS
+#define TYCHO_NATIVE_CXXFLAGS ""
+#endif
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	namespace
+	{
+		using version_func = int(*)();
+		using hash_func = uint64_t(*)();
+
+#ifndef _WIN32
+		//----------------------------------------------------------------------------
+
+		/// Quote a path as a single shell word, the command is run through system()
+		/// so spaces, quotes or $ in a path mustn't be interpreted by the shell
+		std::string shell_quote(const std::string& path)
+		{
+			std::string quoted = "'";
+			for (char c : path)
+			{
+				if (c == '\'')
+					quoted += "'\\''";
+				else
+					quoted += c;
+			}
+			quoted += "'";
+			return quoted;
+		}
+#endif
+
+		//----------------------------------------------------------------------------
+
+		/// Format a constant as a C++ literal of the given parameter type, 
+		/// returns false if it can't be passed to a typed execute method
+		bool format_constant(ObjectType type, const value& val, std::string& out)
+		{
+			char buf[64];
+			if (type == ObjectType::Integer && val.get_type() == ObjectType::Integer)
+			{
+				snprintf(buf, sizeof(buf), "%d", val.get_integer());
+			}
+			else if (type == ObjectType::Float && val.get_type() == ObjectType::Float)
+			{
+				// hex floats round trip exactly
+				if (!std::isfinite(val.get_float()))
+					return false;
+				snprintf(buf, sizeof(buf), "%af", static_cast<double>(val.get_float()));
+			}
+			else if (type == ObjectType::Boolean && val.get_type() == ObjectType::Boolean)
+			{
+				snprintf(buf, sizeof(buf), "%s", val.get_boolean() ? "true" : "false");
+			}
+			else
+			{
+				return false;
+			}
+			out = buf;
+			return true;
+		}
+
+		//----------------------------------------------------------------------------
+
+		/// Build the arguments to the typed execute method of statement s, 
+		/// returns false if it has to be dispatched
+		bool get_native_args(const statement& stmt, std::string& out)
+		{
+			const function* func = stmt.Func;
+			auto& in_params = func->get_inputs();
+			auto& out_params = func->get_outputs();
+			if (!func->get_native_class() ||
+				in_params.empty() || in_params[0].Type != ObjectType::Image || stmt.Inputs[0].is_constant() ||
+				out_params.size() != 1 || out_params[0].Type != ObjectType::Image || stmt.Outputs[0] < 0)
+			{
+				return false;
+			}
+
+			// groups are run by the context
+			if (stmt.FusedStatements > 0 || stmt.FusedHead >= 0 ||
+				stmt.StripStatements > 0 || stmt.StripHead >= 0)
+			{
+				return false;
+			}
+
+			for (const char* name : func->get_native_args())
+			{
+				std::string arg;
+				if (out_params[0].Name == name)
+				{
+					arg = "dst";
+				}
+				else
+				{
+					size_t i = 0;
+					while (i < in_params.size() && in_params[i].Name != name)
+						++i;
+					if (i == in_params.size())
+						return false;
+
+					const operand& op = stmt.Inputs[i];
+					const ObjectType type = in_params[i].Type;
+					char buf[64];
+					if (i == 0)
+					{
+						arg = "src";
+					}
+					else if (op.is_constant())
+					{
+						if (!format_constant(type, op.Constant, arg))
+							return false;
+					}
+					else if (type == ObjectType::Image)
+					{
+						snprintf(buf, sizeof(buf), "ctx->native_image(%d)", op.Slot);
+						arg = buf;
+					}
+					else if (type == ObjectType::Integer || type == ObjectType::Float || type == ObjectType::Boolean)
+					{
+						const char* getter = type == ObjectType::Integer ? "integer" :
+							type == ObjectType::Float ? "float" : "boolean";
+						snprintf(buf, sizeof(buf), "ctx->native_%s(%d)", getter, op.Slot);
+						arg = buf;
+					}
+					else
+					{
+						return false;
+					}
+				}
+
+				if (!out.empty())
+					out += ", ";
+				out += arg;
+			}
+			return true;
+		}
+
+		//----------------------------------------------------------------------------
+
+		void* open_library(const std::string& path)
+		{
+#ifdef _WIN32
+			(void)path;
+			return nullptr;
+#else
+			// a bare file name would be searched for on the library path
+			const std::string local = path.find('/') == std::string::npos ? "./" + path : path;
+			return dlopen(local.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+		}
+
+		//----------------------------------------------------------------------------
+
+		void close_library(void* handle)
+		{
+#ifndef _WIN32
+			if (handle)
+				dlclose(handle);
+#else
+			(void)handle;
+#endif
+		}
+
+		//----------------------------------------------------------------------------
+
+		std::string get_load_error()
+		{
+#ifdef _WIN32
+			return "can't load library";
+#else
+			const char* err = dlerror();
+			return err ? err : "can't load library";
+#endif
+		}
+
+		//----------------------------------------------------------------------------
+
+		void* find_symbol(void* handle, const char* name)
+		{
+#ifdef _WIN32
+			(void)handle;
+			(void)name;
+			return nullptr;
+#else
+			return dlsym(handle, name);
+#endif
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	native_program::~native_program()
+	{
+		close_library(m_Handle);
+	}
+
+	//----------------------------------------------------------------------------
+
+	uint64_t native_program::get_program_hash(const program& p)
+	{
+		std::vector<char> data;
+		p.save_compiled(data, 0);
+		return result_cache::hash(data.data(), data.size());
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::string native_program::generate(const program& p)
+	{
+		char buf[256];
+		std::string body;
+		std::set<std::string> headers;
+
+		for (size_t s = 0; s < p.m_Statements.size(); ++s)
+		{
+			const statement& stmt = p.m_Statements[s];
+
+			// repeat blocks are a loop around their statements
+			const char* indent = stmt.RepeatHead >= 0 ? "\t\t" : "\t";
+			if (stmt.RepeatHead == static_cast<int>(s))
+			{
+				snprintf(buf, sizeof(buf),
+					"\n\t// line %d : repeat\n"
+					"\tfor (int i = 0, n = ctx->native_repeat_begin(%zu); i < n; ++i)\n"
+					"\t{\n"
+					"\t\tctx->native_repeat_next(%zu);\n",
+					stmt.Line, s, s);
+				body += buf;
+			}
+
+			snprintf(buf, sizeof(buf), "\n%s// line %d : %s\n", indent, stmt.Line, stmt.Func->get_name());
+			body += buf;
+
+			std::string args;
+			if (!get_native_args(stmt, args))
+			{
+				snprintf(buf, sizeof(buf), 
+					"%sif (!ctx->native_dispatch(%zu))\n"
+					"%s\treturn false;\n", indent, s, indent);
+				body += buf;
+			}
+			else
+			{
+				headers.insert(stmt.Func->get_native_header());
+				snprintf(buf, sizeof(buf),
+					"%sif (!ctx->native_cached(%zu))\n"
+					"%s{\n"
+					"%s\timage* dst = ctx->native_begin(%zu);\n"
+					"%s\timage* src = ctx->native_image(%d);\n",
+					indent, s, indent, indent, s, indent, stmt.Inputs[0].Slot);
+				body += buf;
+				body += indent;
+				body += "\tstatic_cast<const ";
+				body += stmt.Func->get_native_class();
+				snprintf(buf, sizeof(buf), "*>(ctx->native_function(%zu))->execute(", s);
+				body += buf;
+				body += args;
+
+				snprintf(buf, sizeof(buf), 
+					");\n"
+					"%s\tif (!ctx->native_end(%zu, dst))\n"
+					"%s\t\treturn false;\n"
+					"%s}\n", indent, s, indent, indent);
+				body += buf;
+			}
+
+			if (stmt.RepeatHead >= 0 && stmt.RepeatHead + p.m_Statements[stmt.RepeatHead].RepeatStatements == static_cast<int>(s))
+				body += "\t}\n\tctx->native_repeat_end();\n";
+		}
+
+		std::string src;
+		src += "// Generated from '" + p.m_SourcePath + "', do not edit\n";
+		src += "#include \"tycho-ipl/context.h\"\n";
+		src += "#include \"tycho-ipl/image.h\"\n";
+		for (auto& header : headers)
+			src += "#include \"tycho-ipl/" + header + "\"\n";
+		src += "\nusing namespace tycho::image_processing;\n\n";
+
+		snprintf(buf, sizeof(buf), 
+			"extern \"C\" int tyipl_native_version() { return %d; }\n"
+			"extern \"C\" uint64_t tyipl_native_hash() { return 0x%016llxull; }\n\n",
+			Version, static_cast<unsigned long long>(get_program_hash(p)));
+		src += buf;
+
+		src += "extern \"C\" bool tyipl_native_run(context* ctx)\n{";
+		src += body;
+		src += "\n\treturn true;\n}\n";
+		return src;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void native_program::build(const program& p, const std::string& path)
+	{
+#ifdef _WIN32
+		(void)p;
+		throw native_build_error(path, "not supported on this platform");
+#else
+		// each build gets its own source and library names so processes building
+		// the same program at once don't write over each other's files
+		const std::string tmp_path = utils::get_unique_temp_path(path);
+		const std::string source_path = tmp_path + ".cpp";
+
+		const std::string source = generate(p);
+		FILE* file = fopen(source_path.c_str(), "wb");
+		if (!file)
+			throw native_build_error(path, "can't write generated source");
+		const bool written = fwrite(source.data(), source.size(), 1, file) == 1;
+		fclose(file);
+		if (!written)
+			throw native_build_error(path, "can't write generated source");
+
+		// the compiler and flags can be overridden from the environment
+		const char* cxx = getenv("TYCHO_IPL_CXX");
+		const char* flags = getenv("TYCHO_IPL_CXXFLAGS");
+		std::string cmd = cxx && *cxx ? cxx : TYCHO_NATIVE_CXX;
+		cmd += " -std=c++17 -O2 -fPIC -shared ";
+		cmd += TYCHO_NATIVE_CXXFLAGS;
+		if (flags)
+		{
+			cmd += " ";
+			cmd += flags;
+		}
+		cmd += " -o " + shell_quote(tmp_path) + " " + shell_quote(source_path);
+
+		const int status = system(cmd.c_str());
+		remove(source_path.c_str());
+		if (status != 0)
+		{
+			remove(tmp_path.c_str());
+			throw native_build_error(path, "compilation failed");
+		}
+
+		// replaced in one step so a concurrent load never sees a partial library
+		if (rename(tmp_path.c_str(), path.c_str()) != 0)
+		{
+			remove(tmp_path.c_str());
+			throw native_build_error(path, "can't write library");
+		}
+#endif
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::unique_ptr<native_program> native_program::load(const program& p, const std::string& path)
+	{
+		void* handle = open_library(path);
+		if (!handle)
+			return nullptr;
+
+		auto version = reinterpret_cast<version_func>(find_symbol(handle, "tyipl_native_version"));
+		auto hash = reinterpret_cast<hash_func>(find_symbol(handle, "tyipl_native_hash"));
+		auto entry = reinterpret_cast<entry_point>(find_symbol(handle, "tyipl_native_run"));
+		if (!version || !hash || !entry || 
+			version() != Version || hash() != get_program_hash(p))
+		{
+			close_library(handle);
+			return nullptr;
+		}
+
+		return std::unique_ptr<native_program>(new native_program(handle, entry));
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::unique_ptr<native_program> native_program::load_or_build(const program& p, const std::string& path)
+	{
+		auto native = load(p, path);
+		if (native)
+			return native;
+
+		build(p, path);
+		native = load(p, path);
+		if (!native)
+			throw native_build_error(path, get_load_error().c_str());
+		return native;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
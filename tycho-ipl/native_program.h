@@ -0,0 +1,113 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef NATIVE_PROGRAM_H_5E3C1B7A_2D4F_4A8E_9B61_0C7F3E2A9D54
+#define NATIVE_PROGRAM_H_5E3C1B7A_2D4F_4A8E_9B61_0C7F3E2A9D54
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "forward_decls.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// A program compiled ahead of time to C++ and built into a shared library
+	// with the system compiler. Statements whose function has a typed execute()
+	// method call it directly with constant arguments inlined, the rest are 
+	// dispatched through the context as usual. The library is only used with 
+	// the program it was generated from.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI native_program
+	{
+	public:
+		/// Entry point of the generated code, returns false if a statement failed
+		using entry_point = bool(*)(context*);
+
+		/// Version of the interface between generated code and the context,
+		/// libraries built for other versions are rebuilt
+		static const int Version = 6;
+
+	public:
+		/// Destructor, unloads the library
+		~native_program();
+
+		/// Generate the C++ source for a program
+		static std::string generate(const program& p);
+
+		/// Generate the source for a program and build it into a shared library
+		/// at path. Throws native_build_error on failure.
+		static void build(const program& p, const std::string& path);
+
+		/// Load the library at path, returns nullptr if it doesn't exist or was
+		/// built from a different program
+		static std::unique_ptr<native_program> load(const program& p, const std::string& path);
+
+		/// Load the library at path, building it first if it's missing or out of
+		/// date. Throws native_build_error on failure.
+		static std::unique_ptr<native_program> load_or_build(const program& p, const std::string& path);
+
+		/// Hash identifying the compiled form of a program
+		static uint64_t get_program_hash(const program& p);
+
+		/// Get the entry point of the generated code
+		entry_point get_entry() const { return m_Entry; }
+
+	private:
+		native_program(void* handle, entry_point entry) :
+			m_Handle(handle),
+			m_Entry(entry)
+		{}
+
+	private:
+		void*		m_Handle;
+		entry_point m_Entry;
+
+		// noncopyable
+		native_program(const native_program&) = delete;
+		native_program& operator=(const native_program&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // NATIVE_PROGRAM_H_5E3C1B7A_2D4F_4A8E_9B61_0C7F3E2A9D54
@@ -0,0 +1,113 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "pipeline.h"
+
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+
+	pipeline_stage::pipeline_stage(task body, task stop, size_t num_threads) :
+		m_Stop(std::move(stop)),
+		m_Body(std::move(body))
+	{
+		if (num_threads == 0)
+			num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (size_t i = 0; i < num_threads; ++i)
+			m_Threads.emplace_back(&pipeline_stage::run, this, std::cref(m_Body));
+	}
+
+	//----------------------------------------------------------------------------
+
+	pipeline_stage::~pipeline_stage()
+	{
+		bool running = false;
+		for (auto& thread : m_Threads)
+			running |= thread.joinable();
+
+		if (running)
+		{
+			m_Stop();
+			for (auto& thread : m_Threads)
+			{
+				if (thread.joinable())
+					thread.join();
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void pipeline_stage::join()
+	{
+		for (auto& thread : m_Threads)
+		{
+			if (thread.joinable())
+				thread.join();
+		}
+
+		if (m_Error)
+			std::rethrow_exception(m_Error);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void pipeline_stage::run(const task& body)
+	{
+		try
+		{
+			body();
+		}
+		catch (...)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				if (!m_Error)
+					m_Error = std::current_exception();
+			}
+
+			// the stages either side may be waiting on this one
+			m_Stop();
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
@@ -0,0 +1,168 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef PIPELINE_H_77801458_6974_479D_BCB0_432BE6014A1A
+#define PIPELINE_H_77801458_6974_479D_BCB0_432BE6014A1A
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Queue between two pipeline stages. Pushing blocks while the queue holds 
+	// depth items, so a stage can't get more than depth items ahead of the 
+	// one after it.
+	//----------------------------------------------------------------------------
+	template<typename T>
+	class bounded_queue
+	{
+	public:
+		/// Constructor
+		explicit bounded_queue(size_t depth) :
+			m_Depth(depth ? depth : 1)
+		{}
+
+		/// Add an item, waiting for space if the queue is full. Returns false 
+		/// if the queue was closed and the item wasn't added.
+		bool push(T item)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Signal.wait(lock, [this] { return m_Closed || m_Items.size() < m_Depth; });
+			if (m_Closed)
+				return false;
+
+			m_Items.push_back(std::move(item));
+			m_Signal.notify_all();
+			return true;
+		}
+
+		/// Remove the oldest item, waiting for one if the queue is empty. 
+		/// Returns false once the queue is closed and empty.
+		bool pop(T& item)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Signal.wait(lock, [this] { return m_Closed || !m_Items.empty(); });
+			if (m_Items.empty())
+				return false;
+
+			item = std::move(m_Items.front());
+			m_Items.pop_front();
+			m_Signal.notify_all();
+			return true;
+		}
+
+		/// No more items will be added, items already queued can still be popped
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Closed = true;
+			m_Signal.notify_all();
+		}
+
+		/// Returns true if the queue has been closed
+		bool is_closed() const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Closed;
+		}
+
+	private:
+		const size_t			m_Depth;
+		std::deque<T>			m_Items;
+		mutable std::mutex		m_Mutex;
+		std::condition_variable m_Signal;
+		bool					m_Closed = false;
+
+		// noncopyable
+		bounded_queue(const bounded_queue&) = delete;
+		bounded_queue& operator=(const bounded_queue&) = delete;
+	};
+
+	//----------------------------------------------------------------------------
+	// Pipeline stage running on its own threads. The stop function must make 
+	// the stage return, usually by closing the queues it waits on, and is 
+	// called if the stage raises an exception or is destroyed before it's 
+	// finished. With several threads each one runs the body, so they share 
+	// the items of the queue the body pops from.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI pipeline_stage
+	{
+	public:
+		using task = std::function<void()>;
+
+	public:
+		/// Constructor, starts running the stage on num_threads threads, 0 for 
+		/// one per core
+		pipeline_stage(task body, task stop, size_t num_threads = 1);
+
+		/// Destructor, stops the stage and waits for it to return
+		~pipeline_stage();
+
+		/// Wait for every thread of the stage to return and rethrow the first 
+		/// exception any of them raised
+		void join();
+
+	private:
+		void run(const task& body);
+
+	private:
+		task			   m_Stop;
+		task			   m_Body;
+		std::mutex		   m_Mutex;
+		std::exception_ptr m_Error;
+		std::vector<std::thread> m_Threads;
+
+		// noncopyable
+		pipeline_stage(const pipeline_stage&) = delete;
+		pipeline_stage& operator=(const pipeline_stage&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // PIPELINE_H_77801458_6974_479D_BCB0_432BE6014A1A
@@ -0,0 +1,73 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef PIXEL_KERNEL_H_F3B5E194_A961_4278_B749_EEE1366B391D
+#define PIXEL_KERNEL_H_F3B5E194_A961_4278_B749_EEE1366B391D
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "image.h"
+
+#include <cstdint>
+#include <functional>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Per pixel form of a pointwise function. The caller sets the input format
+	// and channel count and the function fills in the rest. Row converts a row 
+	// of 8 bit pixels to a row with OutChannels channels, chains of these are
+	// run together to fuse consecutive pointwise calls into a single pass over
+	// the image.
+	//----------------------------------------------------------------------------
+	struct pixel_kernel
+	{
+		using row_func = std::function < void(const uint8_t* src, uint8_t* dst, int width) > ;
+
+		image::Format InFormat = image::Format::RGB;
+		int			  InChannels = 0;
+		image::Format OutFormat = image::Format::RGB;
+		int			  OutChannels = 0;
+		row_func	  Row;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // PIXEL_KERNEL_H_F3B5E194_A961_4278_B749_EEE1366B391D
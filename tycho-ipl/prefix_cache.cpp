@@ -0,0 +1,92 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "prefix_cache.h"
+#include "program.h"
+#include "function.h"
+#include "image.h"
+#include "image_pool.h"
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+
+	prefix_cache::prefix_cache(const program* program, const std::vector<std::string>& swept, image_pool* pool) :
+		m_Pool(pool)
+	{
+		program->find_invariant_statements(swept, m_Invariant, m_Stored);
+		m_Outputs.resize(m_Invariant.size());
+	}
+
+	//----------------------------------------------------------------------------
+
+	prefix_cache::~prefix_cache()
+	{
+		clear();
+	}
+
+	//----------------------------------------------------------------------------
+
+	size_t prefix_cache::num_invariant() const
+	{
+		size_t count = 0;
+		for (char invariant : m_Invariant)
+			count += invariant ? 1 : 0;
+		return count;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void prefix_cache::clear()
+	{
+		for (auto img : m_Owned)
+		{
+			if (m_Pool)
+				m_Pool->release(img);
+			else
+				delete img;
+		}
+		m_Owned.clear();
+
+		for (auto& outputs : m_Outputs)
+			outputs.clear();
+		m_Filled = false;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
@@ -0,0 +1,115 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef PREFIX_CACHE_H_EFDBAF10_7851_41F6_B49C_7A1C6C676C55
+#define PREFIX_CACHE_H_EFDBAF10_7851_41F6_B49C_7A1C6C676C55
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "forward_decls.h"
+#include "key_value.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Results of the statements in a program that don't depend on any of a set
+	// of swept inputs. The first execution with the cache computes them as 
+	// normal and stores the ones later statements need, every following 
+	// execution on the same source image skips them and reads the stored 
+	// results instead. Stored images are owned by the cache and are only ever
+	// read by the executing program.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI prefix_cache
+	{
+	public:
+		/// Constructor. swept holds the names of the program inputs that change
+		/// between executions. Stored images are returned to pool if supplied.
+		prefix_cache(const program* program, const std::vector<std::string>& swept, image_pool* pool = nullptr);
+
+		/// Destructor, frees the stored images
+		~prefix_cache();
+
+		/// Returns true once an execution has stored the results
+		bool is_filled() const { return m_Filled; }
+
+		/// Returns true if the statement can be skipped once the cache is filled
+		bool is_invariant(size_t s) const { return m_Invariant[s] != 0; }
+
+		/// Returns true if the statement's outputs are stored
+		bool is_stored(size_t s) const { return m_Stored[s] != 0; }
+
+		/// Returns the number of statements that are skipped once the cache is filled
+		size_t num_invariant() const;
+
+		/// Store the outputs of statement s
+		void store(size_t s, const std::vector<value>& outputs) { m_Outputs[s] = outputs; }
+
+		/// Take ownership of an image stored by store()
+		void take_ownership(image* img) { m_Owned.insert(img); }
+
+		/// Get the stored outputs of statement s
+		const std::vector<value>& get_outputs(size_t s) const { return m_Outputs[s]; }
+
+		/// Mark the cache as filled after a successful execution
+		void set_filled() { m_Filled = true; }
+
+		/// Free everything stored
+		void clear();
+
+	private:
+		std::vector<char> m_Invariant;
+		std::vector<char> m_Stored;
+		std::vector<std::vector<value>> m_Outputs;
+		std::set<image*> m_Owned;
+		image_pool*		 m_Pool;
+		bool			 m_Filled = false;
+
+		// noncopyable
+		prefix_cache(const prefix_cache&) = delete;
+		prefix_cache& operator=(const prefix_cache&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // PREFIX_CACHE_H_EFDBAF10_7851_41F6_B49C_7A1C6C676C55
@@ -39,6 +39,8 @@
 #include <cstdarg>
 #include <array>
 #include <memory>
+#include <set>
+#include <algorithm>
 
 #define CHECK_UNEXPECTED_END() \
 	if(data == end) { \
@@ -127,6 +129,10 @@ namespace image_processing
 		check_for_unused(m_Outputs);
 		check_for_unused(m_Constants);
 		check_for_unused(m_Temporaries);
+
+		// Resolve all symbols to register slots ready for execution
+		if (!has_errors())
+			compile();
 	}
 
 	//----------------------------------------------------------------------------
@@ -413,6 +419,8 @@ namespace image_processing
 			data = consume_declaration(declaration::TypeModifier::Temp, m_Temporaries, data, end);
 		else if (strcmp(type.data(), "call") == 0)
 			data = consume_function_call(data, end);
+		else if (strcmp(type.data(), "repeat") == 0)
+			return consume_repeat(data, end);
 		else
 		{
 			log_error(m_CurLine, "Invalid statement '%s'", type.data());
@@ -474,7 +482,7 @@ namespace image_processing
 	//----------------------------------------------------------------------------
 
 	const char* program::consume_kvdict(
-		function* func,
+		const function* func,
 		const char* data,
 		const char* end,
 		kv_dict& parts)
@@ -595,7 +603,8 @@ namespace image_processing
 				log_error(m_CurLine, "Statement not terminated");
 				return data;
 			}
-			m_Statements.push_back(statement(StatementList::FunctionCall, name.data(), func, args));
+			m_Statements.push_back(statement(StatementList::FunctionCall, name.data(), func, args, m_CurLine));
+			m_Statements.back().RepeatHead = m_RepeatHead;
 			m_CallCounts[func->get_name()]++;
 		}
 		else
@@ -609,6 +618,93 @@ namespace image_processing
 	}
 
 
+	//----------------------------------------------------------------------------
+
+	const char* program::consume_repeat(const char* data, const char* end)
+	{
+		// repeat <count> { <statements> }, the count is an int or the name of one
+		const int line = m_CurLine;
+		data = consume_whitespace(data, end);
+
+		value count;
+		const char* start = data;
+		data = consume_value_checked(data, end, count);
+		if (data == start)
+		{
+			log_error(line, "Repeat has no count");
+		}
+		else if (count.get_type() == ObjectType::Name)
+		{
+			const declaration* decl = m_Symbols.find(count.get_name())->second;
+			if (decl->Type != ObjectType::Integer)
+				log_error(line, "Repeat count '%s' is not an int", count.get_name());
+		}
+		else if (count.is_valid() && count.get_type() != ObjectType::Integer)
+		{
+			log_error(line, "Repeat count must be an int");
+		}
+		else if (count.is_valid() && count.get_integer() < 0)
+		{
+			log_error(line, "Repeat count can't be negative");
+		}
+
+		data = consume_whitespace(data, end);
+		if (data >= end || *data != '{')
+		{
+			log_error(line, "Expected '{' after repeat count");
+			return consume_to_char(data, end, '}') + 1;
+		}
+		++data;
+
+		if (m_RepeatHead >= 0)
+			log_error(line, "Repeat blocks can't be nested");
+
+		const int outer = m_RepeatHead;
+		const size_t first = m_Statements.size();
+		if (outer < 0)
+			m_RepeatHead = static_cast<int>(first);
+
+		while (1)
+		{
+			data = consume_whitespace(data, end);
+			if (data >= end || !*data)
+			{
+				log_error(line, "Repeat block not terminated");
+				break;
+			}
+
+			if (*data == '}')
+			{
+				++data;
+				break;
+			}
+			data = consume_statement(data, end);
+		}
+		m_RepeatHead = outer;
+
+		// each call site is counted once when the result matrix is sized, so a
+		// call that adds results would overrun it when run once per pass
+		for (size_t s = first; s < m_Statements.size(); ++s)
+		{
+			const statement& stmt = m_Statements[s];
+			if (stmt.Func && stmt.Func->has_side_effects())
+				log_error(stmt.Line, "'%s' has side effects and can't be called in a repeat block", stmt.Func->get_name());
+		}
+
+		if (m_Statements.size() == first)
+		{
+			log_warning(line, "Repeat block is empty");
+		}
+		else if (outer < 0)
+		{
+			statement& head = m_Statements[first];
+			head.RepeatStatements = static_cast<int>(m_Statements.size() - first - 1);
+			head.RepeatCount.Constant = count;
+		}
+
+		return data;
+	}
+
 	//----------------------------------------------------------------------------
 
 	const char* program::consume_declaration(
@@ -698,6 +794,14 @@ namespace image_processing
 		va_end(args);
 	}
 
+	void program::log_note(int line, const char* fmt, ...)
+	{
+		va_list args;
+		va_start(args, fmt);
+		log(m_Notes, line, fmt, args);
+		va_end(args);
+	}
+
 	void program::log_error(int line, const char* fmt, ...)
 	{
 		va_list args;
@@ -724,6 +828,7 @@ namespace image_processing
 	{
 		print(output, "Error", m_Errors);
 		print(output, "Warning", m_Warnings);
+		print(output, "Note", m_Notes);
 
 		output.write_ln("%d Errors, %d Warnings", (int)m_Errors.size(), (int)m_Warnings.size());
 	}
@@ -779,6 +884,916 @@ namespace image_processing
 
 	//----------------------------------------------------------------------------
 
+	int program::get_slot(const std::string& name) const
+	{
+		auto it = m_Symbols.find(name);
+		if (it != m_Symbols.end())
+			return it->second->Slot;
+		return -1;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compile()
+	{
+		// assign every declaration a slot in the register file
+		for (auto* list : { &m_Constants, &m_Inputs, &m_Outputs, &m_Temporaries })
+		{
+			for (auto& decl : *list)
+			{
+				decl.Slot = static_cast<int>(m_Slots.size());
+				m_Slots.push_back(&decl);
+			}
+		}
+
+		m_SrcSlot = get_slot("__src__");
+		m_DstSlot = get_slot("__dst__");
+		m_WidthSlot = get_slot("__width__");
+		m_HeightSlot = get_slot("__height__");
+
+		// constants can only be bound at compile time if no statement writes to them
+		std::vector<bool> written(m_Slots.size(), false);
+		for (auto& stmt : m_Statements)
+		{
+			for (auto& p : stmt.Func->get_outputs())
+			{
+				value dst_arg;
+				if (stmt.Arguments.try_get(p.Name, dst_arg) && dst_arg.get_type() == ObjectType::Name)
+					written[get_slot(dst_arg.get_name())] = true;
+			}
+		}
+
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			compile_statement(m_Statements[s], written);
+			if (m_Statements[s].RepeatHead == static_cast<int>(s))
+				compile_repeat(m_Statements[s], written);
+		}
+
+		// report images that functions can't be used with before anything is 
+		// run, the source image can be any format or size at this point.
+		std::vector<image_shape> shapes;
+		propagate_shapes(image_shape(), nullptr, shapes, &m_Errors, &m_Warnings);
+
+		eliminate_common_subexpressions();
+		find_repeat_heads();
+		eliminate_dead_statements();
+		find_repeat_heads();
+		compute_liveness();
+		compute_dependencies();
+		compute_strips();
+		compute_fusion();
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compile_repeat(statement& head, const std::vector<bool>& written)
+	{
+		operand& count = head.RepeatCount;
+		if (count.Constant.get_type() != ObjectType::Name)
+			return;
+
+		// a constant count is bound now, anything else is read as the block starts
+		const declaration* decl = m_Symbols.find(count.Constant.get_name())->second;
+		if (decl->Modifier == declaration::TypeModifier::Constant && !written[decl->Slot])
+		{
+			count.Constant = decl->Value;
+			if (count.Constant.get_type() != ObjectType::Integer || count.Constant.get_integer() < 0)
+				log_error(head.Line, "Repeat count '%s' can't be '%s'", decl->Name.c_str(), decl->Value.to_string().c_str());
+		}
+		else
+		{
+			count.Constant = value();
+			count.Slot = decl->Slot;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::find_repeat_heads()
+	{
+		// only statements outside repeat blocks are ever removed, so each block
+		// is still a run of statements that all have the same, possibly out of
+		// date, head.
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			const int head = m_Statements[s].RepeatHead;
+			if (head < 0)
+				continue;
+
+			size_t last = s;
+			while (last + 1 < m_Statements.size() && m_Statements[last + 1].RepeatHead == head)
+				++last;
+
+			for (size_t f = s; f <= last; ++f)
+				m_Statements[f].RepeatHead = static_cast<int>(s);
+			s = last;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	static std::string get_call_key(const statement& stmt)
+	{
+		// function name and resolved arguments, floats are written exactly so
+		// only identical values match
+		std::string key = stmt.Func->get_name();
+		char buf[64];
+		for (auto& op : stmt.Inputs)
+		{
+			if (!op.is_constant())
+				snprintf(buf, sizeof(buf), "|s%d", op.Slot);
+			else if (op.Constant.get_type() == ObjectType::Float)
+				snprintf(buf, sizeof(buf), "|f%a", op.Constant.get_float());
+			else
+				snprintf(buf, sizeof(buf), "|%d:", static_cast<int>(op.Constant.get_type()));
+
+			key += buf;
+			if (op.is_constant() && op.Constant.get_type() != ObjectType::Float)
+				key += op.Constant.to_string();
+		}
+		return key;
+	}
+
+	//----------------------------------------------------------------------------
+
+	static bool writes_slot(const statement& stmt, int slot)
+	{
+		return std::find(stmt.Outputs.begin(), stmt.Outputs.end(), slot) != stmt.Outputs.end();
+	}
+
+	//----------------------------------------------------------------------------
+
+	static bool reads_slot(const statement& stmt, int slot)
+	{
+		for (auto& op : stmt.Inputs)
+		{
+			if (!op.is_constant() && op.Slot == slot)
+				return true;
+		}
+		return false;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::reuse_result(size_t from, size_t to)
+	{
+		const statement& src = m_Statements[from];
+		const statement& dst = m_Statements[to];
+
+		// later reads of each of dst's outputs are redirected to src's until the 
+		// output is next written, which requires src's output to still hold the
+		// same value when they happen.
+		std::vector<std::pair<operand*, int>> renames;
+		for (size_t i = 0; i < dst.Outputs.size(); ++i)
+		{
+			const int old_slot = dst.Outputs[i];
+			const int new_slot = src.Outputs[i];
+			if (old_slot == new_slot)
+				continue;
+
+			bool overwritten = false;
+			bool redefined = false;
+			for (size_t t = to + 1; t < m_Statements.size() && !redefined; ++t)
+			{
+				statement& stmt = m_Statements[t];
+
+				// a repeat block reads what it wrote in the previous iteration
+				// so can't be redirected
+				if (stmt.RepeatHead == static_cast<int>(t) && stmt.RepeatCount.Slot == old_slot)
+					return false;
+
+				for (auto& op : stmt.Inputs)
+				{
+					if (op.is_constant() || op.Slot != old_slot)
+						continue;
+
+					if (overwritten || stmt.RepeatHead >= 0)
+						return false;
+					renames.push_back(std::make_pair(&op, new_slot));
+				}
+
+				overwritten |= writes_slot(stmt, new_slot);
+				redefined = writes_slot(stmt, old_slot);
+			}
+
+			// the caller reads program outputs once the program completes
+			if (!redefined && m_Slots[old_slot]->Modifier == declaration::TypeModifier::Output)
+				return false;
+		}
+
+		for (auto& r : renames)
+			r.first->Slot = r.second;
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	static image_shape merge_shapes(const image_shape& a, const image_shape& b)
+	{
+		// the parts of the shape that are the same in both
+		if (a == b)
+			return a;
+
+		image_shape merged;
+		if (a.HasFormat && b.HasFormat && a.Format == b.Format)
+		{
+			merged.HasFormat = true;
+			merged.Format = a.Format;
+		}
+		return merged;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::infer_shapes(const image_shape& src, const value* registers, 
+		std::vector<image_shape>& shapes, std::string* error) const
+	{
+		ErrorList errors;
+		if (propagate_shapes(src, registers, shapes, &errors, nullptr))
+			return true;
+
+		if (error)
+		{
+			char line[32];
+			snprintf(line, sizeof(line), "Line %d : ", errors.front().Line + 1);
+			*error = line + errors.front().Message;
+		}
+		return false;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::propagate_shapes(const image_shape& src, const value* registers, 
+		std::vector<image_shape>& shapes, ErrorList* errors, ErrorList* warnings) const
+	{
+		// shape of the image in each slot as the statements are run in order
+		std::vector<image_shape> slots(m_Slots.size());
+		slots[m_SrcSlot] = src;
+		shapes.assign(m_Statements.size(), image_shape());
+
+		bool ok = true;
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			const statement& stmt = m_Statements[s];
+			if (stmt.RepeatHead != static_cast<int>(s))
+			{
+				ok &= propagate_statement(s, registers, slots, shapes, errors, warnings);
+				continue;
+			}
+
+			// a repeat block also runs on what its previous iteration wrote, 
+			// or not at all, so anything that changes between iterations is 
+			// unknown. Only known values become unknown so this settles.
+			const size_t last = s + stmt.RepeatStatements;
+			std::vector<image_shape> entry;
+			do
+			{
+				entry = slots;
+				for (size_t f = s; f <= last; ++f)
+					propagate_statement(f, registers, slots, shapes, nullptr, nullptr);
+
+				for (size_t i = 0; i < slots.size(); ++i)
+					slots[i] = merge_shapes(entry[i], slots[i]);
+			} while (slots != entry);
+
+			for (size_t f = s; f <= last; ++f)
+				ok &= propagate_statement(f, registers, slots, shapes, errors, warnings);
+			slots = entry;
+			s = last;
+		}
+		return ok;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::propagate_statement(size_t s, const value* registers, std::vector<image_shape>& slots,
+		std::vector<image_shape>& shapes, ErrorList* errors, ErrorList* warnings) const
+	{
+		const statement& stmt = m_Statements[s];
+		auto& params = stmt.Func->get_inputs();
+		std::vector<value> args(params.size());
+		std::vector<image_shape> inputs(params.size());
+		for (size_t i = 0; i < params.size(); ++i)
+		{
+			const operand& op = stmt.Inputs[i];
+			if (op.is_constant())
+				args[i] = op.Constant;
+			else if (params[i].Type == ObjectType::Image)
+				inputs[i] = slots[op.Slot];
+			else if (registers)
+				args[i] = registers[op.Slot];
+		}
+
+		std::string message;
+		const bool valid = stmt.Func->infer_shape(args.data(), inputs.data(), shapes[s], message);
+		ErrorList* list = valid ? warnings : errors;
+		if (list && (!valid || !message.empty()))
+		{
+			program_error e;
+			e.Message = std::string("Function '") + stmt.Func->get_name() + "' : " + message;
+			e.Line = stmt.Line;
+			list->push_back(e);
+		}
+
+		for (size_t i = 0; i < stmt.Outputs.size(); ++i)
+		{
+			if (stmt.Outputs[i] >= 0)
+				slots[stmt.Outputs[i]] = i == 0 ? shapes[s] : image_shape();
+		}
+		return valid;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::eliminate_common_subexpressions()
+	{
+		// an identical call to an earlier one reuses its result as long as none
+		// of the earlier call's inputs or outputs have been written in between.
+		std::map<std::string, size_t> available;
+		std::vector<bool> merged(m_Statements.size(), false);
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			statement& stmt = m_Statements[s];
+			if (stmt.Func->has_side_effects() || stmt.Outputs.empty() ||
+				std::find(stmt.Outputs.begin(), stmt.Outputs.end(), -1) != stmt.Outputs.end())
+			{
+				continue;
+			}
+
+			// statements in a repeat block run more than once so are never 
+			// merged, but still overwrite their outputs
+			const bool repeated = in_repeat(s);
+			const std::string key = get_call_key(stmt);
+			auto match = available.find(key);
+			if (!repeated && match != available.end() && reuse_result(match->second, s))
+			{
+				log_note(stmt.Line, "Call to '%s' is identical to the call on line %d and reuses its result",
+					stmt.Func->get_name(), m_Statements[match->second].Line + 1);
+				merged[s] = true;
+				continue;
+			}
+
+			// anything that depends on a slot written here is no longer available
+			for (auto it = available.begin(); it != available.end();)
+			{
+				const statement& prev = m_Statements[it->second];
+				bool invalid = false;
+				for (int slot : stmt.Outputs)
+					invalid |= writes_slot(prev, slot) || reads_slot(prev, slot);
+
+				if (invalid)
+					it = available.erase(it);
+				else
+					++it;
+			}
+
+			// a call that overwrites one of its own inputs can't be matched
+			bool self_update = false;
+			for (int slot : stmt.Outputs)
+				self_update |= reads_slot(stmt, slot);
+
+			if (!self_update && !repeated)
+				available[key] = s;
+		}
+
+		size_t count = 0;
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			if (merged[s])
+				continue;
+
+			if (count != s)
+				m_Statements[count] = std::move(m_Statements[s]);
+			++count;
+		}
+		m_Statements.resize(count);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::eliminate_dead_statements()
+	{
+		// results are needed if they reach a program output or are read by a 
+		// statement that is itself needed, anything else is never executed.
+		std::vector<bool> live(m_Slots.size(), false);
+		for (auto& decl : m_Outputs)
+			live[decl.Slot] = true;
+
+		std::vector<bool> needed(m_Statements.size(), false);
+		for (size_t s = m_Statements.size(); s-- > 0; )
+		{
+			const statement& stmt = m_Statements[s];
+			bool keep = stmt.Func->has_side_effects() || stmt.Outputs.empty() || in_repeat(s);
+			for (int slot : stmt.Outputs)
+			{
+				if (slot >= 0 && live[slot])
+					keep = true;
+			}
+
+			if (!keep)
+				continue;
+
+			// repeat blocks are always kept and can run any number of times, 
+			// including none, so what they write may still be needed before them
+			needed[s] = true;
+			for (int slot : stmt.Outputs)
+			{
+				if (slot >= 0 && !in_repeat(s))
+					live[slot] = false;
+			}
+
+			for (auto& op : stmt.Inputs)
+			{
+				if (!op.is_constant())
+					live[op.Slot] = true;
+			}
+
+			if (stmt.RepeatHead == static_cast<int>(s) && !stmt.RepeatCount.is_constant())
+				live[stmt.RepeatCount.Slot] = true;
+		}
+
+		size_t count = 0;
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			if (!needed[s])
+				continue;
+
+			if (count != s)
+				m_Statements[count] = std::move(m_Statements[s]);
+			++count;
+		}
+		m_Statements.resize(count);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_liveness()
+	{
+		// program outputs are read by the caller after the last statement
+		std::vector<bool> live(m_Slots.size(), false);
+		for (auto& decl : m_Outputs)
+			live[decl.Slot] = true;
+
+		// walk backwards, a slot is dead before a statement that writes it and
+		// live before one that reads it.
+		for (size_t s = m_Statements.size(); s-- > 0; )
+		{
+			const int head = m_Statements[s].RepeatHead;
+			if (head < 0)
+			{
+				compute_liveness(m_Statements[s], live);
+				continue;
+			}
+
+			// the end of a repeat block is followed by its start as well as 
+			// whatever comes after it, and it may not run at all. A second pass
+			// with what's live at the start added to the end is enough to 
+			// include everything read by a later iteration.
+			const std::vector<bool> after = live;
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				for (size_t f = s + 1; f-- > static_cast<size_t>(head); )
+					compute_liveness(m_Statements[f], live);
+
+				for (size_t i = 0; i < live.size(); ++i)
+					live[i] = live[i] || after[i];
+			}
+
+			const operand& count = m_Statements[head].RepeatCount;
+			if (!count.is_constant())
+				live[count.Slot] = true;
+			s = head;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_liveness(statement& stmt, std::vector<bool>& live)
+	{
+		for (int slot : stmt.Outputs)
+		{
+			if (slot >= 0)
+				live[slot] = false;
+		}
+
+		for (auto& op : stmt.Inputs)
+		{
+			if (!op.is_constant())
+				op.LastUse = !live[op.Slot];
+		}
+
+		// the function can overwrite its first input if it's an image that
+		// dies here and no other argument of this call refers to it.
+		stmt.ReuseSource = false;
+		auto& inputs = stmt.Func->get_inputs();
+		auto& outputs = stmt.Func->get_outputs();
+		if (!stmt.Inputs.empty() && !outputs.empty() &&
+			inputs[0].Type == ObjectType::Image && outputs[0].Type == ObjectType::Image &&
+			!stmt.Inputs[0].is_constant() && stmt.Inputs[0].LastUse &&
+			stmt.Outputs[0] >= 0)
+		{
+			stmt.ReuseSource = true;
+			for (size_t i = 1; i < stmt.Inputs.size(); ++i)
+			{
+				if (stmt.Inputs[i].Slot == stmt.Inputs[0].Slot)
+					stmt.ReuseSource = false;
+			}
+		}
+
+		for (auto& op : stmt.Inputs)
+		{
+			if (!op.is_constant())
+				live[op.Slot] = true;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compile_statement(statement& stmt, const std::vector<bool>& written)
+	{
+		auto& inputs = stmt.Func->get_inputs();
+		stmt.Inputs.resize(inputs.size());
+		for (size_t i = 0; i < inputs.size(); ++i)
+		{
+			const param_desc& p = inputs[i];
+			operand& op = stmt.Inputs[i];
+
+			value arg;
+			if (!stmt.Arguments.try_get(p.Name, arg))
+			{
+				// use default value
+				op.Constant = p.DefaultVal;
+			}
+			else if (arg.get_type() != ObjectType::Name)
+			{
+				op.Constant = arg;
+				if (!p.ValidationFunction(arg))
+					log_error(stmt.Line, "Param '%s' to function '%s' cannot be assigned '%s'", p.Name.c_str(), stmt.Func->get_name(), arg.to_string().c_str());
+			}
+			else
+			{
+				const declaration* decl = m_Symbols.find(arg.get_name())->second;
+
+				// bind constants now, they are validated once here. Anything 
+				// else is validated when the program is executed.
+				if (decl->Modifier == declaration::TypeModifier::Constant &&
+					!written[decl->Slot] &&
+					decl->Value.get_type() == p.Type)
+				{
+					op.Constant = decl->Value;
+					if (!p.ValidationFunction(decl->Value))
+						log_error(stmt.Line, "Param '%s' to function '%s' cannot be assigned '%s'", p.Name.c_str(), stmt.Func->get_name(), decl->Value.to_string().c_str());
+				}
+				else
+				{
+					op.Slot = decl->Slot;
+				}
+			}
+		}
+
+		auto& outputs = stmt.Func->get_outputs();
+		stmt.Outputs.resize(outputs.size(), -1);
+		for (size_t i = 0; i < outputs.size(); ++i)
+		{
+			value dst_arg;
+			if (stmt.Arguments.try_get(outputs[i].Name, dst_arg) && dst_arg.get_type() == ObjectType::Name)
+				stmt.Outputs[i] = get_slot(dst_arg.get_name());
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_dependencies()
+	{
+		// per slot, the last statement to write it and the statements that
+		// have read it since
+		std::vector<int> writer(m_Slots.size(), -1);
+		std::vector<std::vector<int>> readers(m_Slots.size());
+		int last_side_effect = -1;
+
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			statement& stmt = m_Statements[s];
+			std::set<int> deps;
+
+			for (auto& op : stmt.Inputs)
+			{
+				if (op.is_constant())
+					continue;
+
+				// read after write
+				if (writer[op.Slot] >= 0)
+					deps.insert(writer[op.Slot]);
+
+				// the last reader may overwrite or release the image so has
+				// to wait for every other reader
+				if (op.LastUse)
+					deps.insert(readers[op.Slot].begin(), readers[op.Slot].end());
+			}
+
+			for (int slot : stmt.Outputs)
+			{
+				if (slot < 0)
+					continue;
+
+				// write after write and write after read
+				if (writer[slot] >= 0)
+					deps.insert(writer[slot]);
+				deps.insert(readers[slot].begin(), readers[slot].end());
+			}
+
+			// calls with side effects stay in program order
+			if (stmt.Func->has_side_effects())
+			{
+				if (last_side_effect >= 0)
+					deps.insert(last_side_effect);
+				last_side_effect = static_cast<int>(s);
+			}
+
+			deps.erase(static_cast<int>(s));
+			stmt.Dependents.clear();
+			stmt.NumDependencies = static_cast<int>(deps.size());
+			for (int d : deps)
+				m_Statements[d].Dependents.push_back(static_cast<int>(s));
+
+			for (auto& op : stmt.Inputs)
+			{
+				if (!op.is_constant())
+					readers[op.Slot].push_back(static_cast<int>(s));
+			}
+
+			for (int slot : stmt.Outputs)
+			{
+				if (slot < 0)
+					continue;
+				writer[slot] = static_cast<int>(s);
+				readers[slot].clear();
+			}
+		}
+
+		// group statements into waves that could run together, if any wave has 
+		// more than one statement in it there are independent branches
+		std::vector<int> wave(m_Statements.size(), 0);
+		std::vector<int> wave_size(m_Statements.size() + 1, 0);
+		m_ParallelBranches = false;
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			for (int d : m_Statements[s].Dependents)
+				wave[d] = std::max(wave[d], wave[s] + 1);
+
+			if (++wave_size[wave[s]] > 1)
+				m_ParallelBranches = true;
+		}
+
+		// repeat blocks are run in order on the calling thread
+		for (auto& stmt : m_Statements)
+		{
+			if (stmt.RepeatHead >= 0)
+				m_ParallelBranches = false;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::can_chain(size_t prev_index, size_t next_index) const
+	{
+		const statement& prev = m_Statements[prev_index];
+		const statement& next = m_Statements[next_index];
+		if (next.Inputs.empty() || next.Outputs.size() != 1 || next.Outputs[0] < 0 ||
+			next.RepeatHead != prev.RepeatHead)
+		{
+			return false;
+		}
+
+		// next has to consume prev's result and be the only thing that does
+		const int slot = prev.Outputs[0];
+		if (next.Inputs[0].Slot != slot || !next.Inputs[0].LastUse)
+			return false;
+
+		for (size_t i = 1; i < next.Inputs.size(); ++i)
+		{
+			if (next.Inputs[i].Slot == slot)
+				return false;
+		}
+
+		// and it mustn't wait on anything else so the whole run can start as
+		// soon as the first statement can
+		return next.NumDependencies == 1 &&
+			std::find(prev.Dependents.begin(), prev.Dependents.end(), static_cast<int>(next_index)) != prev.Dependents.end();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::can_fuse(size_t prev_index, size_t next_index) const
+	{
+		const statement& next = m_Statements[next_index];
+		return next.Func->is_pointwise() && next.StripHead < 0 && can_chain(prev_index, next_index);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_strips()
+	{
+		// find runs of statements where each one feeds the next and only reads 
+		// pixels near each output pixel, these can be run a strip of rows at a
+		// time so the intermediate images are never full size. Runs of only
+		// pointwise statements are fused instead.
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			statement& head = m_Statements[s];
+			head.StripStatements = 0;
+			head.StripHead = -1;
+
+			if (head.Func->get_footprint() == function::Footprint::Global || head.Inputs.empty() ||
+				head.Inputs[0].is_constant() || head.Outputs.size() != 1 || head.Outputs[0] < 0)
+			{
+				continue;
+			}
+
+			size_t last = s;
+			bool neighbourhood = head.Func->get_footprint() == function::Footprint::Neighbourhood;
+			while (last + 1 < m_Statements.size() &&
+				m_Statements[last + 1].Func->get_footprint() != function::Footprint::Global &&
+				can_chain(last, last + 1))
+			{
+				++last;
+				neighbourhood |= m_Statements[last].Func->get_footprint() == function::Footprint::Neighbourhood;
+			}
+
+			if (last > s && neighbourhood)
+			{
+				for (size_t f = s + 1; f <= last; ++f)
+				{
+					m_Statements[f].StripHead = static_cast<int>(s);
+					m_Statements[f].StripStatements = 0;
+				}
+				head.StripStatements = static_cast<int>(last - s);
+			}
+			s = last;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_fusion()
+	{
+		// find runs of pointwise statements where each one feeds the next and
+		// the intermediate images are dead, these can be run as one pass.
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			statement& head = m_Statements[s];
+			head.FusedStatements = 0;
+			head.FusedHead = -1;
+
+			if (!head.Func->is_pointwise() || head.Inputs.empty() || head.StripStatements > 0 || head.StripHead >= 0 ||
+				head.Inputs[0].is_constant() || head.Outputs.size() != 1 || head.Outputs[0] < 0)
+			{
+				continue;
+			}
+
+			size_t last = s;
+			while (last + 1 < m_Statements.size() && 
+				can_fuse(last, last + 1))
+			{
+				++last;
+				m_Statements[last].FusedHead = static_cast<int>(s);
+				m_Statements[last].FusedStatements = 0;
+			}
+
+			head.FusedStatements = static_cast<int>(last - s);
+			compute_lut(s);
+			s = last;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::compute_lut(size_t s)
+	{
+		statement& head = m_Statements[s];
+		const size_t last = s + head.FusedStatements;
+		head.LutChannels = 0;
+		head.Lut.clear();
+
+		// all of the run has to be lookups on the same kind of image
+		const int channels = head.Func->get_lut_channels();
+		if (channels == 0 || head.FusedStatements == 0)
+			return;
+
+		bool constant = true;
+		for (size_t f = s; f <= last; ++f)
+		{
+			const statement& stmt = m_Statements[f];
+			if (stmt.Func->get_lut_channels() != channels)
+				return;
+
+			for (size_t i = 1; i < stmt.Inputs.size(); ++i)
+				constant &= stmt.Inputs[i].is_constant();
+		}
+		head.LutChannels = channels;
+
+		// with constant arguments the table never changes so fold it now
+		if (!constant)
+			return;
+
+		std::vector<kv_dict> args(last - s + 1);
+		for (size_t f = s; f <= last; ++f)
+		{
+			auto& params = m_Statements[f].Func->get_inputs();
+			for (size_t i = 1; i < params.size(); ++i)
+				args[f - s].set(params[i].Name, m_Statements[f].Inputs[i].Constant);
+		}
+
+		std::array<uint8_t, 256> lut;
+		if (fold_lut(s, args.data(), lut))
+			head.Lut.assign(lut.begin(), lut.end());
+		else
+			head.LutChannels = 0;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program::fold_lut(size_t s, const kv_dict* args, std::array<uint8_t, 256>& lut) const
+	{
+		const statement& head = m_Statements[s];
+		for (int i = 0; i < 256; ++i)
+			lut[i] = static_cast<uint8_t>(i);
+
+		for (int f = 0; f <= head.FusedStatements; ++f)
+		{
+			std::array<uint8_t, 256> stage;
+			if (!m_Statements[s + f].Func->get_lut(args[f], stage))
+				return false;
+
+			for (int i = 0; i < 256; ++i)
+				lut[i] = stage[lut[i]];
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::find_invariant_statements(const std::vector<std::string>& swept, 
+		std::vector<char>& invariant, std::vector<char>& needed) const
+	{
+		std::vector<char> varies(m_Slots.size(), 0);
+		for (auto& name : swept)
+		{
+			int slot = get_slot(name);
+			if (slot >= 0)
+				varies[slot] = 1;
+		}
+
+		// a statement varies if any of its inputs do, statements with side 
+		// effects or in repeat blocks are always executed so are treated as 
+		// varying.
+		std::vector<int> def(m_Slots.size(), -1);
+		invariant.assign(m_Statements.size(), 0);
+		needed.assign(m_Statements.size(), 0);
+		for (size_t s = 0; s < m_Statements.size(); ++s)
+		{
+			const statement& stmt = m_Statements[s];
+			bool var = stmt.Func->has_side_effects() || stmt.RepeatHead >= 0;
+			for (auto& op : stmt.Inputs)
+			{
+				if (!op.is_constant() && varies[op.Slot])
+					var = true;
+			}
+			invariant[s] = var ? 0 : 1;
+
+			// anything that's executed needs the results of the invariant 
+			// statements that defined its inputs
+			if (var)
+			{
+				for (auto& op : stmt.Inputs)
+				{
+					if (!op.is_constant() && def[op.Slot] >= 0 && invariant[def[op.Slot]])
+						needed[def[op.Slot]] = 1;
+				}
+			}
+
+			for (int slot : stmt.Outputs)
+			{
+				if (slot < 0)
+					continue;
+
+				varies[slot] = var ? 1 : 0;
+				def[slot] = static_cast<int>(s);
+			}
+		}
+
+		// as does the caller
+		for (auto& decl : m_Outputs)
+		{
+			const int d = def[decl.Slot];
+			if (d >= 0 && invariant[d])
+				needed[d] = 1;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
 	bool program::writes_to_default_dest() const
 	{
 		for (auto decl : m_Outputs)
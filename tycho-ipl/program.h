@@ -37,6 +37,8 @@
 #include "key_value.h"
 #include "functions/factory.h"
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <list>
@@ -94,6 +96,9 @@ namespace image_processing
 
 		declaration() = default;
 
+		/// Index of this declaration in the register file. Assigned by program::compile.
+		int get_slot() const { return Slot; }
+
 		ObjectType		Type;
 		TypeModifier	Modifier;
 		std::string		Name;
@@ -103,6 +108,7 @@ namespace image_processing
 		friend program;
 		int RefCount = 0;
 		int DeclLine;
+		int Slot = -1;
 	};
 
 	enum class StatementList
@@ -112,21 +118,78 @@ namespace image_processing
 	};
 
 	
+	//----------------------------------------------------------------------------
+	// Compiled function argument. Either a slot in the context register file or
+	// a constant that was bound when the program was compiled.
+	//----------------------------------------------------------------------------
+	struct operand
+	{
+		bool is_constant() const { return Slot < 0; }
+
+		int   Slot = -1;
+		value Constant;
+		bool  LastUse = false;	///< slot is not read again before it is next written
+	};
+
+	using operand_list = std::vector < operand > ;
+	using slot_list = std::vector < int > ;
+
+	
 	struct statement
 	{
-		statement(StatementList type, const char* name, function* func, const kv_dict& args) :
+		statement(StatementList type, const char* name, const function* func, const kv_dict& args, int line) :
 			Type(type),
 			Name(name),
 			Func(func),
-			Arguments(args)
+			Arguments(args),
+			Line(line)
 		{}
 
 		statement() = default;
 
 		StatementList Type;
 		std::string	  Name;
-		function*	  Func;
+		const function* Func;
 		kv_dict		  Arguments;
+		int			  Line = -1;
+
+		// Compiled form, one entry per function input and output in the order
+		// they are declared by the function.
+		operand_list  Inputs;
+		slot_list	  Outputs;
+
+		/// The first input is an image slot that dies at this statement so
+		/// the function may write its result over it.
+		bool		  ReuseSource = false;
+
+		/// Statements that can't start until this one has completed and the
+		/// number of statements this one waits on.
+		std::vector<int> Dependents;
+		int			  NumDependencies = 0;
+
+		/// Number of following pointwise statements fused into this one and 
+		/// for those the statement they were fused into.
+		int			  FusedStatements = 0;
+		int			  FusedHead = -1;
+
+		/// The fused statements are all table lookups on images with this 
+		/// many channels and can be applied as a single table. The table is
+		/// built when the program is compiled if all their arguments are 
+		/// constant, otherwise it's built by the context.
+		int			  LutChannels = 0;
+		std::vector<uint8_t> Lut;
+
+		/// Number of following statements run a strip of rows at a time with
+		/// this one and for those the statement that runs them.
+		int			  StripStatements = 0;
+		int			  StripHead = -1;
+
+		/// Every statement in the body of a repeat block has the index of the 
+		/// first one in it. That one has the number of statements following it
+		/// in the body and the number of times the body is run.
+		int			  RepeatHead = -1;
+		int			  RepeatStatements = 0;
+		operand		  RepeatCount;
 	};
 
 	struct program_error
@@ -138,10 +201,11 @@ namespace image_processing
 
 
 	using declaration_list = std::list < declaration > ;
-	using statement_list = std::list < statement > ;
+	using statement_list = std::vector < statement > ;
 
 	//----------------------------------------------------------------------------
-	// Filter program
+	// Filter program. It isn't changed once it has been loaded, so one program
+	// can be run on any number of threads at once, each with its own context.
 	//----------------------------------------------------------------------------
 	class TYCHO_IMAGEPROCESSING_ABI program
 	{
@@ -155,11 +219,30 @@ namespace image_processing
 
 		/// Create from a program stored in a file
 		static std::unique_ptr<program> create_from_file(const char *path);
+
+		/// Create from a program stored in a file, reusing its compiled form 
+		/// if the source hasn't changed since it was last compiled. Compiled 
+		/// programs are stored in compiled_dir keyed by the hash of their
+		/// source, or next to the source as <path>c if it's null. A path to a 
+		/// compiled .fxc file is loaded directly.
+		static std::unique_ptr<program> create_from_file_cached(const char *path, const char* compiled_dir = nullptr);
+
+		/// Create from the compiled form written by save_compiled. Returns 
+		/// nullptr if it's invalid, was built from a source with a different
+		/// hash, or refers to functions whose parameters have changed.
+		static std::unique_ptr<program> create_from_compiled(const char* data, size_t len, const char* source_path, uint64_t source_hash = 0);
+
+		/// Append the compiled form of the program to data
+		void save_compiled(std::vector<char>& data, uint64_t source_hash) const;
+
+		/// Hash of the functions the library provides and their parameters,
+		/// anything keyed by what a program's statements mean includes it
+		static uint64_t get_library_hash();
 		
 		/// \returns True if the program contains errors
 		bool has_errors() const  { return !m_Errors.empty(); }
 
-		/// Print all errors and warnings to stdout
+		/// Print all errors, warnings and notes to stdout
 		void print_messages(runtime::output_interface& output) const;
 
 		/// Return the input of the given name or nullptr if it doesn't exist
@@ -190,6 +273,36 @@ namespace image_processing
 		/// Returns the number of output images the program generates
 		size_t num_output_images() const;
 
+		/// Returns the number of slots in the register file needed to execute the program
+		size_t num_slots() const { return m_Slots.size(); }
+
+		/// Returns the declaration bound to the passed slot
+		const declaration& get_slot_declaration(int slot) const { return *m_Slots[slot]; }
+
+		/// Returns the slot of the named symbol or -1 if it doesn't exist
+		int get_slot(const std::string& name) const;
+
+		/// Compose the tables of the lookup functions fused into statement s 
+		/// into one. args holds the arguments for each of those statements.
+		bool fold_lut(size_t s, const kv_dict* args, std::array<uint8_t, 256>& lut) const;
+
+		/// Find the statements whose results don't change when the named inputs
+		/// do and of those the ones whose results are read by statements that
+		/// do change, or are program outputs.
+		void find_invariant_statements(const std::vector<std::string>& swept, 
+			std::vector<char>& invariant, std::vector<char>& needed) const;
+
+		/// Infer the format and size of the image written by each statement 
+		/// when the program is run on a source image of the given shape, using
+		/// the values of the other registers if they are passed. Returns false
+		/// with the first statement that can't use its inputs in error.
+		bool infer_shapes(const image_shape& src, const value* registers, 
+			std::vector<image_shape>& shapes, std::string* error = nullptr) const;
+
+		/// Returns true if some statements are independent of each other and
+		/// can be executed concurrently
+		bool has_parallel_branches() const { return m_ParallelBranches; }
+
 	private:
 
 		using ErrorList = std::vector < program_error > ;
@@ -198,10 +311,11 @@ namespace image_processing
 		const char* consume_statement(const char* data, const char* end);
 		const char* consume_declaration(declaration::TypeModifier type, declaration_list& dst_list, const char* data, const char* end);
 		const char* consume_function_call(const char* data, const char* end);
+		const char* consume_repeat(const char* data, const char* end);
 		const char* consume_alpha_word(const char *data, const char* end, char *out_buffer, size_t buffer_len);
 		const char* consume_whitespace(const char* data, const char* end);
 		const char* consume_to_eol(const char* data, const char* end);
-		const char* consume_kvdict(function* func, const char* data, const char* end, kv_dict& parts);
+		const char* consume_kvdict(const function* func, const char* data, const char* end, kv_dict& parts);
 		const char* consume_to_char(const char* data, const char* end, char ch);
 		const char* consume_value(const char *data, const char* end, value& out_value);
 		const char* consume_value_checked(const char *data, const char* end, value& out_value);
@@ -211,11 +325,32 @@ namespace image_processing
 		void log(ErrorList& list, int line, const char* fmt, va_list args);
 		void log_error(int line, const char* msg, ...);
 		void log_warning(int line, const char* msg, ...);
+		void log_note(int line, const char* msg, ...);
 		void check_for_unused(const declaration_list&);
 		void add_declaration(declaration_list& dst_list, const declaration& decl);
 		void add_internal_declaration(declaration_list& dst_list, declaration decl);
 		void set_function_constants(const function*);
 		void add_constant_integer(const char* name, int val);
+		void compile();
+		void compile_statement(statement& stmt, const std::vector<bool>& written);
+		void compile_repeat(statement& head, const std::vector<bool>& written);
+		void find_repeat_heads();
+		bool in_repeat(size_t s) const { return m_Statements[s].RepeatHead >= 0; }
+		bool propagate_shapes(const image_shape& src, const value* registers, 
+			std::vector<image_shape>& shapes, ErrorList* errors, ErrorList* warnings) const;
+		bool propagate_statement(size_t s, const value* registers, std::vector<image_shape>& slots,
+			std::vector<image_shape>& shapes, ErrorList* errors, ErrorList* warnings) const;
+		void eliminate_common_subexpressions();
+		bool reuse_result(size_t from, size_t to);
+		void eliminate_dead_statements();
+		void compute_liveness();
+		void compute_liveness(statement& stmt, std::vector<bool>& live);
+		void compute_dependencies();
+		void compute_strips();
+		void compute_fusion();
+		void compute_lut(size_t s);
+		bool can_chain(size_t prev, size_t next) const;
+		bool can_fuse(size_t prev, size_t next) const;
 
 	private:
 		functions::factory m_FunctionFactory;
@@ -225,8 +360,15 @@ namespace image_processing
 		declaration_list m_Constants;
 		declaration_list m_Temporaries;
 		statement_list   m_Statements;
+		std::vector<declaration*> m_Slots;
+		int				m_SrcSlot = -1;
+		int				m_DstSlot = -1;
+		int				m_WidthSlot = -1;
+		int				m_HeightSlot = -1;
+		bool			m_ParallelBranches = false;
 		ErrorList		m_Errors;
 		ErrorList		m_Warnings;
+		ErrorList		m_Notes;
 
 		// statistics
 		using call_count_map = std::map < std::string, size_t > ;
@@ -235,9 +377,11 @@ namespace image_processing
 		// Parser state
 		int m_CurLine = 0;
 		const char* m_LastNewLine = nullptr;
+		int m_RepeatHead = -1;	///< first statement of the repeat block being parsed
 		std::string m_SourcePath;
 
 		friend context;
+		friend native_program;
 	};
 
 	
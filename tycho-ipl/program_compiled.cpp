@@ -0,0 +1,600 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "program.h"
+#include "function.h"
+#include "result_cache.h"
+#include "utils.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	namespace
+	{
+		const uint32_t Magic = 0x58465954;	// 'TYFX'
+		const uint32_t Version = 3;
+
+		/// Compiled programs already loaded or written by this process, keyed
+		/// by the hash of their source and the library
+		std::mutex Mutex;
+		std::map<uint64_t, std::vector<char>> Compiled;
+
+		//----------------------------------------------------------------------------
+
+		/// Hash of the function table and format a compiled program was built
+		/// against. Statements store their arguments in parameter order with 
+		/// defaults bound, so a library with different functions or parameters
+		/// can't load programs compiled by another.
+		uint64_t get_compiled_hash()
+		{
+			return result_cache::combine(program::get_library_hash(), Version);
+		}
+
+		//----------------------------------------------------------------------------
+
+		class writer
+		{
+		public:
+			explicit writer(std::vector<char>& data) :
+				m_Data(data)
+			{}
+
+			void write(const void* src, size_t len)
+			{
+				const char* bytes = static_cast<const char*>(src);
+				m_Data.insert(m_Data.end(), bytes, bytes + len);
+			}
+
+			template<typename T> void write(T val) { write(&val, sizeof(val)); }
+
+			void write_string(const std::string& str)
+			{
+				write(static_cast<uint32_t>(str.size()));
+				write(str.data(), str.size());
+			}
+
+			void write_value(const value& val)
+			{
+				write(static_cast<int32_t>(val.get_type()));
+				switch (val.get_type())
+				{
+				case ObjectType::Integer: write(static_cast<int32_t>(val.get_integer())); break;
+				case ObjectType::Float: write(val.get_float()); break;
+				case ObjectType::Boolean: write(static_cast<uint8_t>(val.get_boolean())); break;
+				case ObjectType::Name: write_string(val.get_name()); break;
+				case ObjectType::String: write_string(val.get_string()); break;
+				default: break;	// images are bound when the program is run
+				}
+			}
+
+		private:
+			std::vector<char>& m_Data;
+		};
+
+		//----------------------------------------------------------------------------
+
+		class reader
+		{
+		public:
+			reader(const char* data, size_t len) :
+				m_Cur(data),
+				m_End(data + len)
+			{}
+
+			bool ok() const { return m_Ok; }
+
+			void read(void* dst, size_t len)
+			{
+				if (!m_Ok || static_cast<size_t>(m_End - m_Cur) < len)
+				{
+					m_Ok = false;
+					memset(dst, 0, len);
+					return;
+				}
+				memcpy(dst, m_Cur, len);
+				m_Cur += len;
+			}
+
+			template<typename T> T read() { T val; read(&val, sizeof(val)); return val; }
+
+			/// Read an element count, each element is at least min_size bytes
+			size_t read_count(size_t min_size = 1)
+			{
+				const uint32_t n = read<uint32_t>();
+				if (static_cast<size_t>(m_End - m_Cur) / min_size < n)
+					m_Ok = false;
+				return m_Ok ? n : 0;
+			}
+
+			std::string read_string()
+			{
+				const size_t n = read_count();
+				std::string str(m_Cur, m_Cur + n);
+				m_Cur += n;
+				return str;
+			}
+
+			value read_value()
+			{
+				switch (static_cast<ObjectType>(read<int32_t>()))
+				{
+				case ObjectType::Integer: return value::make_integer(read<int32_t>());
+				case ObjectType::Float: return value::make_float(read<float>());
+				case ObjectType::Boolean: return value::make_boolean(read<uint8_t>() != 0);
+				case ObjectType::Name: return read_name(false);
+				case ObjectType::String: return read_name(true);
+				case ObjectType::Image: return value::make_image(nullptr);
+				case ObjectType::Invalid: return value();
+				default:
+					m_Ok = false;
+					return value();
+				}
+			}
+
+		private:
+			value read_name(bool is_string)
+			{
+				const std::string str = read_string();
+				return is_string ? value::make_string(str) : value::make_name(str);
+			}
+
+		private:
+			const char* m_Cur;
+			const char* m_End;
+			bool		m_Ok = true;
+		};
+
+		//----------------------------------------------------------------------------
+
+		bool read_file(const std::string& path, std::vector<char>& data)
+		{
+			FILE* file = fopen(path.c_str(), "rb");
+			if (!file)
+				return false;
+
+			fseek(file, 0L, SEEK_END);
+			const long len = ftell(file);
+			fseek(file, 0L, SEEK_SET);
+			data.resize(len > 0 ? len : 0);
+			const bool ok = len > 0 && fread(&data[0], len, 1, file) == 1;
+			fclose(file);
+			return ok;
+		}
+
+		//----------------------------------------------------------------------------
+
+		void write_file(const std::string& path, const std::vector<char>& data)
+		{
+			// written to a temporary and renamed so a concurrent reader never 
+			// sees a partial file, failures just mean it's compiled next time.
+			// Each write has its own temporary so processes compiling the same
+			// script at once don't interleave their writes.
+			const std::string tmp = utils::get_unique_temp_path(path);
+			FILE* file = fopen(tmp.c_str(), "wb");
+			if (!file)
+				return;
+
+			const bool ok = fwrite(data.data(), data.size(), 1, file) == 1;
+			fclose(file);
+			if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+				remove(tmp.c_str());
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	program::program()
+	{
+	}
+
+	//----------------------------------------------------------------------------
+
+	uint64_t program::get_library_hash()
+	{
+		static const uint64_t library_hash = []
+		{
+			uint64_t hash = result_cache::hash(nullptr, 0);
+			auto add_string = [&hash](const std::string& str)
+			{
+				hash = result_cache::hash(str.data(), str.size(), hash);
+			};
+			auto add_params = [&](const param_list& params)
+			{
+				hash = result_cache::combine(hash, params.size());
+				for (auto& param : params)
+				{
+					add_string(param.Name);
+					hash = result_cache::combine(hash, static_cast<uint64_t>(param.Type));
+					hash = result_cache::combine(hash, param.HasDefault() ? result_cache::hash(param.DefaultVal) : 0);
+				}
+			};
+
+			functions::factory factory;
+			factory.enumerate([&](const function* func)
+			{
+				add_string(func->get_name());
+				hash = result_cache::combine(hash, func->has_side_effects() ? 1 : 0);
+				add_params(func->get_inputs());
+				add_params(func->get_outputs());
+			});
+			return hash;
+		}();
+		return library_hash;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program::save_compiled(std::vector<char>& data, uint64_t source_hash) const
+	{
+		writer out(data);
+		out.write(Magic);
+		out.write(Version);
+		out.write(get_compiled_hash());
+		out.write(source_hash);
+
+		for (auto* list : { &m_Constants, &m_Inputs, &m_Outputs, &m_Temporaries })
+		{
+			out.write(static_cast<uint32_t>(list->size()));
+			for (auto& decl : *list)
+			{
+				out.write(static_cast<int32_t>(decl.Type));
+				out.write(static_cast<int32_t>(decl.Modifier));
+				out.write_string(decl.Name);
+				out.write_value(decl.Value);
+				out.write(static_cast<int32_t>(decl.RefCount));
+				out.write(static_cast<int32_t>(decl.DeclLine));
+				out.write(static_cast<int32_t>(decl.Slot));
+			}
+		}
+
+		out.write(static_cast<uint32_t>(m_Statements.size()));
+		for (auto& stmt : m_Statements)
+		{
+			out.write_string(stmt.Name);
+			out.write_string(stmt.Func->get_name());
+			out.write(static_cast<int32_t>(stmt.Line));
+
+			out.write(static_cast<uint32_t>(stmt.Inputs.size()));
+			for (auto& op : stmt.Inputs)
+			{
+				out.write(static_cast<int32_t>(op.Slot));
+				out.write_value(op.Constant);
+				out.write(static_cast<uint8_t>(op.LastUse));
+			}
+
+			out.write(static_cast<uint32_t>(stmt.Outputs.size()));
+			for (int slot : stmt.Outputs)
+				out.write(static_cast<int32_t>(slot));
+
+			out.write(static_cast<uint8_t>(stmt.ReuseSource));
+			out.write(static_cast<uint32_t>(stmt.Dependents.size()));
+			for (int d : stmt.Dependents)
+				out.write(static_cast<int32_t>(d));
+			out.write(static_cast<int32_t>(stmt.NumDependencies));
+			out.write(static_cast<int32_t>(stmt.FusedStatements));
+			out.write(static_cast<int32_t>(stmt.FusedHead));
+			out.write(static_cast<int32_t>(stmt.LutChannels));
+			out.write(static_cast<uint32_t>(stmt.Lut.size()));
+			out.write(stmt.Lut.data(), stmt.Lut.size());
+			out.write(static_cast<int32_t>(stmt.StripStatements));
+			out.write(static_cast<int32_t>(stmt.StripHead));
+			out.write(static_cast<int32_t>(stmt.RepeatHead));
+			out.write(static_cast<int32_t>(stmt.RepeatStatements));
+			out.write(static_cast<int32_t>(stmt.RepeatCount.Slot));
+			out.write_value(stmt.RepeatCount.Constant);
+		}
+
+		out.write(static_cast<uint8_t>(m_ParallelBranches));
+
+		uint32_t num_called = 0;
+		for (auto& c : m_CallCounts)
+			num_called += c.second > 0 ? 1 : 0;
+		out.write(num_called);
+		for (auto& c : m_CallCounts)
+		{
+			if (c.second == 0)
+				continue;
+			out.write_string(c.first);
+			out.write(static_cast<uint32_t>(c.second));
+		}
+
+		for (auto* list : { &m_Warnings, &m_Notes })
+		{
+			out.write(static_cast<uint32_t>(list->size()));
+			for (auto& e : *list)
+			{
+				out.write_string(e.Message);
+				out.write(static_cast<int32_t>(e.Line));
+				out.write(static_cast<int32_t>(e.Column));
+			}
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::unique_ptr<program> program::create_from_compiled(const char* data, size_t len, const char* source_path, uint64_t source_hash)
+	{
+		reader in(data, len);
+		if (in.read<uint32_t>() != Magic || in.read<uint32_t>() != Version ||
+			in.read<uint64_t>() != get_compiled_hash())
+		{
+			return nullptr;
+		}
+
+		const uint64_t hash = in.read<uint64_t>();
+		if (source_hash != 0 && hash != source_hash)
+			return nullptr;
+
+		std::unique_ptr<program> p(new program());
+		p->m_SourcePath = source_path;
+
+		for (auto* list : { &p->m_Constants, &p->m_Inputs, &p->m_Outputs, &p->m_Temporaries })
+		{
+			const size_t n = in.read_count();
+			for (size_t i = 0; i < n && in.ok(); ++i)
+			{
+				declaration decl;
+				decl.Type = static_cast<ObjectType>(in.read<int32_t>());
+				decl.Modifier = static_cast<declaration::TypeModifier>(in.read<int32_t>());
+				decl.Name = in.read_string();
+				decl.Value = in.read_value();
+				decl.RefCount = in.read<int32_t>();
+				decl.DeclLine = in.read<int32_t>();
+				decl.Slot = in.read<int32_t>();
+				p->add_declaration(*list, decl);
+			}
+		}
+
+		if (!in.ok())
+			return nullptr;
+
+		// rebuild the register file in slot order
+		p->m_Slots.assign(p->m_Symbols.size(), nullptr);
+		for (auto* list : { &p->m_Constants, &p->m_Inputs, &p->m_Outputs, &p->m_Temporaries })
+		{
+			for (auto& decl : *list)
+			{
+				if (decl.Slot < 0 || decl.Slot >= static_cast<int>(p->m_Slots.size()) || p->m_Slots[decl.Slot])
+					return nullptr;
+				p->m_Slots[decl.Slot] = &decl;
+			}
+		}
+
+		const int num_slots = static_cast<int>(p->m_Slots.size());
+		auto valid_slot = [num_slots](int slot, bool optional) { return (optional && slot < 0) || (slot >= 0 && slot < num_slots); };
+
+		const size_t num_statements = in.read_count();
+		p->m_Statements.resize(num_statements);
+		for (size_t s = 0; s < num_statements && in.ok(); ++s)
+		{
+			statement& stmt = p->m_Statements[s];
+			stmt.Type = StatementList::FunctionCall;
+			stmt.Name = in.read_string();
+
+			// functions are resolved by name, a change to their parameters 
+			// means the program has to be compiled again
+			stmt.Func = p->m_FunctionFactory.create(in.read_string());
+			stmt.Line = in.read<int32_t>();
+			if (!stmt.Func)
+				return nullptr;
+
+			stmt.Inputs.resize(in.read_count());
+			for (auto& op : stmt.Inputs)
+			{
+				op.Slot = in.read<int32_t>();
+				op.Constant = in.read_value();
+				op.LastUse = in.read<uint8_t>() != 0;
+				if (!valid_slot(op.Slot, true))
+					return nullptr;
+			}
+
+			stmt.Outputs.resize(in.read_count(sizeof(int32_t)));
+			for (int& slot : stmt.Outputs)
+			{
+				slot = in.read<int32_t>();
+				if (!valid_slot(slot, true))
+					return nullptr;
+			}
+
+			if (stmt.Inputs.size() != stmt.Func->get_inputs().size() ||
+				stmt.Outputs.size() != stmt.Func->get_outputs().size())
+			{
+				return nullptr;
+			}
+
+			stmt.ReuseSource = in.read<uint8_t>() != 0;
+			stmt.Dependents.resize(in.read_count(sizeof(int32_t)));
+			for (int& d : stmt.Dependents)
+			{
+				d = in.read<int32_t>();
+				if (d <= static_cast<int>(s) || d >= static_cast<int>(num_statements))
+					return nullptr;
+			}
+			stmt.NumDependencies = in.read<int32_t>();
+			stmt.FusedStatements = in.read<int32_t>();
+			stmt.FusedHead = in.read<int32_t>();
+			stmt.LutChannels = in.read<int32_t>();
+			stmt.Lut.resize(in.read_count());
+			in.read(stmt.Lut.data(), stmt.Lut.size());
+			stmt.StripStatements = in.read<int32_t>();
+			stmt.StripHead = in.read<int32_t>();
+			stmt.RepeatHead = in.read<int32_t>();
+			stmt.RepeatStatements = in.read<int32_t>();
+			stmt.RepeatCount.Slot = in.read<int32_t>();
+			stmt.RepeatCount.Constant = in.read_value();
+
+			// heads are earlier statements, or -1 for none
+			auto valid_head = [s](int head) { return head >= -1 && head <= static_cast<int>(s); };
+			if (stmt.NumDependencies < 0 || stmt.NumDependencies > static_cast<int>(s) ||
+				stmt.FusedStatements < 0 || s + stmt.FusedStatements >= num_statements || !valid_head(stmt.FusedHead) ||
+				stmt.StripStatements < 0 || s + stmt.StripStatements >= num_statements || !valid_head(stmt.StripHead) ||
+				!valid_head(stmt.RepeatHead) || !valid_slot(stmt.RepeatCount.Slot, true) ||
+				stmt.RepeatStatements < 0 || s + stmt.RepeatStatements >= num_statements ||
+				(!stmt.Lut.empty() && stmt.Lut.size() != 256))
+			{
+				return nullptr;
+			}
+		}
+
+		// the scheduler waits for NumDependencies statements to finish, a 
+		// count that doesn't match the dependents lists never completes
+		{
+			std::vector<int> num_dependencies(num_statements, 0);
+			for (auto& stmt : p->m_Statements)
+			{
+				for (int d : stmt.Dependents)
+					++num_dependencies[d];
+			}
+			for (size_t s = 0; s < num_statements && in.ok(); ++s)
+			{
+				if (p->m_Statements[s].NumDependencies != num_dependencies[s])
+					return nullptr;
+			}
+		}
+
+		p->m_ParallelBranches = in.read<uint8_t>() != 0;
+
+		const size_t num_called = in.read_count();
+		for (size_t i = 0; i < num_called && in.ok(); ++i)
+		{
+			std::string name = in.read_string();
+			p->m_CallCounts[name] = in.read<uint32_t>();
+		}
+
+		for (auto* list : { &p->m_Warnings, &p->m_Notes })
+		{
+			const size_t n = in.read_count();
+			for (size_t i = 0; i < n && in.ok(); ++i)
+			{
+				program_error e;
+				e.Message = in.read_string();
+				e.Line = in.read<int32_t>();
+				e.Column = in.read<int32_t>();
+				list->push_back(e);
+			}
+		}
+
+		if (!in.ok())
+			return nullptr;
+
+		p->m_SrcSlot = p->get_slot("__src__");
+		p->m_DstSlot = p->get_slot("__dst__");
+		p->m_WidthSlot = p->get_slot("__width__");
+		p->m_HeightSlot = p->get_slot("__height__");
+		if (p->m_SrcSlot < 0 || p->m_DstSlot < 0 || p->m_WidthSlot < 0 || p->m_HeightSlot < 0)
+			return nullptr;
+
+		return p;
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::unique_ptr<program> program::create_from_file_cached(const char* path, const char* compiled_dir)
+	{
+		std::vector<char> source;
+		if (!read_file(path, source))
+			return nullptr;
+
+		// a compiled file is loaded as is
+		const size_t path_len = strlen(path);
+		if (path_len > 4 && strcmp(path + path_len - 4, ".fxc") == 0)
+			return create_from_compiled(source.data(), source.size(), path);
+
+		// the same source compiled against another library gets its own file
+		const uint64_t hash = result_cache::combine(result_cache::hash(source.data(), source.size()), get_compiled_hash());
+
+		std::string compiled_path;
+		if (compiled_dir && *compiled_dir)
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.fxc", static_cast<unsigned long long>(hash));
+			compiled_path = compiled_dir;
+			if (compiled_path.back() != '/' && compiled_path.back() != '\\')
+				compiled_path += '/';
+			compiled_path += name;
+		}
+		else
+		{
+			compiled_path = std::string(path) + "c";
+		}
+
+		// loaded or written earlier in this process
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			auto it = Compiled.find(hash);
+			if (it != Compiled.end())
+			{
+				auto p = create_from_compiled(it->second.data(), it->second.size(), path, hash);
+				if (p)
+					return p;
+			}
+		}
+
+		std::vector<char> compiled;
+		if (read_file(compiled_path, compiled))
+		{
+			auto p = create_from_compiled(compiled.data(), compiled.size(), path, hash);
+			if (p)
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				Compiled[hash] = std::move(compiled);
+				return p;
+			}
+		}
+
+		// compile from source, programs with errors are never stored so they
+		// are reported every time
+		auto p = std::make_unique<program>(source.data(), source.size(), path);
+		if (!p->has_errors())
+		{
+			compiled.clear();
+			p->save_compiled(compiled, hash);
+			write_file(compiled_path, compiled);
+
+			std::lock_guard<std::mutex> lock(Mutex);
+			Compiled[hash] = std::move(compiled);
+		}
+		return p;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
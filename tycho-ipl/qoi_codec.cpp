@@ -0,0 +1,364 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "qoi_codec.h"
+#include "opencv2/core/core.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+//----------------------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+namespace qoi
+{
+
+	namespace detail
+	{
+		const uint8_t OpIndex = 0x00;
+		const uint8_t OpDiff = 0x40;
+		const uint8_t OpLuma = 0x80;
+		const uint8_t OpRun = 0xc0;
+		const uint8_t OpRGB = 0xfe;
+		const uint8_t OpRGBA = 0xff;
+		const uint8_t OpMask = 0xc0;
+
+		const size_t HeaderSize = 14;
+		const uint8_t Padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		const int MaxRun = 62;
+
+		/// Images larger than this are rejected when decoding
+		const uint32_t MaxPixels = 400000000;
+
+		struct pixel
+		{
+			uint8_t r, g, b, a;
+
+			bool operator==(const pixel& rhs) const
+			{
+				return r == rhs.r && g == rhs.g && b == rhs.b && a == rhs.a;
+			}
+
+			bool operator!=(const pixel& rhs) const
+			{
+				return !(*this == rhs);
+			}
+
+			int hash() const
+			{
+				return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+			}
+		};
+
+		static void write_u32(uint8_t* dst, uint32_t v)
+		{
+			dst[0] = static_cast<uint8_t>(v >> 24);
+			dst[1] = static_cast<uint8_t>(v >> 16);
+			dst[2] = static_cast<uint8_t>(v >> 8);
+			dst[3] = static_cast<uint8_t>(v);
+		}
+
+		static uint32_t read_u32(const uint8_t* src)
+		{
+			return (uint32_t(src[0]) << 24) | (uint32_t(src[1]) << 16) | (uint32_t(src[2]) << 8) | src[3];
+		}
+
+	} // end namespace
+
+	//----------------------------------------------------------------------------
+
+	bool has_extension(const std::string& path)
+	{
+		const size_t len = strlen(Extension);
+		if (path.size() < len)
+			return false;
+
+		return std::equal(path.end() - len, path.end(), Extension, [](char a, char b)
+		{
+			return ::tolower(static_cast<unsigned char>(a)) == b;
+		});
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool encode(const cv::Mat& mat, std::vector<uint8_t>& out)
+	{
+		using namespace detail;
+
+		const int channels = mat.channels();
+		if (mat.depth() != CV_8U || (channels != 1 && channels != 3 && channels != 4) || mat.empty())
+			return false;
+
+		// worst case every pixel is a full rgba op
+		const size_t num_pixels = size_t(mat.cols) * mat.rows;
+		out.resize(HeaderSize + num_pixels * 5 + sizeof(Padding));
+		uint8_t* dst = out.data();
+
+		memcpy(dst, "qoif", 4);
+		write_u32(dst + 4, static_cast<uint32_t>(mat.cols));
+		write_u32(dst + 8, static_cast<uint32_t>(mat.rows));
+		dst[12] = channels == 4 ? 4 : 3;	// channels, grey is written as rgb
+		dst[13] = 0;	// sRGB with linear alpha
+		dst += HeaderSize;
+
+		pixel index[64] = {};
+		pixel prev = { 0, 0, 0, 255 };
+		int run = 0;
+		for (int y = 0; y < mat.rows; ++y)
+		{
+			const uint8_t* src = mat.ptr<uint8_t>(y);
+			for (int x = 0; x < mat.cols; ++x, src += channels)
+			{
+				// opencv stores channels as bgr(a)
+				pixel px;
+				if (channels == 4)
+					px = { src[2], src[1], src[0], src[3] };
+				else if (channels == 3)
+					px = { src[2], src[1], src[0], 255 };
+				else
+					px = { src[0], src[0], src[0], 255 };
+
+				if (px == prev)
+				{
+					if (++run == MaxRun)
+					{
+						*dst++ = static_cast<uint8_t>(OpRun | (run - 1));
+						run = 0;
+					}
+					continue;
+				}
+
+				if (run > 0)
+				{
+					*dst++ = static_cast<uint8_t>(OpRun | (run - 1));
+					run = 0;
+				}
+
+				const int hash = px.hash();
+				if (index[hash] == px)
+				{
+					*dst++ = static_cast<uint8_t>(OpIndex | hash);
+				}
+				else
+				{
+					index[hash] = px;
+
+					// the difference ops can only be used if the alpha is unchanged
+					if (px.a != prev.a)
+					{
+						*dst++ = OpRGBA;
+						*dst++ = px.r;
+						*dst++ = px.g;
+						*dst++ = px.b;
+						*dst++ = px.a;
+						prev = px;
+						continue;
+					}
+
+					const int8_t dr = static_cast<int8_t>(px.r - prev.r);
+					const int8_t dg = static_cast<int8_t>(px.g - prev.g);
+					const int8_t db = static_cast<int8_t>(px.b - prev.b);
+					const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+					const int8_t db_dg = static_cast<int8_t>(db - dg);
+
+					if (dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+					{
+						*dst++ = static_cast<uint8_t>(OpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+					}
+					else if (dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 && db_dg > -9 && db_dg < 8)
+					{
+						*dst++ = static_cast<uint8_t>(OpLuma | (dg + 32));
+						*dst++ = static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+					}
+					else
+					{
+						*dst++ = OpRGB;
+						*dst++ = px.r;
+						*dst++ = px.g;
+						*dst++ = px.b;
+					}
+				}
+				prev = px;
+			}
+		}
+
+		if (run > 0)
+			*dst++ = static_cast<uint8_t>(OpRun | (run - 1));
+
+		memcpy(dst, Padding, sizeof(Padding));
+		dst += sizeof(Padding);
+		out.resize(dst - out.data());
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool decode(const uint8_t* data, size_t size, cv::Mat& mat)
+	{
+		using namespace detail;
+
+		if (size < HeaderSize + sizeof(Padding) || memcmp(data, "qoif", 4) != 0)
+			return false;
+
+		const uint32_t width = read_u32(data + 4);
+		const uint32_t height = read_u32(data + 8);
+		const uint8_t channels = data[12];
+		if (width == 0 || height == 0 || height >= MaxPixels / width || (channels != 3 && channels != 4))
+			return false;
+
+		mat.create(static_cast<int>(height), static_cast<int>(width), CV_8UC(channels));
+
+		const uint8_t* src = data + HeaderSize;
+		const uint8_t* end = data + size - sizeof(Padding);
+		pixel index[64] = {};
+		pixel px = { 0, 0, 0, 255 };
+		int run = 0;
+		for (int y = 0; y < mat.rows; ++y)
+		{
+			uint8_t* dst = mat.ptr<uint8_t>(y);
+			for (int x = 0; x < mat.cols; ++x, dst += channels)
+			{
+				if (run > 0)
+				{
+					--run;
+				}
+				else if (src < end)
+				{
+					const uint8_t b1 = *src++;
+					if (b1 == OpRGB)
+					{
+						if (end - src < 3)
+							return false;
+						px.r = src[0];
+						px.g = src[1];
+						px.b = src[2];
+						src += 3;
+					}
+					else if (b1 == OpRGBA)
+					{
+						if (end - src < 4)
+							return false;
+						px = { src[0], src[1], src[2], src[3] };
+						src += 4;
+					}
+					else if ((b1 & OpMask) == OpIndex)
+					{
+						px = index[b1];
+					}
+					else if ((b1 & OpMask) == OpDiff)
+					{
+						px.r += ((b1 >> 4) & 0x03) - 2;
+						px.g += ((b1 >> 2) & 0x03) - 2;
+						px.b += (b1 & 0x03) - 2;
+					}
+					else if ((b1 & OpMask) == OpLuma)
+					{
+						if (src == end)
+							return false;
+						const uint8_t b2 = *src++;
+						const int dg = (b1 & 0x3f) - 32;
+						px.r += dg - 8 + ((b2 >> 4) & 0x0f);
+						px.g += dg;
+						px.b += dg - 8 + (b2 & 0x0f);
+					}
+					else
+					{
+						run = b1 & 0x3f;
+					}
+					index[px.hash()] = px;
+				}
+				else
+				{
+					return false;
+				}
+
+				dst[0] = px.b;
+				dst[1] = px.g;
+				dst[2] = px.r;
+				if (channels == 4)
+					dst[3] = px.a;
+			}
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool write_file(const std::string& path, const cv::Mat& mat)
+	{
+		std::vector<uint8_t> data;
+		if (!encode(mat, data))
+			return false;
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		const bool written = fwrite(data.data(), data.size(), 1, file) == 1;
+		fclose(file);
+		return written;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool read_file(const std::string& path, cv::Mat& mat)
+	{
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+
+		std::vector<uint8_t> data;
+		bool read = fseek(file, 0, SEEK_END) == 0;
+		const long size = read ? ftell(file) : -1;
+		if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			data.resize(static_cast<size_t>(size));
+			read = fread(data.data(), data.size(), 1, file) == 1;
+		}
+		else
+		{
+			read = false;
+		}
+		fclose(file);
+
+		return read && decode(data.data(), data.size(), mat);
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
+} // end namespace
@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef QOI_CODEC_H_2C85AA6D_DAB3_44E3_9F30_9895D5551066
+#define QOI_CODEC_H_2C85AA6D_DAB3_44E3_9F30_9895D5551066
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cv
+{
+	class Mat;
+}
+
+//----------------------------------------------------------------------------
+// Functions
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+namespace qoi
+{
+	//----------------------------------------------------------------------------
+	// Lossless codec for intermediate results that encodes and decodes in a 
+	// single pass over the pixels, several times quicker than png at a little
+	// worse compression. Files use the "Quite OK Image" format (.qoi) so other
+	// tools can open them.
+	//----------------------------------------------------------------------------
+
+	/// Extension, including the dot, of qoi files
+	static const char* const Extension = ".qoi";
+
+	/// Returns true if the path has the qoi extension
+	TYCHO_IMAGEPROCESSING_ABI bool has_extension(const std::string& path);
+
+	/// Encode an 8 bit grey, BGR or BGRA image, returns false for other pixel 
+	/// types
+	TYCHO_IMAGEPROCESSING_ABI bool encode(const cv::Mat& mat, std::vector<uint8_t>& out);
+
+	/// Decode an image to 8 bit BGR, or BGRA if it was written with alpha. 
+	/// Returns false if the data isn't valid
+	TYCHO_IMAGEPROCESSING_ABI bool decode(const uint8_t* data, size_t size, cv::Mat& mat);
+
+	/// Encode an image and write it to a file
+	TYCHO_IMAGEPROCESSING_ABI bool write_file(const std::string& path, const cv::Mat& mat);
+
+	/// Read a file and decode it
+	TYCHO_IMAGEPROCESSING_ABI bool read_file(const std::string& path, cv::Mat& mat);
+
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif // QOI_CODEC_H_2C85AA6D_DAB3_44E3_9F30_9895D5551066
@@ -0,0 +1,398 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "result_cache.h"
+#include "image.h"
+#include "image_pool.h"
+#include "key_value.h"
+#include "utils.h"
+#include "functions/common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <filesystem>
+#else
+#include <experimental/filesystem>
+#endif 
+
+namespace std_filesystem = std::experimental::filesystem;
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	namespace
+	{
+		const char Extension[] = ".tyc";
+		const uint32_t Magic = 0x43525954;	// 'TYRC'
+		const uint32_t Version = 1;
+
+		struct file_header
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			int32_t  Width;
+			int32_t  Height;
+			int32_t  Type;
+			int32_t  Format;
+		};
+
+		/// Results are 8 bit images of 1 to 4 channels
+		bool is_valid_type(int32_t type)
+		{
+			return CV_MAT_DEPTH(type) == CV_8U && CV_MAT_CN(type) >= 1 && CV_MAT_CN(type) <= 4;
+		}
+
+		/// Returns true if bytes is exactly the pixel data the header describes
+		bool is_pixel_size(uintmax_t bytes, const file_header& header)
+		{
+			const uintmax_t row_bytes = static_cast<uintmax_t>(header.Width) * CV_ELEM_SIZE(header.Type);
+			return bytes % row_bytes == 0 && bytes / row_bytes == static_cast<uintmax_t>(header.Height);
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	result_cache::result_cache(const std::string& dir, size_t max_bytes) :
+		m_Dir(dir),
+		m_MaxBytes(max_bytes)
+	{
+		if (!m_Dir.empty() && m_Dir.back() != '/' && m_Dir.back() != '\\')
+			m_Dir += '/';
+
+		std::error_code ec;
+		std_filesystem::create_directories(m_Dir, ec);
+
+		// pick up results from earlier runs, the modification time is updated
+		// whenever a result is used so it gives the least recently used order
+		struct found
+		{
+			uint64_t Key;
+			size_t	 Bytes;
+			std_filesystem::file_time_type Time;
+		};
+		std::vector<found> files;
+		for (auto& p : std_filesystem::directory_iterator(m_Dir, ec))
+		{
+			const std_filesystem::path& path = p;
+			if (!std_filesystem::is_regular_file(p) || path.extension() != Extension)
+				continue;
+
+			char* end = nullptr;
+			const std::string stem = path.stem().string();
+			const uint64_t key = strtoull(stem.c_str(), &end, 16);
+			if (*end != 0)
+				continue;
+
+			files.push_back({ key, static_cast<size_t>(std_filesystem::file_size(path)), std_filesystem::last_write_time(path) });
+		}
+
+		std::sort(files.begin(), files.end(), [](const found& a, const found& b) { return a.Time < b.Time; });
+		for (auto& f : files)
+		{
+			m_Index[f.Key] = m_Entries.insert(m_Entries.end(), entry{ f.Key, f.Bytes });
+			m_Bytes += f.Bytes;
+		}
+		trim();
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::string result_cache::get_path(uint64_t key) const
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+		return m_Dir + name + Extension;
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool result_cache::contains(uint64_t key) const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Index.count(key) != 0;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image* result_cache::load(uint64_t key, image_pool* pool)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto it = m_Index.find(key);
+			if (it == m_Index.end())
+				return nullptr;
+			touch(it->second);
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const std::string path = get_path(key);
+		FILE* file = fopen(path.c_str(), "rb");
+		if (!file)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			remove(key);
+			return nullptr;
+		}
+
+		// the header is checked against the file's length before anything is
+		// allocated so a corrupt file can't ask for an arbitrary image
+		std::error_code ec;
+		const uintmax_t file_bytes = std_filesystem::file_size(path, ec);
+		file_header header;
+		image* img = nullptr;
+		if (!ec && fread(&header, sizeof(header), 1, file) == 1 &&
+			header.Magic == Magic && header.Version == Version &&
+			header.Width > 0 && header.Height > 0 && is_valid_type(header.Type) &&
+			header.Format >= 0 && header.Format < static_cast<int32_t>(image::Format::Count) &&
+			file_bytes > sizeof(header) && is_pixel_size(file_bytes - sizeof(header), header))
+		{
+			const auto format = static_cast<image::Format>(header.Format);
+			if (pool)
+			{
+				img = pool->acquire(header.Width, header.Height, header.Type, format);
+			}
+			else
+			{
+				img = new image();
+				img->set_mat(cv::Mat(header.Height, header.Width, header.Type), format);
+			}
+
+			cv::Mat& mat = *img->get_opencv();
+			const size_t row_bytes = mat.cols * mat.elemSize();
+			for (int y = 0; y < mat.rows && img; ++y)
+			{
+				if (fread(mat.ptr<uint8_t>(y), 1, row_bytes, file) != row_bytes)
+				{
+					if (pool)
+						pool->release(img);
+					else
+						delete img;
+					img = nullptr;
+				}
+			}
+		}
+		fclose(file);
+
+		// unreadable results are dropped so they're recomputed next time
+		if (!img)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			remove(key);
+			return nullptr;
+		}
+
+		const cv::Mat& mat = *img->get_opencv();
+		add_transfer(mat.total() * mat.elemSize(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+		std_filesystem::last_write_time(path, std_filesystem::file_time_type::clock::now(), ec);
+		return img;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void result_cache::store(uint64_t key, const image* img)
+	{
+		const cv::Mat& mat = *img->get_opencv();
+		const size_t row_bytes = mat.cols * mat.elemSize();
+		const size_t bytes = sizeof(file_header) + row_bytes * mat.rows;
+		if (bytes > m_MaxBytes || contains(key))
+			return;
+
+		// write to a temporary and rename it into place so other processes 
+		// sharing the directory never see a partial file. Each write has its
+		// own temporary so writers of the same key can't truncate each other.
+		const auto start = std::chrono::steady_clock::now();
+		const std::string path = get_path(key);
+		const std::string temp_path = utils::get_unique_temp_path(path);
+		FILE* file = fopen(temp_path.c_str(), "wb");
+		if (!file)
+			return;
+
+		file_header header = { 
+			Magic, Version, mat.cols, mat.rows, mat.type(), static_cast<int32_t>(img->get_format()) 
+		};
+
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		for (int y = 0; y < mat.rows && ok; ++y)
+			ok = fwrite(mat.ptr<uint8_t>(y), 1, row_bytes, file) == row_bytes;
+		ok = (fclose(file) == 0) && ok;
+
+		std::error_code ec;
+		if (ok)
+			std_filesystem::rename(temp_path, path, ec);
+		if (!ok || ec)
+		{
+			std_filesystem::remove(temp_path, ec);
+			return;
+		}
+
+		add_transfer(bytes, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Index.count(key))
+			return;
+
+		m_Index[key] = m_Entries.insert(m_Entries.end(), entry{ key, bytes });
+		m_Bytes += bytes;
+		trim();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool result_cache::is_worth_storing(size_t bytes, double seconds) const
+	{
+		if (seconds < m_MinCost)
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_BytesPerSecond <= 0.0 || seconds > bytes / m_BytesPerSecond;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void result_cache::add_transfer(size_t bytes, double seconds)
+	{
+		if (seconds <= 0.0)
+			return;
+
+		// a moving average so the estimate follows the current disk and load
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		const double rate = bytes / seconds;
+		m_BytesPerSecond = m_BytesPerSecond > 0.0 ? 0.75 * m_BytesPerSecond + 0.25 * rate : rate;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void result_cache::touch(entry_list::iterator it)
+	{
+		m_Entries.splice(m_Entries.end(), m_Entries, it);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void result_cache::remove(uint64_t key)
+	{
+		auto it = m_Index.find(key);
+		if (it == m_Index.end())
+			return;
+
+		m_Bytes -= it->second->Bytes;
+		m_Entries.erase(it->second);
+		m_Index.erase(it);
+
+		std::error_code ec;
+		std_filesystem::remove(get_path(key), ec);
+	}
+
+	//----------------------------------------------------------------------------
+
+	void result_cache::trim()
+	{
+		while (m_Bytes > m_MaxBytes && !m_Entries.empty())
+			remove(m_Entries.front().Key);
+	}
+
+	//----------------------------------------------------------------------------
+
+	uint64_t result_cache::hash(const void* data, size_t len, uint64_t seed)
+	{
+		// FNV-1a
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t h = seed;
+		for (size_t i = 0; i < len; ++i)
+		{
+			h ^= bytes[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	//----------------------------------------------------------------------------
+
+	uint64_t result_cache::hash(const value& val)
+	{
+		const int type = static_cast<int>(val.get_type());
+		uint64_t h = hash(&type, sizeof(type));
+		switch (val.get_type())
+		{
+		case ObjectType::Integer: {
+			const int i = val.get_integer();
+			return hash(&i, sizeof(i), h);
+		}
+		case ObjectType::Float: {
+			const float f = val.get_float();
+			return hash(&f, sizeof(f), h);
+		}
+		case ObjectType::Boolean: {
+			const bool b = val.get_boolean();
+			return hash(&b, sizeof(b), h);
+		}
+		case ObjectType::String:
+			return hash(val.get_string(), strlen(val.get_string()), h);
+		case ObjectType::Name:
+			return hash(val.get_name(), strlen(val.get_name()), h);
+		case ObjectType::Image:
+			return combine(h, hash(val.get_image()));
+		default:
+			return h;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	uint64_t result_cache::hash(const image* img)
+	{
+		if (!img || !img->get_opencv())
+			return 0;
+
+		const cv::Mat& mat = *img->get_opencv();
+		const int32_t desc[] = { mat.cols, mat.rows, mat.type(), static_cast<int32_t>(img->get_format()) };
+		uint64_t h = hash(desc, sizeof(desc));
+
+		const size_t row_bytes = mat.cols * mat.elemSize();
+		for (int y = 0; y < mat.rows; ++y)
+			h = hash(mat.ptr<uint8_t>(y), row_bytes, h);
+		return h;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
@@ -0,0 +1,144 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef RESULT_CACHE_H_620A64B0_88B9_4698_9632_19625DABE5B7
+#define RESULT_CACHE_H_620A64B0_88B9_4698_9632_19625DABE5B7
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "forward_decls.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Directory of statement results that persists between runs. Results are
+	// identified by a key hashed from the source image content, the function 
+	// and its arguments, and the keys of the results it was computed from, so
+	// an unchanged prefix of an edited script finds its results from earlier
+	// runs. Images are stored uncompressed and the least recently used are 
+	// deleted to keep the directory under a maximum size. Safe to share 
+	// between threads.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI result_cache
+	{
+	public:
+		/// Default maximum size of the cache directory in bytes
+		static const size_t DefaultMaxBytes = 4096ull * 1024 * 1024;
+
+		/// Part of every result key, increase it when a function's output 
+		/// changes so results computed by earlier versions aren't used
+		static const uint32_t ResultVersion = 1;
+
+	public:
+		/// Constructor, creates the directory if it doesn't exist
+		result_cache(const std::string& dir, size_t max_bytes = DefaultMaxBytes);
+
+		/// Returns true if a result with the given key is stored
+		bool contains(uint64_t key) const;
+
+		/// Read the result with the given key, returns nullptr if it doesn't 
+		/// exist or can't be read. The image is allocated from pool if supplied.
+		image* load(uint64_t key, image_pool* pool);
+
+		/// Store an image under the given key
+		void store(uint64_t key, const image* img);
+
+		/// Returns true if a result of the given size that takes seconds to 
+		/// compute is worth storing. It must take at least the minimum cost 
+		/// and longer than reading it back at the speed results have been 
+		/// read and written at so far.
+		bool is_worth_storing(size_t bytes, double seconds) const;
+
+		/// Set the minimum time in seconds a result must take to compute before
+		/// it is stored
+		void set_min_cost(double seconds) { m_MinCost = seconds; }
+
+		/// Get the current size of the stored results in bytes
+		size_t get_size_bytes() const 
+		{ 
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_Bytes; 
+		}
+
+		/// Key helpers
+		static uint64_t hash(const void* data, size_t len, uint64_t seed = 14695981039346656037ull);
+		static uint64_t hash(const value& val);
+		static uint64_t hash(const image* img);
+		static uint64_t combine(uint64_t a, uint64_t b) { return hash(&b, sizeof(b), a); }
+
+	private:
+		struct entry
+		{
+			uint64_t Key;
+			size_t	 Bytes;
+		};
+		using entry_list = std::list < entry > ;
+
+		std::string get_path(uint64_t key) const;
+		void touch(entry_list::iterator it);
+		void trim();
+		void remove(uint64_t key);
+		void add_transfer(size_t bytes, double seconds);
+
+	private:
+		mutable std::mutex m_Mutex;
+		std::string		m_Dir;
+		size_t			m_MaxBytes;
+		size_t			m_Bytes = 0;
+		double			m_MinCost = 0.0;
+		double			m_BytesPerSecond = 0.0;	///< 0 until a result has been read or written
+		entry_list		m_Entries;	///< most recently used at the back
+		std::map<uint64_t, entry_list::iterator> m_Index;
+
+		// noncopyable
+		result_cache(const result_cache&) = delete;
+		result_cache& operator=(const result_cache&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // RESULT_CACHE_H_620A64B0_88B9_4698_9632_19625DABE5B7
@@ -115,8 +115,15 @@ namespace image_processing
 
 		const FileList& get_entries() const { return m_Paths; }
 
+		/// Copy of the first image scaled down to the size of a contact sheet 
+		/// cell, made while the image was still in memory
+		void set_thumbnail(std::shared_ptr<image> thumbnail) { m_Thumbnail = std::move(thumbnail); }
+
+		const std::shared_ptr<image>& get_thumbnail() const { return m_Thumbnail; }
+
 	private:
 		FileList m_Paths;
+		std::shared_ptr<image> m_Thumbnail;
 	};
 
 
@@ -0,0 +1,168 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "codec_benchmark.h"
+#include "../image.h"
+#include "../qoi_codec.h"
+#include "../utils.h"
+#include "../functions/common.h"
+
+#include <memory>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+namespace runtime
+{
+
+	namespace detail
+	{
+		struct codec_result
+		{
+			const char* Name;
+			image_write_options Options;
+			double EncodeSecs = 0;
+			double DecodeSecs = 0;
+			size_t RawBytes = 0;
+			size_t EncodedBytes = 0;
+			int Mismatches = 0;
+		};
+
+		static image_write_options make_options(image_write_options::FileFormat format, int png_level = -1)
+		{
+			image_write_options options;
+			options.Format = format;
+			options.PngLevel = png_level;
+			return options;
+		}
+
+	} // end namespace
+
+	//----------------------------------------------------------------------------
+
+	codec_benchmark::codec_benchmark(const session_options& options, output_interface* output) :
+		m_Options(options),
+		m_Output(output)
+	{
+	}
+
+	//----------------------------------------------------------------------------
+
+	int codec_benchmark::run()
+	{
+		using FileFormat = image_write_options::FileFormat;
+
+		std::vector<detail::codec_result> codecs = {
+			{ "png",		 detail::make_options(FileFormat::PNG) },
+			{ "png level 1", detail::make_options(FileFormat::PNG, 1) },
+			{ "ppm",		 detail::make_options(FileFormat::PPM) },
+			{ "qoi",		 detail::make_options(FileFormat::QOI) }
+		};
+
+		for (auto& path : m_Options.InputFiles)
+		{
+			m_Output->write_ln("Encoding : %s", path.c_str());
+			std::unique_ptr<image> img(new image(path));
+			const cv::Mat& mat = *img->get_opencv();
+			const size_t raw_bytes = mat.total() * mat.elemSize();
+
+			// grey images are decoded as bgr
+			cv::Mat expected = mat;
+			if (mat.channels() == 1)
+				cv::cvtColor(mat, expected, cv::COLOR_GRAY2BGR);
+
+			for (auto& codec : codecs)
+			{
+				const bool is_qoi = codec.Options.Format == FileFormat::QOI;
+				const auto params = codec.Options.get_encoder_params();
+				std::vector<uint8_t> encoded;
+				cv::Mat decoded;
+
+				utils::timer encode_timer;
+				for (int i = 0; i < NumIterations; ++i)
+				{
+					if (is_qoi)
+						qoi::encode(mat, encoded);
+					else
+						cv::imencode(codec.Options.get_extension(), mat, encoded, params);
+				}
+				codec.EncodeSecs += encode_timer.elapsed();
+
+				utils::timer decode_timer;
+				for (int i = 0; i < NumIterations; ++i)
+				{
+					if (is_qoi)
+						qoi::decode(encoded.data(), encoded.size(), decoded);
+					else
+						decoded = cv::imdecode(encoded, 1);
+				}
+				codec.DecodeSecs += decode_timer.elapsed();
+
+				if (decoded.size() != expected.size() || decoded.type() != expected.type() ||
+					cv::norm(decoded, expected, cv::NORM_INF) != 0)
+				{
+					m_Output->error_ln("%s : decoded image doesn't match the source", codec.Name);
+					++codec.Mismatches;
+				}
+
+				codec.RawBytes += raw_bytes;
+				codec.EncodedBytes += encoded.size();
+			}
+		}
+
+		// throughput is of the uncompressed pixel data
+		m_Output->write_ln("");
+		m_Output->write_ln("%-12s %14s %14s %8s", "Codec", "Encode MB/s", "Decode MB/s", "Size %");
+		for (auto& codec : codecs)
+		{
+			const double mb = static_cast<double>(codec.RawBytes) * NumIterations / (1024.0 * 1024.0);
+			m_Output->write_ln("%-12s %14.1f %14.1f %8.1f",
+				codec.Name,
+				codec.EncodeSecs > 0 ? mb / codec.EncodeSecs : 0.0,
+				codec.DecodeSecs > 0 ? mb / codec.DecodeSecs : 0.0,
+				codec.RawBytes ? 100.0 * codec.EncodedBytes / codec.RawBytes : 0.0);
+		}
+
+		int mismatches = 0;
+		for (auto& codec : codecs)
+			mismatches += codec.Mismatches;
+		return mismatches;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
+} // end namespace
@@ -0,0 +1,80 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef CODECBENCHMARK_H_E868E25B_D195_43F4_925C_F13CBB5B9544
+#define CODECBENCHMARK_H_E868E25B_D195_43F4_925C_F13CBB5B9544
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "../image_processing_abi.h"
+#include "../runtime/session_options.h"
+#include "../runtime/output_interface.h"
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+namespace runtime
+{
+
+	//----------------------------------------------------------------------------
+	// Measure the encode and decode throughput and compressed size of each 
+	// output file format on the input images, checking each round trips.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI codec_benchmark
+	{
+	public:
+		/// Constructor
+		codec_benchmark(const session_options& options, output_interface* output);
+
+		/// Run the benchmark and print a table of the results. Every format is
+		/// lossless so each decoded image is checked against its source, 
+		/// returns the number that didn't match.
+		int run();
+
+	private:
+		/// Times each image is encoded and decoded by each codec
+		static const int NumIterations = 5;
+
+	private:
+		session_options   m_Options;
+		output_interface* m_Output;
+	};
+
+	
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif // CODECBENCHMARK_H_E868E25B_D195_43F4_925C_F13CBB5B9544
@@ -29,10 +29,18 @@
 //----------------------------------------------------------------------------
 #include "experiment_runner.h"
 #include "../variation_iterator.h"
+#include "../exception.h"
 #include "../image.h"
 #include "../utils.h"
 #include "../contact_sheet.h"
 #include "../functions/interface_functions.h"
+#include "../prefix_cache.h"
+#include "../pipeline.h"
+#include "../thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 
 namespace std_filesystem = std::experimental::filesystem;
 
@@ -132,39 +140,242 @@ namespace runtime
 
 	void experiment_runner::run()
 	{
-		auto program = get_program();
+		// every combination of the swept inputs, or a single empty one
+		std::vector<variation> variations;
+		if (m_InputMatrix.size())
+		{
+			std::vector<int> depths;
+			for (auto& vlist : m_InputMatrix)
+				depths.push_back(static_cast<int>(vlist.Values.size()));
+
+			variation_iterator input_it(depths);
+			variation cur_state;
+			while (input_it.next(cur_state))
+				variations.push_back(cur_state);
+		}
+		else
+		{
+			variations.emplace_back();
+		}
+
+		std::vector<std::unique_ptr<image_job>> jobs;
+		for (auto& image_path : get_input_files())
+		{
+			jobs.emplace_back(new image_job());
+			jobs.back()->Path = image_path;
+			jobs.back()->Remaining = variations.size();
+		}
+
+		// each variation on each image is a cell run by one of the workers, 
+		// the results are added to the output matrix in order as they complete
+		std::vector<cell_result> results(jobs.size() * variations.size());
+		std::mutex mutex;
+		std::condition_variable signal;
+		size_t num_decoded = 0;		// images decoded and not yet queued for writing
+		bool stopping = false;
+		std::atomic<bool> failed(false);	// set once any cell fails, the rest are skipped
+		auto complete = [&](cell_result& result)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (result.Error)
+				failed = true;
+			result.Done = true;
+			signal.notify_all();
+		};
+
+		auto run_cell = [&](size_t c)
+		{
+			image_job& job = *jobs[c / variations.size()];
+			const size_t v = c % variations.size();
+			std::call_once(job.Started, [&]
+			{
+				if (!failed)
+					start_image(job, variations[0], results[c - v]);
+				complete(results[c - v]);
+			});
+
+			// the sweep is abandoned once a cell has failed, cells already queued
+			// are marked done without running so the error is raised straight away
+			if (v != 0)
+			{
+				if (!failed)
+				{
+					try
+					{
+						run_variation(job, variations[v], results[c]);
+					}
+					catch (...)
+					{
+						results[c].Error = std::current_exception();
+					}
+				}
+				complete(results[c]);
+			}
+
+			// the image and its cache are freed once every variation has run
+			if (--job.Remaining == 0)
+			{
+				job.Source.reset();
+				job.Cache.reset();
+			}
+		};
+
+		thread_pool workers(get_num_jobs());
+
+		// output images are encoded and written to disk by a pool of threads 
+		// while later cells run
+		bounded_queue<file_result> encoded(PipelineDepth);
+		pipeline_stage encoder([&]
+		{
+			file_result file;
+			while (encoded.pop(file))
+			{
+				if (!file.Image->write_to_file(file.Path, get_write_options()))
+					get_output()->error("Failed to write '%s'\n", file.Path.c_str());
+			}
+		}, [&] { encoded.close(); }, get_num_encoders());
+
+		// input images are decoded ahead of the cells that run on them, at 
+		// most PipelineDepth images are held in memory at once
+		pipeline_stage decoder([&]
+		{
+			for (size_t i = 0; i < jobs.size(); ++i)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					signal.wait(lock, [&] { return stopping || failed || num_decoded < PipelineDepth; });
+					if (stopping || failed)
+						return;
+					++num_decoded;
+				}
+
+				image_job& job = *jobs[i];
+				try
+				{
+					decode_image(job);
+				}
+				catch (...)
+				{
+					results[i * variations.size()].Error = std::current_exception();
+					failed = true;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					job.Decoded = true;
+					signal.notify_all();
+				}
+
+				if (workers.get_num_threads() > 0)
+				{
+					for (size_t c = i * variations.size(); c < (i + 1) * variations.size(); ++c)
+						workers.submit([&run_cell, c] { run_cell(c); });
+				}
+			}
+		}, [&] 
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+			signal.notify_all();
+		});
+
+		// the worker pool runs everything still queued when it's destroyed, so 
+		// however the loop below is left the remaining cells are skipped
+		struct stop_on_exit
+		{
+			std::function<void()> Stop;
+			~stop_on_exit() { Stop(); }
+		} stop_cells{ [&]
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			failed = true;
+			stopping = true;
+			signal.notify_all();
+		} };
+
 		int image_idx = 0;
-		for (auto image_path : get_input_files())
+		image_ptr_list originals;
+		for (size_t c = 0; c < results.size(); ++c)
 		{
-			get_output()->write_ln("Processing : %s", image_path.c_str());
-			image_ptr image = load_image(image_path);
-			if (image)
+			const image_job& job = *jobs[c / variations.size()];
+			const size_t v = c % variations.size();
+			if (v == 0)
+				get_output()->write_ln("Processing : %s", job.Path.c_str());
+
+			// without workers each cell is run as it's reached
+			if (workers.get_num_threads() == 0)
 			{
-				// create output directory for this image 
-				std::string filename;
-				utils::get_filename(image_path, filename);
-				for(char& ch : filename) 
 				{
-					if (ch == '.')
-						ch = '_';
+					std::unique_lock<std::mutex> lock(mutex);
+					signal.wait(lock, [&] { return job.Decoded; });
 				}
-				std_filesystem::path out_dir(m_ImageRootDir);
-				out_dir /= filename;		 
-				std_filesystem::create_directory(out_dir, m_ImageRootDir);
-
-				// run the experiment
-				image_ptr copy(image->clone());
-				run(out_dir, program, copy.get(), image_idx++);
-			}	
+				run_cell(c);
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				signal.wait(lock, [&] { return results[c].Done; });
+			}
+
+			cell_result& result = results[c];
+			if (result.Error)
+				std::rethrow_exception(result.Error);
+
+			if (job.Loaded)
+			{
+				if (m_InputMatrix.size())
+					get_output()->write("%s ... done\n", result.Label.c_str());
+
+				result_matrix::address node_addr;
+				node_addr.push_back(image_idx);
+				node_addr.insert(node_addr.end(), variations[v].begin(), variations[v].end());
+				node_addr.push_back(0);
+				for (auto& file : result.Files)
+				{
+					std::shared_ptr<file_list_node> file_list = std::make_shared<file_list_node>();
+					file_list->add_path(file.Path, file.Name);
+					file_list->set_thumbnail(std::move(file.Thumbnail));
+					m_OutputMatrix.get_node(node_addr) = file_list;
+					++node_addr.back();
+
+					// the queue is only closed early by a failed encoder, join 
+					// raises its error but the file mustn't be dropped silently
+					// if it stopped without one
+					const std::string path = file.Path;
+					if (!encoded.push(std::move(file)))
+					{
+						encoder.join();
+						throw image_write_error(path);
+					}
+				}
+				result.Files.clear();
+			}
+
+			if (v + 1 == variations.size())
+			{
+				if (job.Loaded)
+				{
+					originals.push_back(job.Original);
+					++image_idx;
+				}
+
+				std::lock_guard<std::mutex> lock(mutex);
+				--num_decoded;
+				signal.notify_all();
+			}
 		}
 
+		// every queued image must be on disk before the contact sheet reads them
+		encoded.close();
+		encoder.join();
+
 		if(m_OutputMatrix.num_dimensions() > 2)
 			m_OutputMatrix.trim_single_dimension();
 
 		// write out contact sheets 
 		contact_sheet sheet;
 		std::string title("Title");
-		sheet.auto_build(title, m_OutputMatrix, m_ContactSheetName, get_input_files());
+		sheet.auto_build(title, m_OutputMatrix, m_ContactSheetName, originals);
 
 		if (launch_result())
 			utils::shell_launch(m_ContactSheetName.data());
@@ -173,73 +384,116 @@ namespace runtime
 
 	//----------------------------------------------------------------------------
 
-	void experiment_runner::run(const std::experimental::filesystem::path& out_dir, program* program,  image* source, int image_idx)
+	void experiment_runner::decode_image(image_job& job)
 	{
+		image_ptr unfiltered;
+		image_ptr image = load_image(job.Path, &unfiltered);
+		if (!image)
+			return;
+
+		// the contact sheet is drawn from thumbnails so it never reads an 
+		// image back from disk
+		job.Original = contact_sheet::make_thumbnail(*unfiltered);
+		unfiltered.reset();
+
+		// create output directory for this image 
+		std::string filename;
+		utils::get_filename(job.Path, filename);
+		for(char& ch : filename) 
+		{
+			if (ch == '.')
+				ch = '_';
+		}
+		job.OutDir = m_ImageRootDir;
+		job.OutDir /= filename;		 
+		std_filesystem::create_directory(job.OutDir, m_ImageRootDir);
+
 		// split source path into parts
-		std::string dir, name, ext;
-		utils::get_path_parts(source->get_source_path(), dir, name, ext);
+		job.Source.reset(image->clone());
+		job.SourceKey = get_source_key(job.Source.get());
+		std::string dir, ext;
+		utils::get_path_parts(job.Source->get_source_path(), dir, job.Name, ext);
 
-		// and loop over all variations of the inputs
+		// statements that don't depend on the swept inputs are only run for
+		// the first variation
 		if (m_InputMatrix.size())
 		{
-			std::vector<int> depths;
-			for (auto vlist : m_InputMatrix)
-				depths.push_back(vlist.Values.size());
-			variation_iterator input_it(depths);
+			std::vector<std::string> swept;
+			for (auto& vlist : m_InputMatrix)
+				swept.push_back(vlist.Name);
+			job.Cache.reset(new prefix_cache(get_program(), swept, get_image_pool()));
+		}
 
-			std::vector<int> cur_state;
-			while (input_it.next(cur_state))
-			{
-				// build the input state for this iteration
-				kv_dict inputs;
-				int cur_param = 0;
-				std::string input_str("(");
-				for (auto vlist : m_InputMatrix)
-				{
-					const value& v = vlist.Values[cur_state[cur_param]];
-					inputs.set(vlist.Name, v);
-					if (cur_param)
-						input_str.append(", ");
-					input_str += vlist.Name + std::string("=") + v.to_string();
-					++cur_param;
-				}
-				input_str.append(")");
+		job.Loaded = true;
+	}
 
-				get_output()->write("%s ... ", input_str.c_str());
+	//----------------------------------------------------------------------------
 
-				image_result_list outputs;
-				utils::timer timer;
-				runner::run(program, source, inputs, outputs);
-				input_str.append(std::string(" in ") + timer.elapsed_str_ms() + "ms");
-				get_output()->write("done\n");
+	void experiment_runner::start_image(image_job& job, const variation& first, cell_result& result)
+	{
+		try
+		{
+			run_variation(job, first, result);
 
-				// write all output images to disk
-				result_matrix::address base_addr;
-				base_addr.push_back(image_idx);
-				base_addr.insert(base_addr.end(), cur_state.begin(), cur_state.end());
-				process_outputs(outputs, out_dir, base_addr, input_str, name);
-			}
+			// the other variations would all try to fill it at once
+			if (job.Cache && !job.Cache->is_filled())
+				job.Cache.reset();
 		}
-		else
+		catch (...)
 		{
-			image_result_list outputs;
-			runner::run(program, source, kv_dict(), outputs);
+			result.Error = std::current_exception();
+			job.Source.reset();
+			job.Cache.reset();
+		}
+	}
 
-			// write all output images to disk
-			result_matrix::address base_addr;
-			base_addr.push_back(image_idx);
-			process_outputs(outputs, out_dir, base_addr, "", name);
+	//----------------------------------------------------------------------------
+
+	void experiment_runner::run_variation(image_job& job, const variation& state, cell_result& result)
+	{
+		if (!job.Source)
+			return;
+
+		// build the input state for this variation
+		kv_dict inputs;
+		std::string input_str;
+		if (m_InputMatrix.size())
+		{
+			int cur_param = 0;
+			input_str = "(";
+			for (auto& vlist : m_InputMatrix)
+			{
+				const value& v = vlist.Values[state[cur_param]];
+				inputs.set(vlist.Name, v);
+				if (cur_param)
+					input_str.append(", ");
+				input_str += vlist.Name + std::string("=") + v.to_string();
+				++cur_param;
+			}
+			input_str.append(")");
 		}
+		result.Label = input_str;
+
+		image_result_list outputs;
+		utils::timer timer;
+		runner::run(get_program(), job.Source.get(), inputs, outputs, job.Cache.get(), job.SourceKey);
+		if (m_InputMatrix.size())
+			input_str.append(std::string(" in ") + timer.elapsed_str_ms() + "ms");
+
+		result.Files = name_outputs(outputs, job.OutDir, input_str, job.Name);
+		for (auto& file : result.Files)
+			file.Thumbnail = contact_sheet::make_thumbnail(*file.Image);
 	}
 
 	//----------------------------------------------------------------------------
 
-	void experiment_runner::process_outputs(image_result_list& outputs,
-		const std::experimental::filesystem::path& out_dir, const result_matrix::address& base_addr,
-		const std::string& input_str, const std::string& base_name)
+	experiment_runner::file_result_list experiment_runner::name_outputs(image_result_list& outputs,
+		const std::experimental::filesystem::path& out_dir, const std::string& input_str, 
+		const std::string& base_name) const
 	{
-		// write all output images to disk and add to result matrix
-		size_t cur_output = 0;
+		// choose the file each output image is written to and the name it's
+		// given in the result matrix
+		file_result_list files;
 		for (auto image : outputs)
 		{
 			std_filesystem::path dst_path(out_dir);
@@ -249,25 +503,17 @@ namespace runtime
 				if(!(std::isalpha(ch) || std::isdigit(ch)))
 					ch = '_';
 			}
-			filename += ".png";
+			filename += get_write_options().get_extension();
 			dst_path /= filename;
-			image.Image->write_to_file(dst_path.string());
 
-			std::shared_ptr<file_list_node> file_list = std::make_shared<file_list_node>();
 			std::string name = input_str;
 			if (image.Annotation.size())
 			{
 				name = image.Annotation;
 			}
-			file_list->add_path(dst_path.string(), name);
-
-			// add to the output matrix
-			result_matrix::address node_addr(base_addr);
-			node_addr.push_back(cur_output);
-			m_OutputMatrix.get_node(node_addr) = file_list;
-
-			++cur_output;
+			files.push_back(file_result{ dst_path.string(), name, image.Image });
 		}
+		return files;
 	}
 
 	//----------------------------------------------------------------------------
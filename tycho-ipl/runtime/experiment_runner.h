@@ -34,7 +34,12 @@
 #include "../runtime/runner.h"
 #include "../result_set.h"
 #include "../image.h"
+#include "../prefix_cache.h"
 
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -71,11 +76,52 @@ namespace runtime
 		void run() override;
 		
 	private:
+		using variation = std::vector < int > ;
+
+		/// Output image and the file it's written to
+		struct file_result
+		{
+			std::string Path;
+			std::string Name;	///< name in the result matrix
+			image_ptr Image;
+			image_ptr Thumbnail;	///< of Image, for the contact sheet
+		};
+
+		using file_result_list = std::vector < file_result > ;
+
+		/// Shared by the runs of the variations on one input image. The image 
+		/// is decoded ahead of its variations. The first variation to start 
+		/// runs before the others, and fills the prefix cache they read from.
+		struct image_job
+		{
+			std::string Path;
+			std::experimental::filesystem::path OutDir;
+			std::string Name;
+			image_ptr Source;
+			uint64_t SourceKey = 0;	///< result cache key of Source
+			image_ptr Original;	///< thumbnail of the image before the prefilter
+			std::unique_ptr<prefix_cache> Cache;
+			bool Decoded = false;
+			bool Loaded = false;
+			std::once_flag Started;
+			std::atomic<size_t> Remaining{0};
+		};
+
+		/// Result of running one variation on one input image
+		struct cell_result
+		{
+			std::string Label;	///< the inputs of the variation
+			file_result_list Files;
+			std::exception_ptr Error;
+			bool Done = false;
+		};
+
 		void build_input_matrix(const session_options::input_map& raw_inputs);
-		void run(const std::experimental::filesystem::path& out_dir, program* program, image* source, int image_idx);
-		void process_outputs(image_result_list& outputs, const std::experimental::filesystem::path& out_dir,
-			const result_matrix::address& base_addr, const std::string& input_str, 
-			const std::string& base_name);
+		void decode_image(image_job& job);
+		void start_image(image_job& job, const variation& first, cell_result& result);
+		void run_variation(image_job& job, const variation& state, cell_result& result);
+		file_result_list name_outputs(image_result_list& outputs, const std::experimental::filesystem::path& out_dir,
+			const std::string& input_str, const std::string& base_name) const;
 
 	private:
 		using value_list = std::vector < value > ;
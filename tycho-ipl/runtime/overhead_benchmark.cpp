@@ -0,0 +1,141 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "overhead_benchmark.h"
+#include "../context.h"
+#include "../image.h"
+#include "../key_value.h"
+#include "../program.h"
+#include "../utils.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+namespace runtime
+{
+
+	//----------------------------------------------------------------------------
+
+	overhead_benchmark::overhead_benchmark(output_interface* output) :
+		m_Output(output)
+	{
+	}
+
+	//----------------------------------------------------------------------------
+
+	void overhead_benchmark::run()
+	{
+		// results are summed so the compiler can't drop the work
+		volatile int sink = 0;
+		auto ns_per = [](const utils::timer& timer, double count) { return timer.elapsed() * 1e9 / count; };
+
+		m_Output->write_ln("%-36s %10zu bytes", "sizeof(value)", sizeof(value));
+
+		// copy a register file sized vector of values
+		{
+			std::vector<value> values;
+			for (int i = 0; i < 16; ++i)
+				values.push_back(i % 2 ? value::make_integer(i) : value::make_name("name" + std::to_string(i)));
+
+			utils::timer timer;
+			for (int i = 0; i < NumIterations; ++i)
+			{
+				std::vector<value> copy(values);
+				sink += copy[i % 16].get_type() == ObjectType::Integer ? 1 : 0;
+			}
+			m_Output->write_ln("%-36s %10.1f ns", "copy a vector of 16 values", ns_per(timer, NumIterations));
+		}
+
+		// the arguments of a typical call
+		{
+			utils::timer timer;
+			for (int i = 0; i < NumIterations; ++i)
+			{
+				kv_dict inputs;
+				inputs.set_image("src", nullptr);
+				inputs.set_integer("kernel_size", i);
+				inputs.set_float("sigma_x", 1.0f);
+				inputs.set_name("type", "THRESH_BINARY");
+				sink += inputs.get_integer("kernel_size") + (inputs.exists("sigma_y") ? 1 : 0);
+			}
+			m_Output->write_ln("%-36s %10.1f ns", "kv_dict of 4 inputs, build + 2 gets", ns_per(timer, NumIterations));
+		}
+
+		// a chain of calls that are neither fused nor reused, on an image 
+		// small enough that the functions themselves cost next to nothing
+		{
+			std::string source = "temp image";
+			for (int i = 0; i < NumStatements - 1; ++i)
+				source += (i ? ", t" : " t") + std::to_string(i);
+			source += ";\n";
+			for (int i = 0; i < NumStatements; ++i)
+			{
+				const std::string src = i ? "t" + std::to_string(i - 1) : "__src__";
+				const std::string dst = i < NumStatements - 1 ? "t" + std::to_string(i) : "__dst__";
+				source += "call gaussian_blur(src = " + src + ", dst = " + dst + ", kernel_size = 3);\n";
+			}
+
+			program program(source.data(), source.size(), "overhead_benchmark.fx");
+			if (program.has_errors())
+			{
+				program.print_messages(*m_Output);
+				return;
+			}
+
+			image src(image::Format::RGB, 4, 4);
+			src.clear_to_black();
+			context context(&program, nullptr);
+			context.set_strip_height(0);
+
+			utils::timer timer;
+			for (int i = 0; i < NumRuns; ++i)
+			{
+				image* dst = nullptr;
+				context.execute(&src, dst, kv_dict());
+				sink += dst ? dst->get_width() : 0;
+				delete dst;
+			}
+			m_Output->write_ln("%-36s %10.1f ns", "execute, per statement", ns_per(timer, double(NumRuns) * NumStatements));
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
+} // end namespace
@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef OVERHEADBENCHMARK_H_72DDF32D_D069_4554_BDDF_AA06220BFA99
+#define OVERHEADBENCHMARK_H_72DDF32D_D069_4554_BDDF_AA06220BFA99
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "../image_processing_abi.h"
+#include "../runtime/output_interface.h"
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+namespace runtime
+{
+
+	//----------------------------------------------------------------------------
+	// Measure the fixed cost the interpreter adds to each statement, separate 
+	// from the work the functions do: copying values, building and reading
+	// argument dictionaries and dispatching a statement on a tiny image.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI overhead_benchmark
+	{
+	public:
+		/// Constructor
+		explicit overhead_benchmark(output_interface* output);
+
+		/// Run the benchmark and print the time each operation takes
+		void run();
+
+	private:
+		/// Times each operation is repeated
+		static const int NumIterations = 200000;
+
+		/// Statements in the script timed by the dispatch benchmark
+		static const int NumStatements = 10;
+
+		/// Times the dispatch script is run
+		static const int NumRuns = 2000;
+
+	private:
+		output_interface* m_Output;
+	};
+
+	
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif // OVERHEADBENCHMARK_H_72DDF32D_D069_4554_BDDF_AA06220BFA99
@@ -0,0 +1,295 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "program_test.h"
+#include "../context.h"
+#include "../functions/common.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+namespace runtime
+{
+
+	namespace detail
+	{
+		// Collects the images added by a program for one run
+		class test_collector : public execution_interface
+		{
+		public:
+			explicit test_collector(image_ptr_list& outputs) :
+				m_Outputs(outputs)
+			{}
+
+			void add_experiment_image(image* image, const std::string& /*name*/) override
+			{
+				m_Outputs.push_back(image_ptr(image->clone()));
+			}
+
+		private:
+			image_ptr_list& m_Outputs;
+		};
+
+		// Result of one run of a program
+		struct test_run
+		{
+			image_ptr_list Outputs;
+			std::exception_ptr Error;
+		};
+
+	} // end namespace
+
+	//----------------------------------------------------------------------------
+
+	program_test::program_test(const session_options& options, output_interface* output) :
+		m_Options(options),
+		m_Output(output)
+	{
+	}
+
+	//----------------------------------------------------------------------------
+
+	int program_test::run_thread_stress()
+	{
+		size_t num_threads = m_Options.StressThreads;
+		if (num_threads == 0)
+			num_threads = std::max(std::thread::hardware_concurrency(), 2u);
+
+		image_ptr_list sources = load_sources();
+		if (sources.empty())
+			return 0;
+
+		int failed = 0;
+		for (auto& path : m_Options.TestPrograms)
+		{
+			auto program = load(path);
+			if (!program)
+			{
+				++failed;
+				continue;
+			}
+
+			std::vector<detail::test_run> expected(sources.size());
+			for (size_t i = 0; i < sources.size(); ++i)
+				execute_on_new_thread(*program, *sources[i], 0, expected[i].Outputs, expected[i].Error);
+
+			// the threads share nothing but the program and the read only 
+			// source images, each round gives every thread a different image
+			size_t num_runs = 0;
+			size_t num_differ = 0;
+			for (int round = 0; round < NumStressRounds; ++round)
+			{
+				std::vector<detail::test_run> runs(num_threads);
+				std::vector<std::thread> threads;
+				for (size_t t = 0; t < num_threads; ++t)
+				{
+					const size_t i = (t + round) % sources.size();
+					threads.emplace_back([&, t, i]
+					{
+						try
+						{
+							runs[t].Outputs = execute(*program, *sources[i], 0);
+						}
+						catch (...)
+						{
+							runs[t].Error = std::current_exception();
+						}
+					});
+				}
+				for (auto& thread : threads)
+					thread.join();
+
+				for (size_t t = 0; t < num_threads; ++t)
+				{
+					const detail::test_run& want = expected[(t + round) % sources.size()];
+					const bool same = (want.Error != nullptr) == (runs[t].Error != nullptr) &&
+						same_outputs(want.Outputs, runs[t].Outputs);
+					if (!same)
+						++num_differ;
+					++num_runs;
+				}
+			}
+
+			if (num_differ)
+			{
+				m_Output->error_ln("%s : FAILED, %zu of %zu runs on %zu threads differ from a single thread", 
+					path.c_str(), num_differ, num_runs, num_threads);
+				++failed;
+			}
+			else
+			{
+				m_Output->write_ln("%s : %zu runs on %zu threads ok", path.c_str(), num_runs, num_threads);
+			}
+		}
+		return failed;
+	}
+
+	//----------------------------------------------------------------------------
+
+	int program_test::run_strip_check()
+	{
+		image_ptr_list sources = load_sources();
+
+		int failed = 0;
+		for (auto& path : m_Options.TestPrograms)
+		{
+			auto program = load(path);
+			if (!program)
+			{
+				++failed;
+				continue;
+			}
+
+			size_t num_differ = 0;
+			for (auto& source : sources)
+			{
+				detail::test_run whole, strips;
+				execute_on_new_thread(*program, *source, 0, whole.Outputs, whole.Error);
+				execute_on_new_thread(*program, *source, m_Options.StripTestHeight, strips.Outputs, strips.Error);
+
+				const bool same = (whole.Error != nullptr) == (strips.Error != nullptr) &&
+					same_outputs(whole.Outputs, strips.Outputs);
+				if (!same)
+				{
+					m_Output->error_ln("%s : %s differs with strips of %d rows", 
+						path.c_str(), source->get_source_path().c_str(), m_Options.StripTestHeight);
+					++num_differ;
+				}
+			}
+
+			if (num_differ)
+			{
+				m_Output->error_ln("%s : FAILED, %zu of %zu images differ", path.c_str(), num_differ, sources.size());
+				++failed;
+			}
+			else
+			{
+				m_Output->write_ln("%s : %zu images ok with strips of %d rows", 
+					path.c_str(), sources.size(), m_Options.StripTestHeight);
+			}
+		}
+		return failed;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image_ptr_list program_test::load_sources() const
+	{
+		image_ptr_list sources;
+		for (auto& path : m_Options.InputFiles)
+			sources.push_back(image_ptr(new image(path)));
+		return sources;
+	}
+
+	//----------------------------------------------------------------------------
+
+	std::unique_ptr<program> program_test::load(const std::string& path) const
+	{
+		auto program = program::create_from_file_cached(path.c_str(), nullptr);
+		if (program)
+			program->print_messages(*m_Output);
+
+		if (!program || program->has_errors())
+		{
+			m_Output->error_ln("%s : FAILED, unable to load the program", path.c_str());
+			return nullptr;
+		}
+		return program;
+	}
+
+	//----------------------------------------------------------------------------
+
+	image_ptr_list program_test::execute(const program& program, const image& source, int strip_height) const
+	{
+		image_ptr_list outputs;
+		detail::test_collector collector(outputs);
+		context context(&program, &collector);
+		context.set_strip_height(strip_height);
+
+		std::unique_ptr<image> src(source.clone());
+		image* dst = nullptr;
+		if (context.execute(src.get(), dst, kv_dict()) && dst)
+			outputs.push_back(image_ptr(dst));
+		return outputs;
+	}
+
+	//----------------------------------------------------------------------------
+
+	void program_test::execute_on_new_thread(const program& program, const image& source, int strip_height,
+		image_ptr_list& outputs, std::exception_ptr& error) const
+	{
+		// functions using opencv's per thread random number generator start 
+		// from the same state on a new thread, so runs are repeatable
+		std::thread([&]
+		{
+			try
+			{
+				outputs = execute(program, source, strip_height);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+		}).join();
+	}
+
+	//----------------------------------------------------------------------------
+
+	bool program_test::same_outputs(const image_ptr_list& a, const image_ptr_list& b)
+	{
+		if (a.size() != b.size())
+			return false;
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			const cv::Mat& ma = *a[i]->get_opencv();
+			const cv::Mat& mb = *b[i]->get_opencv();
+			if (a[i]->get_format() != b[i]->get_format() || ma.size() != mb.size() || ma.type() != mb.type())
+				return false;
+			if (!ma.empty() && cv::norm(ma, mb, cv::NORM_INF) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
+} // end namespace
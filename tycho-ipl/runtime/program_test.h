@@ -0,0 +1,98 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef PROGRAMTEST_H_DBC8D9FD_E91F_498A_B6F1_5FB2A38516A3
+#define PROGRAMTEST_H_DBC8D9FD_E91F_498A_B6F1_5FB2A38516A3
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "../image_processing_abi.h"
+#include "../image.h"
+#include "../program.h"
+#include "../runtime/session_options.h"
+#include "../runtime/output_interface.h"
+
+#include <exception>
+#include <memory>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+namespace runtime
+{
+
+	//----------------------------------------------------------------------------
+	// Self tests that run each of a set of programs over the input images in
+	// two different ways and check both give exactly the same images.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI program_test
+	{
+	public:
+		/// Constructor
+		program_test(const session_options& options, output_interface* output);
+
+		/// Run each program on many threads at once, each with its own context
+		/// and a different image, and compare with running it on one thread. 
+		/// Returns the number of programs that failed.
+		int run_thread_stress();
+
+		/// Run each program with whole images and a few rows at a time, the 
+		/// radius each function declares must cover every pixel it reads for 
+		/// both to match. Returns the number of programs that failed.
+		int run_strip_check();
+
+	private:
+		/// Times every thread runs the program in the stress test
+		static const int NumStressRounds = 4;
+
+	private:
+		std::unique_ptr<program> load(const std::string& path) const;
+		image_ptr_list execute(const program& program, const image& source, int strip_height) const;
+		void execute_on_new_thread(const program& program, const image& source, int strip_height, 
+			image_ptr_list& outputs, std::exception_ptr& error) const;
+		image_ptr_list load_sources() const;
+		static bool same_outputs(const image_ptr_list& a, const image_ptr_list& b);
+
+	private:
+		session_options   m_Options;
+		output_interface* m_Output;
+	};
+
+	
+} // end namespace
+} // end namespace
+} // end namespace
+
+#endif // PROGRAMTEST_H_DBC8D9FD_E91F_498A_B6F1_5FB2A38516A3
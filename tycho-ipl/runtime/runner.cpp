@@ -29,6 +29,7 @@
 //----------------------------------------------------------------------------
 #include "runner.h"
 #include "../image.h"
+#include "../program.h"
 
 //----------------------------------------------------------------------------
 // Class
@@ -45,14 +46,29 @@ namespace runtime
 
 	runner::runner(const session_options& options, output_interface* output) :
 		m_Options(options),
-		m_Output(output)
+		m_Output(output),
+		m_ImagePool(options.ImagePoolSize),
+		m_ThreadPool(options.NumThreads)
 	{
-		
+		if (options.CacheDir.length())
+		{
+			m_ResultCache.reset(new result_cache(options.CacheDir, options.CacheSize));
+			m_ResultCache->set_min_cost(options.CacheMinTime / 1000.0);
+		}
+
 		if (options.PrefilterProgram.length())
 			m_PrefilterProgram = load_program(options.PrefilterProgram);
 			
 		if (options.Program.length())
 			m_Program = load_program(options.Program);
+
+		if (options.CompileNative)
+		{
+			if (m_PrefilterProgram)
+				m_PrefilterNative = load_native(*m_PrefilterProgram, options.PrefilterProgram);
+			if (m_Program)
+				m_Native = load_native(*m_Program, options.Program);
+		}
 			
 	}
 
@@ -67,7 +83,8 @@ namespace runtime
 
 	std::unique_ptr<program> runner::load_program(const std::string& path) const
 	{
-		auto program = program::create_from_file(path.c_str());
+		auto program = program::create_from_file_cached(path.c_str(), 
+			m_Options.CacheDir.length() ? m_Options.CacheDir.c_str() : nullptr);
 
 		if (!program)
 			throw program_load_error(path);
@@ -82,13 +99,54 @@ namespace runtime
 
 	//----------------------------------------------------------------------------
 
-	image_ptr runner::load_image(const std::string& path) const
+	std::unique_ptr<native_program> runner::load_native(const program& program, const std::string& path) const
+	{
+		// built next to the script, or in the cache directory keyed by the 
+		// program so edits that don't change it reuse the library
+		std::string lib_path;
+		if (m_Options.CacheDir.length())
+		{
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.so", 
+				static_cast<unsigned long long>(native_program::get_program_hash(program)));
+			lib_path = m_Options.CacheDir;
+			if (lib_path.back() != '/' && lib_path.back() != '\\')
+				lib_path += '/';
+			lib_path += name;
+		}
+		else
+		{
+			const size_t ext = path.find_last_of('.');
+			const size_t sep = path.find_last_of("/\\");
+			const bool has_ext = ext != std::string::npos && (sep == std::string::npos || ext > sep);
+			lib_path = path.substr(0, has_ext ? ext : std::string::npos) + ".so";
+		}
+
+		try
+		{
+			return native_program::load_or_build(program, lib_path);
+		}
+		catch (const native_build_error& ex)
+		{
+			m_Output->error_ln("Warning : %s, the script will be interpreted", ex.what());
+			return nullptr;
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+	image_ptr runner::load_image(const std::string& path, image_ptr* unfiltered) const
 	{
 		image_ptr img(new image(path.c_str()));
+		if (unfiltered)
+			*unfiltered = img;
 
 		if (m_PrefilterProgram)
 		{
-			context context(m_PrefilterProgram.get(), nullptr);
+			context context(m_PrefilterProgram.get(), nullptr, &m_ImagePool, &m_ThreadPool);
+			context.set_result_cache(m_ResultCache.get());
+			context.set_strip_height(m_Options.StripHeight);
+			context.set_native(m_PrefilterNative.get());
 			image* dst = nullptr;
 			context.execute(img.get(), dst, kv_dict());
 			img = image_ptr(dst);
@@ -98,26 +156,53 @@ namespace runtime
 
 	//----------------------------------------------------------------------------
 
+	namespace
+	{
+		// Collects the images added by a program for one run
+		class output_collector : public execution_interface
+		{
+		public:
+			explicit output_collector(runner::image_result_list& outputs) :
+				m_Outputs(outputs)
+			{}
+
+			void add_experiment_image(image* image, const std::string& name) override
+			{
+				image_ptr copy(image->clone());
+				m_Outputs.push_back(runner::image_result(copy, name));
+			}
+
+		private:
+			runner::image_result_list& m_Outputs;
+		};
+	}
+
+	//----------------------------------------------------------------------------
+
 	void runner::run(
 		const program* program, image* source,
-		const kv_dict& inputs, image_result_list& outputs)
+		const kv_dict& inputs, image_result_list& outputs,
+		prefix_cache* cache, uint64_t source_key)
 	{
-		context context(program, this);
+		output_collector collector(outputs);
+		context context(program, &collector, &m_ImagePool, &m_ThreadPool);
+		context.set_prefix_cache(cache);
+		context.set_result_cache(m_ResultCache.get());
+		context.set_source_key(source_key);
+		context.set_strip_height(m_Options.StripHeight);
+		context.set_native(program == m_Program.get() ? m_Native.get() : nullptr);
 		image* dst = nullptr;
-		m_CurOutputs = &outputs;
 		if (context.execute(source, dst, inputs) && dst)
 		{
-			m_CurOutputs->push_back(image_result(image_ptr(dst), ""));
+			outputs.push_back(image_result(image_ptr(dst), ""));
 		}
-		m_CurOutputs = nullptr;
 	}
 
 	//----------------------------------------------------------------------------
 
-	void runner::add_experiment_image(image* image, const std::string& name)
+	uint64_t runner::get_source_key(const image* source) const
 	{
-		image_ptr copy(image->clone());
-		m_CurOutputs->push_back(image_result(copy, name));
+		return m_ResultCache ? result_cache::hash(source) : 0;
 	}
 
 	//----------------------------------------------------------------------------
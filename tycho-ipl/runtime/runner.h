@@ -35,6 +35,11 @@
 #include "../image_processing_abi.h"
 #include "../context.h"
 #include "../image.h"
+#include "../image_pool.h"
+#include "../native_program.h"
+#include "../pipeline.h"
+#include "../result_cache.h"
+#include "../thread_pool.h"
 #include "../runtime/session_options.h"
 #include "../runtime/output_interface.h"
 
@@ -54,7 +59,7 @@ namespace runtime
 	//----------------------------------------------------------------------------
 	// Base runner
 	//----------------------------------------------------------------------------
-	class TYCHO_IMAGEPROCESSING_ABI runner : public execution_interface
+	class TYCHO_IMAGEPROCESSING_ABI runner
 	{
 	public:
 		struct image_result
@@ -80,32 +85,55 @@ namespace runtime
 		/// Execute
 		virtual void run() = 0;
 
+	protected:
+		/// Number of input images decoded ahead of, and of output images 
+		/// waiting to be written behind, the ones being run
+		static const size_t PipelineDepth = 2;
+
 	protected:
 		std::unique_ptr<program> load_program(const std::string& path) const;
-		image_ptr load_image(const std::string& path) const;
+		std::unique_ptr<native_program> load_native(const program& program, const std::string& path) const;
+		/// Read an image and run the prefilter on it, unfiltered is set to 
+		/// the image as it was read if it's given
+		image_ptr load_image(const std::string& path, image_ptr* unfiltered = nullptr) const;
 		
 		const program* get_program() const { return m_Program.get(); }
 		program* get_program() { return m_Program.get(); }
 
 		const output_interface* get_output() const { return m_Output; }
+		image_pool* get_image_pool() const { return &m_ImagePool; }
 
 		const session_options::file_list& get_input_files() const { return m_Options.InputFiles; }
 		bool launch_result() const { return m_Options.LaunchResult;  }
+		size_t get_num_jobs() const { return m_Options.NumJobs; }
+		size_t get_num_encoders() const { return m_Options.NumEncoders; }
+		const image_write_options& get_write_options() const { return m_Options.WriteOptions; }
  
+		/// Run a program, the result and any images added by the program are 
+		/// appended to outputs. Can be called from several threads at once.
+		/// source_key is the key from get_source_key() if the caller has it.
 		void run(const program* program, image* source,
 			const kv_dict& inputs,
-			image_result_list& outputs);
+			image_result_list& outputs,
+			prefix_cache* cache = nullptr,
+			uint64_t source_key = 0);
 
-		// ExecutionInterface
-		void add_experiment_image(image* image, const std::string& name) override;
+		/// Result cache key of an input image, 0 if there's no result cache. 
+		/// Callers running an image more than once compute it once and pass it
+		/// to run().
+		uint64_t get_source_key(const image* source) const;
 
 
 	private:
 		session_options			 m_Options;
 		std::unique_ptr<program> m_Program;
 		std::unique_ptr<program> m_PrefilterProgram;
+		std::unique_ptr<native_program> m_Native;
+		std::unique_ptr<native_program> m_PrefilterNative;
 		output_interface*		 m_Output;
-		image_result_list*		 m_CurOutputs;
+		mutable image_pool		 m_ImagePool;
+		mutable thread_pool		 m_ThreadPool;
+		std::unique_ptr<result_cache> m_ResultCache;
 	};
 
 	
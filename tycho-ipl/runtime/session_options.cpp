@@ -29,9 +29,18 @@
 //----------------------------------------------------------------------------
 #include "session_options.h"
 #include "output_interface.h"
+#include "../function.h"
+#include "../functions/factory.h"
 #include "../utils.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
 #include <regex>
 
 #ifdef _MSC_VER
@@ -68,7 +77,8 @@ namespace runtime
 			".sr",
 			".ras",
 			".tiff",
-			".tif"
+			".tif",
+			".qoi"
 		};
 
 
@@ -83,6 +93,55 @@ namespace runtime
 
 		//----------------------------------------------------------------------------
 
+		bool is_program_extension(const std::string& path)
+		{
+			std::string dir, name, ext;
+			utils::get_path_parts(path, dir, name, ext);
+			std::transform(ext.begin(), ext.end(), ext.begin(), [](char ch) { return static_cast<char>(::tolower(ch)); });
+
+			return ext == ".fx";
+		}
+
+		//----------------------------------------------------------------------------
+
+		/// Most threads the thread count options accept
+		const long long MaxThreads = 1024;
+
+		/// Largest size in megabytes that fits in a size_t once converted to bytes
+		const long long MaxMegabytes = static_cast<long long>(std::numeric_limits<size_t>::max() / (1024 * 1024));
+
+		//----------------------------------------------------------------------------
+		// Parse the value of an integer option, raising invalid_parameter if it
+		// is empty, isn't a whole number or is outside [min, max]
+		//----------------------------------------------------------------------------
+		static long long parse_count(const std::string& key, const std::string& val, long long min, long long max)
+		{
+			char msg[128];
+			if (val.empty())
+			{
+				snprintf(msg, sizeof(msg), "--%s : no value specified", key.c_str());
+				throw invalid_parameter(msg);
+			}
+
+			// strtoll skips leading spaces and accepts a sign so check the first
+			// character ourselves, otherwise -1 or " 4" would get through
+			errno = 0;
+			char* end = nullptr;
+			const long long n = strtoll(val.c_str(), &end, 10);
+			const bool digits = ::isdigit(static_cast<unsigned char>(val[0])) || (val[0] == '-' && min < 0);
+			if (!digits || *end != 0 || errno == ERANGE || n < min || n > max)
+			{
+				if (max >= std::numeric_limits<int>::max())
+					snprintf(msg, sizeof(msg), "--%s : value must be an integer of at least %lld", key.c_str(), min);
+				else
+					snprintf(msg, sizeof(msg), "--%s : value must be an integer from %lld to %lld", key.c_str(), min, max);
+				throw invalid_parameter(msg);
+			}
+			return n;
+		}
+
+		//----------------------------------------------------------------------------
+
 		static bool split_arg(const char *arg, std::string& key, std::string& val)
 		{
 			const char* eq = strchr(arg, '=');
@@ -108,6 +167,9 @@ namespace runtime
 	session_options::session_options(const std::vector<std::string>& in_args)
 	{
 		bool is_experiment = false;
+		bool is_codec_benchmark = false;
+		bool is_stress_test = false;
+		bool is_strip_test = false;
 		std::vector<std::string> args;
 
 		// output directory defaults to cwd
@@ -160,6 +222,10 @@ namespace runtime
 			{
 				MakeContactSheet = true;
 			}
+			else if (key == "compile")
+			{
+				CompileNative = true;
+			}
 			else if (key == "prefilter")
 			{
 				if (!has_val)
@@ -190,6 +256,100 @@ namespace runtime
 			{
 				is_experiment = true;
 			}
+			else if (key == "overhead_benchmark")
+			{
+				RunAction = action::BenchmarkOverhead;
+			}
+			else if (key == "codec_benchmark")
+			{
+				is_codec_benchmark = true;
+			}
+			else if (key == "stress")
+			{
+				is_stress_test = true;
+				if (has_val)
+					StressThreads = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxThreads));
+			}
+			else if (key == "strip_test")
+			{
+				is_strip_test = true;
+				if (has_val)
+					StripTestHeight = static_cast<int>(detail::parse_count(key, val, 1, std::numeric_limits<int>::max()));
+			}
+			else if (key == "image_pool")
+			{
+				ImagePoolSize = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxMegabytes)) * 1024 * 1024;
+			}
+			else if (key == "threads")
+			{
+				NumThreads = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxThreads));
+			}
+			else if (key == "jobs")
+			{
+				NumJobs = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxThreads));
+			}
+			else if (key == "cache_dir")
+			{
+				if (!has_val)
+					throw invalid_parameter("--cache_dir : no directory specified");
+				CacheDir = val;
+			}
+			else if (key == "cache_size")
+			{
+				CacheSize = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxMegabytes)) * 1024 * 1024;
+			}
+			else if (key == "cache_min_time")
+			{
+				CacheMinTime = static_cast<int>(detail::parse_count(key, val, 0, std::numeric_limits<int>::max()));
+			}
+			else if (key == "strip_height")
+			{
+				StripHeight = static_cast<int>(detail::parse_count(key, val, 0, std::numeric_limits<int>::max()));
+			}
+			else if (key == "format")
+			{
+				static const std::map<std::string, image_write_options::FileFormat> formats = {
+					{ "png",  image_write_options::FileFormat::PNG },
+					{ "jpg",  image_write_options::FileFormat::JPEG },
+					{ "jpeg", image_write_options::FileFormat::JPEG },
+					{ "ppm",  image_write_options::FileFormat::PPM },
+					{ "tif",  image_write_options::FileFormat::TIFF },
+					{ "tiff", image_write_options::FileFormat::TIFF },
+					{ "qoi",  image_write_options::FileFormat::QOI }
+				};
+
+				auto it = formats.find(val);
+				if (it == formats.end())
+					throw invalid_parameter("--format : format must be one of png, jpg, ppm, tiff or qoi");
+				WriteOptions.Format = it->second;
+			}
+			else if (key == "png_level")
+			{
+				WriteOptions.PngLevel = static_cast<int>(detail::parse_count(key, val, 0, 9));
+			}
+			else if (key == "png_strategy")
+			{
+				static const std::map<std::string, image_write_options::Strategy> strategies = {
+					{ "default",  image_write_options::Strategy::Default },
+					{ "filtered", image_write_options::Strategy::Filtered },
+					{ "huffman",  image_write_options::Strategy::HuffmanOnly },
+					{ "rle",	  image_write_options::Strategy::RLE },
+					{ "fixed",	  image_write_options::Strategy::Fixed }
+				};
+
+				auto it = strategies.find(val);
+				if (it == strategies.end())
+					throw invalid_parameter("--png_strategy : strategy must be one of default, filtered, huffman, rle or fixed");
+				WriteOptions.PngStrategy = it->second;
+			}
+			else if (key == "jpeg_quality")
+			{
+				WriteOptions.JpegQuality = static_cast<int>(detail::parse_count(key, val, 0, 100));
+			}
+			else if (key == "encoders")
+			{
+				NumEncoders = static_cast<size_t>(detail::parse_count(key, val, 0, detail::MaxThreads));
+			}
 			else
 			{
 				UnknownOptions.push_back(arg);
@@ -211,10 +371,13 @@ namespace runtime
 			++narg;
 		}
 
-		// program to execute
+		// program to execute, the codec benchmark only takes images and the
+		// self tests take any number of programs mixed with the images
+		const bool is_self_test = is_stress_test || is_strip_test;
 		if (narg < args.size())
 		{
-			Program = args[narg++];
+			if (!is_codec_benchmark && !is_self_test)
+				Program = args[narg++];
 
 			bool case_sensitive_glob = true;
 #ifdef _MSC_VER
@@ -244,7 +407,9 @@ namespace runtime
 				}
 				for (auto arg : globbed)
 				{
-					if (detail::is_supported_extension(arg))
+					if (is_self_test && detail::is_program_extension(arg))
+						TestPrograms.push_back(arg);
+					else if (detail::is_supported_extension(arg))
 						InputFiles.push_back(arg);
 					else
 						fprintf(stderr, "Ignoring '%s' : unrecognized extension\n", arg.c_str());
@@ -257,7 +422,19 @@ namespace runtime
 		}
 
 
-		if (RunAction == action::Run)
+		if (RunAction == action::Run && is_codec_benchmark)
+		{
+			RunAction = action::BenchmarkCodecs;
+		}
+		else if (RunAction == action::Run && is_stress_test)
+		{
+			RunAction = action::StressTest;
+		}
+		else if (RunAction == action::Run && is_strip_test)
+		{
+			RunAction = action::StripTest;
+		}
+		else if (RunAction == action::Run)
 		{
 			// see if we have any inputs greater than length 1, if so we go into experiment mode
 			if(!is_experiment)
@@ -304,6 +481,23 @@ namespace runtime
 			"    --output_dir=<dir>       : Directory to save the result in\n"
 			"    --experiment             : Run an experiment\n"
 			"    --contact                : Create a contact sheet for result images\n"
+			"    --image_pool=<mb>        : Maximum size of recycled image buffers, 0 to disable (default 512)\n"
+			"    --threads=<n>            : Number of threads used to run independent statements, 0 for one per core (default 0)\n"
+			"    --jobs=<n>               : Number of experiment variations and images run at once, 0 for one per core (default 1)\n"
+			"    --cache_dir=<dir>        : Directory to store statement results in and reuse them from on later runs\n"
+			"    --cache_size=<mb>        : Maximum size of the result cache directory (default 4096)\n"
+			"    --cache_min_time=<ms>    : Only store results that take at least this long to compute (default 0)\n"
+			"    --strip_height=<rows>    : Rows processed at a time by statements that only read nearby pixels, 0 to disable (default 256)\n"
+			"    --compile                : Compile scripts to native code and run that instead of interpreting them\n"
+			"    --format=<fmt>           : File format of result images, png, jpg, ppm, tiff or qoi (default png)\n"
+			"    --png_level=<0-9>        : PNG compression level, lower is faster (default opencv's)\n"
+			"    --png_strategy=<name>    : PNG compression strategy, default, filtered, huffman, rle or fixed\n"
+			"    --jpeg_quality=<0-100>   : JPEG quality (default 95)\n"
+			"    --encoders=<n>           : Number of threads writing result images, 0 for one per core (default 0)\n"
+			"    --codec_benchmark        : Time encoding and decoding the images in each result format, takes no program\n"
+			"    --overhead_benchmark     : Time value copies, argument dictionaries and statement dispatch\n"
+			"    --stress=<n>             : Run each program on n threads at once and check the results match one thread, takes any number of programs\n"
+			"    --strip_test=<rows>      : Run each program on whole images and strips of rows and check the results match (default 16)\n"
 			"    --sphinx=<dir>           : Generate reStructred text docs for all functions\n"
 			"    --functions_md           : Generate a basic summary of all functions using markdown syntax\n"
 			"\n"
@@ -322,7 +516,7 @@ namespace runtime
 		output.write_ln("| Function | Description |");
 		output.write_ln("|----------|-------------|");
 
-		auto fp = [&output](function* func) {
+		auto fp = [&output](const function* func) {
 			output.write_ln("|%s|%s|", func->get_name(), func->get_description());
 		};
 
@@ -343,7 +537,7 @@ namespace runtime
 			}
 		};
 
-		auto fp = [&output, pp](function* func) {
+		auto fp = [&output, pp](const function* func) {
 			output.write_ln("----------------------------------------");
 			output.write_ln("%s\n", func->get_description());
 			output.write_ln("%s", func->get_signature().c_str());
@@ -397,7 +591,7 @@ namespace runtime
 		FuncMap func_map;
 		PathList all_funcs;
 
-		auto fp = [&output_dir, pp, &func_map, &all_funcs](function* func) {
+		auto fp = [&output_dir, pp, &func_map, &all_funcs](const function* func) {
 			std::string fname = func->get_name();
 			fs::path output_path(output_dir);
 			std::string filename = fname + ".rst";
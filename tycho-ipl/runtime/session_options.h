@@ -36,6 +36,10 @@
 //----------------------------------------------------------------------------
 #include "../image_processing_abi.h"
 #include "../exception.h"
+#include "../context.h"
+#include "../image.h"
+#include "../image_pool.h"
+#include "../result_cache.h"
 
 #include <vector>
 #include <string>
@@ -58,41 +62,39 @@ namespace runtime
 	class invalid_parameter : public runtime_exception
 	{
 	public:
-		explicit invalid_parameter(const char *arg) :
-			m_Arg(arg)
-		{}
+		explicit invalid_parameter(const char *arg)
+		{
+			snprintf(&m_buf[0], m_buf.size(), "Unknown argument '%s'", arg);
+		}
 
 		explicit invalid_parameter(const std::string& arg) :
-			m_Arg(arg)
+			invalid_parameter(arg.c_str())
 		{}
 
 		const char* what() const noexcept override
 		{
-			static std::array<char, 128> buf = { 0 };
-			snprintf(&buf[0], buf.size(), "Unknown argument '%s'", m_Arg.c_str());
-			return buf.data();
+			return m_buf.data();
 		}
 		
 	private:
-		std::string m_Arg;
+		std::array<char, 128> m_buf;
 	};
 
 	class invalid_response_file : public runtime_exception
 	{
 	public:
-		invalid_response_file(const std::string& path) :
-			m_path(path)
-		{}
+		invalid_response_file(const std::string& path)
+		{
+			snprintf(&m_buf[0], m_buf.size(), "Unable to read response file '%s'", path.c_str());
+		}
 
 		const char* what() const noexcept override
 		{
-			static std::array<char, 128> buf = { 0 };
-			sprintf(&buf[0], "Unable to read response file '%s'", m_path.c_str());
-			return buf.data();
+			return m_buf.data();
 		}
 
 	private:
-		std::string m_path;
+		std::array<char, 128> m_buf;
 	};
 
 	//----------------------------------------------------------------------------
@@ -109,7 +111,11 @@ namespace runtime
 			DumpFunctionTableMarkdown,
 			GenerateSphinxDocs,
 			Run,
-			RunExperiment
+			RunExperiment,
+			BenchmarkCodecs,
+			StressTest,
+			StripTest,
+			BenchmarkOverhead
 		};
 
 	public:
@@ -137,11 +143,24 @@ namespace runtime
 		bool		MakeContactSheet = false;
 		bool		LaunchResult = false;
 		file_list    InputFiles;
+		file_list	 TestPrograms;	///< programs run by the self tests
 		std::string PrefilterProgram;
 		std::string SphinxOutputDir;
 		std::string Program;
 		input_map    ProgramInputs;
 		std::string OutputDir;
+		size_t		ImagePoolSize = image_pool::DefaultMaxBytes;
+		size_t		NumThreads = 0;
+		size_t		NumJobs = 1;
+		std::string CacheDir;
+		size_t		CacheSize = result_cache::DefaultMaxBytes;
+		int			CacheMinTime = 0;	///< milliseconds
+		int			StripHeight = context::DefaultStripHeight;
+		bool		CompileNative = false;
+		image_write_options WriteOptions;
+		size_t		NumEncoders = 0;
+		size_t		StressThreads = 0;
+		int			StripTestHeight = 16;
 		action		RunAction = action::Invalid;
 		std::vector<std::string> UnknownOptions;
 	};
@@ -28,6 +28,7 @@
 // Includes
 //----------------------------------------------------------------------------
 #include "simple_runner.h"
+#include "../exception.h"
 #include "../image.h"
 #include "../utils.h"
 
@@ -54,37 +55,94 @@ namespace runtime
 	
 	void simple_runner::run()
 	{
+		struct decoded_image
+		{
+			std::string Path;
+			image_ptr Image;
+			std::exception_ptr Error;
+		};
+
+		struct encoded_image
+		{
+			std::string Path;
+			image_ptr Image;
+		};
+
+		// the next images are read while one is run, and its outputs are 
+		// written while the one after is run
+		bounded_queue<decoded_image> decoded(PipelineDepth);
+		bounded_queue<encoded_image> encoded(PipelineDepth);
+
+		pipeline_stage decoder([&]
+		{
+			for (auto& image_path : get_input_files())
+			{
+				decoded_image item;
+				item.Path = image_path;
+				try
+				{
+					item.Image = load_image(image_path);
+				}
+				catch (...)
+				{
+					item.Error = std::current_exception();
+				}
+
+				if (!decoded.push(std::move(item)))
+					break;
+			}
+			decoded.close();
+		}, [&] { decoded.close(); });
+
+		pipeline_stage encoder([&]
+		{
+			encoded_image item;
+			while (encoded.pop(item))
+			{
+				if (!item.Image->write_to_file(item.Path, get_write_options()))
+					get_output()->error("Failed to write '%s'\n", item.Path.c_str());
+
+				if (launch_result())
+					utils::shell_launch(item.Path.c_str());
+			}
+		}, [&] { encoded.close(); }, get_num_encoders());
+
 		auto program = get_program();
-		for (auto image_path : get_input_files())
+		decoded_image item;
+		while (!encoded.is_closed() && decoded.pop(item))
 		{
-			get_output()->write_ln("Processing : %s", image_path.c_str());
-			image_ptr image = load_image(image_path);
+			get_output()->write_ln("Processing : %s", item.Path.c_str());
+			if (item.Error)
+				std::rethrow_exception(item.Error);
 
-			if (image)
+			if (item.Image)
 			{
 				image_result_list outputs;
-				runner::run(program, image.get(), kv_dict() /* m_Options.ProgramInputs*/, outputs);
+				runner::run(program, item.Image.get(), kv_dict() /* m_Options.ProgramInputs*/, outputs);
+				item.Image.reset();
 
-				// write the outputs to disk
+				// queue the outputs to be written to disk
 				std::string dir, name, ext;
-				utils::get_path_parts(image_path, dir, name, ext);
-				int idx = 0;
+				utils::get_path_parts(item.Path, dir, name, ext);
 				for (auto img : outputs)
 				{
 					std::array<char, 128> dst_path;
 					sprintf(
 						&dst_path[0],
-						"%s_%s.png", name.c_str(), img.Annotation.c_str());
-
-					img.Image->write_to_file(dst_path.data());
-
-					if (launch_result())
-						utils::shell_launch(dst_path.data());
-
-					++idx;
+						"%s_%s%s", name.c_str(), img.Annotation.c_str(), get_write_options().get_extension());
+
+					// the queue is only closed early by a failed encoder
+					if (!encoded.push(encoded_image{ dst_path.data(), img.Image }))
+					{
+						encoder.join();
+						throw image_write_error(dst_path.data());
+					}
 				}
 			}
 		}
+
+		encoded.close();
+		encoder.join();
 	}
 
 	//----------------------------------------------------------------------------
@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "thread_pool.h"
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+
+	thread_pool::thread_pool(size_t num_threads)
+	{
+		if (num_threads == 0)
+			num_threads = std::thread::hardware_concurrency();
+
+		if (num_threads <= 1)
+			return;
+
+		m_Threads.reserve(num_threads);
+		for (size_t i = 0; i < num_threads; ++i)
+			m_Threads.emplace_back(&thread_pool::worker, this);
+	}
+
+	//----------------------------------------------------------------------------
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Quit = true;
+		}
+		m_Signal.notify_all();
+
+		for (auto& t : m_Threads)
+			t.join();
+	}
+
+	//----------------------------------------------------------------------------
+
+	void thread_pool::submit(task t)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Tasks.push_back(std::move(t));
+		}
+		m_Signal.notify_one();
+	}
+
+	//----------------------------------------------------------------------------
+
+	void thread_pool::worker()
+	{
+		for (;;)
+		{
+			task t;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Signal.wait(lock, [this] { return m_Quit || !m_Tasks.empty(); });
+
+				if (m_Tasks.empty())
+					return;
+
+				t = std::move(m_Tasks.front());
+				m_Tasks.pop_front();
+			}
+			t();
+		}
+	}
+
+	//----------------------------------------------------------------------------
+
+} // end namespace
+} // end namespace
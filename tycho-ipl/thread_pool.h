@@ -0,0 +1,96 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef THREAD_POOL_H_2E3C43F3_CD0A_4A69_AF2A_1BB94657C78A
+#define THREAD_POOL_H_2E3C43F3_CD0A_4A69_AF2A_1BB94657C78A
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{   
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// Fixed size pool of worker threads that run submitted tasks in the order
+	// they were submitted. Tasks may submit further tasks.
+	//----------------------------------------------------------------------------
+	class TYCHO_IMAGEPROCESSING_ABI thread_pool
+	{
+	public:
+		using task = std::function<void()>;
+
+	public:
+		/// Constructor. A thread count of 0 uses one thread per hardware thread,
+		/// a count of 1 creates no threads and callers should run work inline.
+		explicit thread_pool(size_t num_threads = 0);
+
+		/// Destructor, waits for queued tasks to complete
+		~thread_pool();
+
+		/// Queue a task to be run on a worker thread
+		void submit(task t);
+
+		/// Number of worker threads
+		size_t get_num_threads() const { return m_Threads.size(); }
+
+	private:
+		void worker();
+
+	private:
+		std::vector<std::thread> m_Threads;
+		std::deque<task>		 m_Tasks;
+		std::mutex				 m_Mutex;
+		std::condition_variable  m_Signal;
+		bool					 m_Quit = false;
+
+		// noncopyable
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // THREAD_POOL_H_2E3C43F3_CD0A_4A69_AF2A_1BB94657C78A
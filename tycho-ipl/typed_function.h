@@ -0,0 +1,206 @@
+//----------------------------------------------------------------------------
+// Image Processing Library
+//
+// MIT License
+// Copyright (c) 2018 Martin A Slater (mslater@hellinc.net)
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//----------------------------------------------------------------------------
+
+
+#ifdef _MSC_VER
+#pragma once
+#endif  // _MSC_VER
+
+#ifndef TYPED_FUNCTION_H_2522CDE3_25A7_447A_9326_91596512BA90
+#define TYPED_FUNCTION_H_2522CDE3_25A7_447A_9326_91596512BA90
+
+//----------------------------------------------------------------------------
+// Includes
+//----------------------------------------------------------------------------
+#include "image_processing_abi.h"
+#include "function.h"
+
+#include <initializer_list>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Class
+//----------------------------------------------------------------------------
+
+namespace tycho
+{
+namespace image_processing
+{
+
+	//----------------------------------------------------------------------------
+	// A function parameter bound to the member of the struct its argument is
+	// read into. The member type must match the declared parameter type.
+	//----------------------------------------------------------------------------
+	template<class Params>
+	struct param_member
+	{
+		param_member(image* Params::* member, const param_desc& desc) : Desc(desc), Image(member) 
+		{ IMAGE_PROC_ASSERT(desc.Type == ObjectType::Image); }
+
+		param_member(int Params::* member, const param_desc& desc) : Desc(desc), Integer(member) 
+		{ IMAGE_PROC_ASSERT(desc.Type == ObjectType::Integer); }
+
+		param_member(float Params::* member, const param_desc& desc) : Desc(desc), Float(member) 
+		{ IMAGE_PROC_ASSERT(desc.Type == ObjectType::Float); }
+
+		param_member(bool Params::* member, const param_desc& desc) : Desc(desc), Boolean(member) 
+		{ IMAGE_PROC_ASSERT(desc.Type == ObjectType::Boolean); }
+
+		param_member(const char* Params::* member, const param_desc& desc) : Desc(desc), String(member) 
+		{ IMAGE_PROC_ASSERT(desc.Type == ObjectType::String || desc.Type == ObjectType::Name); }
+
+		/// Copy an argument to the member, unbound arguments are left as they are
+		void read(const value& val, Params& params) const
+		{
+			switch (val.get_type())
+			{
+			case ObjectType::Image:		params.*Image = const_cast<value&>(val).get_image(); break;
+			case ObjectType::Integer:	params.*Integer = val.get_integer(); break;
+			case ObjectType::Float:		params.*Float = val.get_float(); break;
+			case ObjectType::Boolean:	params.*Boolean = val.get_boolean(); break;
+			case ObjectType::String:	params.*String = val.get_string(); break;
+			case ObjectType::Name:		params.*String = val.get_name(); break;
+			default: break;
+			}
+		}
+
+		/// Copy the member to a result
+		void write(const Params& params, value& val) const
+		{
+			switch (Desc.Type)
+			{
+			case ObjectType::Image:		val.set_image(params.*Image); break;
+			case ObjectType::Integer:	val.set_integer(params.*Integer); break;
+			case ObjectType::Float:		val.set_float(params.*Float); break;
+			case ObjectType::Boolean:	val.set_boolean(params.*Boolean); break;
+			case ObjectType::String:	val.set_string(params.*String); break;
+			case ObjectType::Name:		val.set_name(params.*String); break;
+			default: break;
+			}
+		}
+
+		param_desc Desc;
+		image* Params::* Image = nullptr;
+		int Params::* Integer = nullptr;
+		float Params::* Float = nullptr;
+		bool Params::* Boolean = nullptr;
+		const char* Params::* String = nullptr;
+	};
+
+	//----------------------------------------------------------------------------
+	// The parameters of a function declared once as members of a struct. This 
+	// gives the parameter descriptions used for validation and documentation 
+	// and fills in the struct from arguments indexed in the same order.
+	//----------------------------------------------------------------------------
+	template<class Params>
+	class param_binding
+	{
+	public:
+		/// Constructor
+		param_binding(std::initializer_list<param_member<Params>> inputs,
+			std::initializer_list<param_member<Params>> outputs) :
+			m_Inputs(inputs),
+			m_Outputs(outputs)
+		{
+			for (auto& m : m_Inputs)
+				m_InputDescs.push_back(m.Desc);
+			for (auto& m : m_Outputs)
+				m_OutputDescs.push_back(m.Desc);
+		}
+
+		const param_list& get_inputs() const { return m_InputDescs; }
+		const param_list& get_outputs() const { return m_OutputDescs; }
+
+		/// Fill in params from the arguments and any outputs provided by the executor
+		void read(const value* inputs, const value* outputs, Params& params) const
+		{
+			for (size_t i = 0; i < m_Inputs.size(); ++i)
+				m_Inputs[i].read(inputs[i], params);
+			for (size_t i = 0; i < m_Outputs.size(); ++i)
+				m_Outputs[i].read(outputs[i], params);
+		}
+
+		/// Copy the results from params
+		void write(const Params& params, value* outputs) const
+		{
+			for (size_t i = 0; i < m_Outputs.size(); ++i)
+				m_Outputs[i].write(params, outputs[i]);
+		}
+
+	private:
+		std::vector<param_member<Params>> m_Inputs;
+		std::vector<param_member<Params>> m_Outputs;
+		param_list m_InputDescs;
+		param_list m_OutputDescs;
+	};
+
+	//----------------------------------------------------------------------------
+	// Base class for functions that read their arguments into a struct of type
+	// Params. The executor passes arguments by index so running the function 
+	// doesn't look anything up by name.
+	//----------------------------------------------------------------------------
+	template<class Params>
+	class typed_function : public function
+	{
+	public:
+		using params = Params;
+
+		/// Constructor
+		typed_function(Group group, const char* name, const char* desc,
+			const param_binding<Params>& binding,
+			const declaration_list& constants = declaration_list()) :
+			function(group, name, desc, binding.get_inputs(), binding.get_outputs(), constants),
+			m_Binding(binding)
+		{}
+
+		bool dispatch(context* ctx, const kv_dict& inputs, kv_dict& outputs) const override
+		{
+			return dispatch_indexed(ctx, inputs, outputs);
+		}
+
+		bool invoke(context* ctx, const value* inputs, value* outputs) const override
+		{
+			Params params{};
+			m_Binding.read(inputs, outputs, params);
+			if (!run(ctx, params))
+				return false;
+
+			m_Binding.write(params, outputs);
+			return true;
+		}
+
+	protected:
+		/// Run the function on the arguments in params, results are written 
+		/// to the output members of params.
+		virtual bool run(context* ctx, Params& params) const = 0;
+
+	private:
+		param_binding<Params> m_Binding;
+	};
+
+} // end namespace
+} // end namespace
+
+#endif // TYPED_FUNCTION_H_2522CDE3_25A7_447A_9326_91596512BA90
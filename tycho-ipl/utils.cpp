@@ -30,6 +30,7 @@
 #include "utils.h"
 #include "image.h"
 #include <array>
+#include <atomic>
 #include <ctime>
 #include <time.h>
 #include <sstream>
@@ -38,6 +39,8 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <ShlObj.h>
+#else
+#include <unistd.h>
 #endif // WIN32
 
 #ifdef _MSC_VER
@@ -71,7 +74,7 @@ namespace utils
 	double timer::elapsed() const
 	{
 		auto now = m_clock.now();
-		return (double) std::chrono::duration_cast<std::chrono::seconds>(now - m_startTime).count();
+		return std::chrono::duration<double>(now - m_startTime).count();
 	}
 
 	//----------------------------------------------------------------------------
@@ -163,6 +166,23 @@ namespace utils
 
 	//----------------------------------------------------------------------------
 
+	std::string get_unique_temp_path(const std::string& path)
+	{
+		// the process id separates processes sharing a directory and the 
+		// counter separates the threads of this one
+		static std::atomic<unsigned long long> counter{ 0 };
+#ifdef _WIN32
+		const unsigned long pid = GetCurrentProcessId();
+#else
+		const unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+		char suffix[64];
+		snprintf(suffix, sizeof(suffix), ".%lu-%llu.tmp", pid, counter++);
+		return path + suffix;
+	}
+
+	//----------------------------------------------------------------------------
+
 	std::string get_datetime_now_string()
 	{
 		time_t     now = time(nullptr);
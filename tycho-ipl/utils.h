@@ -153,6 +153,12 @@ namespace utils
 	//----------------------------------------------------------------------------
 	bool create_directories(const std::string& dir);
 
+	//----------------------------------------------------------------------------
+	// Returns a path next to the passed one that no other thread or process 
+	// will use, for writing a file before renaming it into place
+	//----------------------------------------------------------------------------
+	std::string get_unique_temp_path(const std::string& path);
+
 	//----------------------------------------------------------------------------
 	// Returns the current data and time in the format YYYY_MM_DD_HH_MM_SS
 	//----------------------------------------------------------------------------